@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <time.h>
+
+/*
+animation time.
+
+the render thread reads its AnimClock once per frame and hands the same
+frame_time_t to every Update(), so no animation reads a clock itself and
+all of them move by the same dt. motion is written per second of dt rather
+than per Update() call, so it looks the same at any frame rate.
+
+a SimClock only moves when it is advanced. the controller steps it one
+frame period per frame instead of sleeping, so frames render as fast as the
+CPU allows and the same commands give the same frames every run.
+
+to land a command on an exact frame, HoldAt(t) stops the clock before it
+passes t: once Held(), the render thread is parked in pace() with every
+frame up to t rendered, a command queued then is applied by the first
+frame after t. Release() (or a later HoldAt) lets it carry on.
+*/
+
+struct frame_time_t {
+    int64_t now_ns = 0;     //clock time of this frame
+    float dt = 0.f;         //seconds since the previous frame, 0 on the first
+    uint64_t frame = 0;     //frames ticked so far, this one included
+
+    //seconds from since_ns to this frame
+    float Since(int64_t since_ns) const { return static_cast<float>(now_ns - since_ns) * 1e-9f; }
+};
+
+class AnimClock {
+public:
+    virtual ~AnimClock() = default;
+    virtual int64_t Now() = 0;
+    //a simulated clock doesn't run by itself, frame pacing advances it instead of sleeping
+    virtual bool Simulated() const { return false; }
+    virtual void Advance(int64_t ns) { (void)ns; }
+    //wakes anything blocked in Advance(), the controller calls it on shutdown
+    virtual void Release() {}
+};
+
+//CLOCK_MONOTONIC, the default
+class MonotonicClock : public AnimClock {
+public:
+    int64_t Now() override {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+};
+
+class SimClock : public AnimClock {
+public:
+    explicit SimClock(int64_t start_ns = 0) : now(start_ns) {}
+    int64_t Now() override { return now.load(std::memory_order_relaxed); }
+    bool Simulated() const override { return true; }
+    //blocks while the step would pass a hold
+    void Advance(int64_t ns) override {
+        std::unique_lock<std::mutex> lock(mtx);
+        while(now.load(std::memory_order_relaxed) + ns > hold_ns){
+            held = true;
+            cv.notify_all();
+            cv.wait(lock);
+        }
+        held = false;
+        now.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    //Advance() stops short of passing ns until the hold moves or is released
+    void HoldAt(int64_t ns){
+        std::lock_guard<std::mutex> lock(mtx);
+        hold_ns = ns;
+        held = false;   //until Advance() finds itself stopped by the new hold
+        cv.notify_all();
+    }
+    void Release() override { HoldAt(NO_HOLD); }
+    //waits until an Advance() is stopped at the hold, false on timeout
+    template <class Duration>
+    bool WaitHeld(Duration timeout){
+        std::unique_lock<std::mutex> lock(mtx);
+        return cv.wait_for(lock, timeout, [&]{ return held; });
+    }
+
+private:
+    static constexpr int64_t NO_HOLD = std::numeric_limits<int64_t>::max();
+    std::atomic<int64_t> now;
+    std::mutex mtx;     //guards the hold
+    std::condition_variable cv;
+    int64_t hold_ns = NO_HOLD;
+    bool held = false;
+};
+
+//samples a clock into one frame_time_t per frame
+class FrameTicker {
+public:
+    const frame_time_t& Tick(AnimClock& clock){
+        int64_t now = clock.Now();
+        time.dt = time.frame ? static_cast<float>(now - time.now_ns) * 1e-9f : 0.f;
+        time.now_ns = now;
+        time.frame++;
+        return time;
+    }
+    const frame_time_t& Time() const { return time; }
+
+private:
+    frame_time_t time;
+};
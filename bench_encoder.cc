@@ -0,0 +1,81 @@
+#include "ws2812.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// encode throughput of the per-bit reference vs the table driven and SIMD kernels,
+// calibrated frames on the slot tables vs remapped through each kernel, and
+// the dense 4 / 3 bit symbol encodings
+
+template <typename F>
+static double ns_per_frame(F&& encode, int iterations){
+    encode(); // warm up
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i) encode();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(){
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dis(0, 255);
+    const size_t sizes[] = {61, 1000, 10000};
+
+    printf("active kernel: %s\n", ws2812_kernel_name(ws2812_active_kernel()));
+    printf("%8s %10s %14s %10s %10s\n", "leds", "kernel", "ns/frame", "MB/s out", "vs per-bit");
+    for(size_t n : sizes){
+        std::vector<uint8_t> rgb(n * 3);
+        for(auto& b : rgb) b = static_cast<uint8_t>(dis(gen));
+        std::vector<char> tx(n * WS2812B_BYTES_PER_LED);
+        int iterations = static_cast<int>(2000000 / n) + 10;
+        double mb = tx.size() / 1e6;
+
+        double ref = ns_per_frame([&]{
+            for(size_t i = 0; i < n; ++i)
+                encode_color(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], &tx[i * WS2812B_BYTES_PER_LED]);
+            asm volatile("" : : "r"(tx.data()) : "memory");
+        }, iterations);
+        printf("%8zu %10s %14.0f %10.0f %9.2fx\n", n, "per-bit", ref, mb / (ref * 1e-9), 1.0);
+
+        for(int k = 0; k < WS2812_KERNEL_MAX; ++k){
+            auto kernel = static_cast<ws2812_kernel>(k);
+            if(!ws2812_kernel_supported(kernel)) continue;
+            double ns = ns_per_frame([&]{
+                ws2812_encode_with(kernel, rgb.data(), n, tx.data());
+                asm volatile("" : : "r"(tx.data()) : "memory");
+            }, iterations);
+            printf("%8zu %10s %14.0f %10.0f %9.2fx\n", n, ws2812_kernel_name(kernel), ns, mb / (ns * 1e-9), ref / ns);
+        }
+
+        // gamma + brightness + 5 ring gains folded into the tables
+        std::vector<uint8_t> led_slot(n);
+        for(size_t i = 0; i < n; ++i) led_slot[i] = static_cast<uint8_t>(i * 5 / n);
+        const float gains[5] = {1.f, 1.f, 1.f, 1.66f, 0.37f};
+        ws2812_calibration cal = ws2812_build_calibration(2.2f, 0.8f, gains, 5, led_slot.data(), n);
+        // scalar looks up the slot tables, the SIMD kernels remap then expand
+        for(int k = 0; k < WS2812_KERNEL_MAX; ++k){
+            auto kernel = static_cast<ws2812_kernel>(k);
+            if(!ws2812_kernel_supported(kernel)) continue;
+            double ns = ns_per_frame([&]{
+                ws2812_encode_calibrated_with(kernel, cal, rgb.data(), n, tx.data());
+                asm volatile("" : : "r"(tx.data()) : "memory");
+            }, iterations);
+            std::string label = std::string("cal-") + ws2812_kernel_name(kernel);
+            printf("%8zu %10s %14.0f %10.0f %9.2fx\n", n, label.c_str(), ns, mb / (ns * 1e-9), ref / ns);
+        }
+
+        // dense symbols: fewer bytes out, MB/s is the bus stream produced
+        for(int e = WS2812_ENCODING_4BIT; e < WS2812_ENCODING_MAX; ++e){
+            auto enc = static_cast<ws2812_encoding>(e);
+            double dense_mb = ws2812_frame_bytes(enc, n) / 1e6;
+            double ns = ns_per_frame([&]{
+                ws2812_encode_as(enc, rgb.data(), n, tx.data());
+                asm volatile("" : : "r"(tx.data()) : "memory");
+            }, iterations);
+            printf("%8zu %10s %14.0f %10.0f %9.2fx\n", n, ws2812_encoding_params(enc).name, ns, dense_mb / (ns * 1e-9), ref / ns);
+        }
+    }
+    return 0;
+}
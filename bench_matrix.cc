@@ -0,0 +1,46 @@
+#include "ledcontrol.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+// drawing a 3 orb frame of sprites: set_led(polar_t) per LED vs the batch set_leds().
+// no clear between frames, saturating adds cost the same as fresh ones
+
+template <typename F>
+static double ns_per_frame(F&& draw, int iterations){
+    draw(); // warm up, builds the index
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i) draw();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(){
+    const int iterations = 200000;
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> offset(-0.6f, 0.6f);
+    std::vector<animLED> sprite;
+    for(int i = 0; i < 24; ++i)
+        sprite.push_back({ { offset(gen), offset(gen) }, { 40, 10, static_cast<uint8_t>(i * 8) } });
+
+    LEDMatrix matrix;
+    float spin = 0.f;
+    auto origin = [&](int o){ return polar_t{ spin + o * 2.094f, 2.5f + 0.5f * o }; };
+
+    double single = ns_per_frame([&]{
+        spin = std::fmod(spin + 0.0137f, 2.f * M_PI_F);
+        for(int o = 0; o < 3; ++o)
+            for(auto& led : sprite) matrix.set_led(origin(o) + led.origin, led.color);
+    }, iterations);
+
+    double batch = ns_per_frame([&]{
+        spin = std::fmod(spin + 0.0137f, 2.f * M_PI_F);
+        for(int o = 0; o < 3; ++o)
+            matrix.set_leds(origin(o), sprite.data(), sprite.size());
+    }, iterations);
+
+    printf("%-24s %10s\n", "path", "ns/frame");
+    printf("%-24s %10.1f\n", "set_led(polar_t)", single);
+    printf("%-24s %10.1f  (%.2fx)\n", "set_leds(sprite)", batch, single / batch);
+    return 0;
+}
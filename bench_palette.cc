@@ -0,0 +1,53 @@
+#include "palette.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+// per-LED color lookup for a 61 LED frame: float hsv2rgb vs the integer path vs a gradient
+
+template <typename F>
+static double ns_per_frame(F&& draw, int iterations){
+    draw(); // warm up
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i) draw();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(){
+    const int N = 61, iterations = 200000;
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    HSV hsv[N];
+    float t[N];
+    for(int i = 0; i < N; ++i){
+        t[i] = unit(gen);
+        hsv[i] = hsv_lerp({200.f, 0.9f, 1.f}, {330.f, 0.6f, 0.8f}, t[i]);
+    }
+    led_color_t out[N];
+    Gradient ramp({200.f, 0.9f, 1.f}, {330.f, 0.6f, 0.8f}, 1024);
+
+    double exact = ns_per_frame([&]{
+        for(int i = 0; i < N; ++i) out[i] = hsv2rgb(hsv[i]);
+        asm volatile("" : : "r"(out) : "memory");
+    }, iterations);
+    double fast = ns_per_frame([&]{
+        hsv2rgb_batch(hsv, N, out);
+        asm volatile("" : : "r"(out) : "memory");
+    }, iterations);
+    double lerp_exact = ns_per_frame([&]{
+        for(int i = 0; i < N; ++i) out[i] = hsv2rgb(hsv_lerp({200.f, 0.9f, 1.f}, {330.f, 0.6f, 0.8f}, t[i]));
+        asm volatile("" : : "r"(out) : "memory");
+    }, iterations);
+    double lut = ns_per_frame([&]{
+        ramp.Sample(t, N, out);
+        asm volatile("" : : "r"(out) : "memory");
+    }, iterations);
+
+    printf("%-24s %10s %10s\n", "61 LEDs", "ns/frame", "speedup");
+    printf("%-24s %10.0f %9.2fx\n", "hsv2rgb", exact, 1.0);
+    printf("%-24s %10.0f %9.2fx\n", "hsv2rgb_batch (int)", fast, exact / fast);
+    printf("%-24s %10.0f %9.2fx\n", "hsv_lerp + hsv2rgb", lerp_exact, 1.0);
+    printf("%-24s %10.0f %9.2fx\n", "gradient sample", lut, lerp_exact / lut);
+    return 0;
+}
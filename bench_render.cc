@@ -0,0 +1,39 @@
+#include "ledcontrol.h"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// frames per second each state pushes through a NullOutput, no hardware needed.
+// target/paced are the frame clock's rate for the state, missed its late deadlines
+
+int main(){
+    struct { LEDState state; const char* name; } states[] = {
+        {LEDState::ACTIVE, "ACTIVE"},
+        {LEDState::DORMANT, "DORMANT"},
+        {LEDState::RESPOND_TO_USER, "RESPOND_TO_USER"},
+        {LEDState::PROMPT, "PROMPT"},
+        {LEDState::BOOT, "BOOT"},
+        {LEDState::CONNECTING, "CONNECTING"},
+        {LEDState::PLACEHOLDER_TRANSITION, "PLACEHOLDER"},
+    };
+    const auto window = std::chrono::milliseconds(1000);
+
+    LEDController ctrl(std::make_unique<NullOutput>());
+    LEDOutput* out = ctrl.Output();
+
+    printf("%-16s %8s %8s %10s %10s %12s %8s\n", "state", "target", "paced", "frames/s", "skipped/s", "MB/s out", "missed");
+    for(auto& s : states){
+        ctrl.SetState(s.state);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // let the state settle
+        uint64_t f0 = out->Frames(), b0 = out->Bytes(), s0 = ctrl.FrameCounters().skipped;
+        uint64_t p0 = ctrl.FrameStats().frames, m0 = ctrl.FrameStats().missed;
+        auto t0 = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(window);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        FrameClock::stats_t fs = ctrl.FrameStats();
+        printf("%-16s %8.1f %8.1f %10.1f %10.1f %12.2f %8llu\n", s.name, fs.target_fps, (fs.frames - p0) / secs,
+               (out->Frames() - f0) / secs, (ctrl.FrameCounters().skipped - s0) / secs,
+               (out->Bytes() - b0) / secs / 1e6, (unsigned long long)(fs.missed - m0));
+    }
+    return 0;
+}
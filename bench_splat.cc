@@ -0,0 +1,118 @@
+#include "ledcontrol.h"
+#include <chrono>
+#include <cstdio>
+
+// 3 orb Gaussian frame: per-LED angularDifference + exp vs the splat table,
+// blended through led_color_t operators or accumulated in a RenderBuffer
+
+// the per-LED angle difference the states used before the splat tables
+static float angularDifference(float a, float b) {
+    // Normalize angles to [0, 2π) if not already
+    while (a < 0) a += 2.0f * M_PI_F;
+    while (a >= 2.0f * M_PI_F) a -= 2.0f * M_PI_F;
+    while (b < 0) b += 2.0f * M_PI_F;
+    while (b >= 2.0f * M_PI_F) b -= 2.0f * M_PI_F;
+    
+    float d = fabs(a - b);
+    d = fmod(d, 2.0f * M_PI_F);
+    return (d > M_PI_F) ? (2.0f * M_PI_F - d) : d;
+}
+
+template <typename F>
+static double ns_per_frame(F&& draw, int iterations){
+    draw(); // warm up, builds the table
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i) draw();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(){
+    // frame order, like the splat table weights
+    constexpr std::array<polar_t, LED_COUNT> lut = make_led_lut<OrbFixture>();
+
+    const int iterations = 200000;
+    const float sigma = 1.0f, I = 0.7f;
+    const led_color_t base[3] = {{255, 40, 0}, {0, 200, 80}, {30, 60, 255}};
+    std::array<led_color_t, LED_COUNT> leds;
+    float spin = 0.f;
+    auto orb = [&](int o){ return polar_t{ spin + o * 2.094f, 3.f + 0.3f * o }.normalize(); };
+
+    double exact = ns_per_frame([&]{
+        leds.fill({0, 0, 0});
+        spin = std::fmod(spin + 0.0137f, 2.f * M_PI_F);
+        for(int o = 0; o < 3; ++o){
+            polar_t C = orb(o);
+            for(int i = 0; i < LED_COUNT; ++i){
+                polar_t P = lut[i];
+                float dθ = angularDifference(P.theta, C.theta);
+                float r̄ = (P.r + C.r) * 0.5f;
+                float Δr = P.r - C.r;
+                float d2 = (dθ * r̄)*(dθ * r̄) + (Δr * Δr);
+                float F = std::exp(-d2 / (2 * sigma * sigma));
+                leds[i] = leds[i] + base[o] * (I * F);
+            }
+        }
+        asm volatile("" : : "r"(leds.data()) : "memory");
+    }, iterations);
+
+    std::array<float, LED_COUNT> F;
+    double table = ns_per_frame([&]{
+        leds.fill({0, 0, 0});
+        spin = std::fmod(spin + 0.0137f, 2.f * M_PI_F);
+        for(int o = 0; o < 3; ++o){
+            polar_t C = orb(o);
+            orb_splat(sigma).Weights(C.theta, C.r, F.data());
+            for(int i = 0; i < LED_COUNT; ++i)
+                leds[i] = leds[i] + base[o] * (I * F[i]);
+        }
+        asm volatile("" : : "r"(leds.data()) : "memory");
+    }, iterations);
+
+    RenderBuffer<LED_COUNT> canvas;
+    double accumulated = ns_per_frame([&]{
+        canvas.Clear();
+        spin = std::fmod(spin + 0.0137f, 2.f * M_PI_F);
+        for(int o = 0; o < 3; ++o){
+            polar_t C = orb(o);
+            orb_splat(sigma).Weights(C.theta, C.r, F.data());
+            canvas.AddSplat(F.data(), base[o], I);
+        }
+        canvas.Resolve(leds.data());
+        asm volatile("" : : "r"(leds.data()) : "memory");
+    }, iterations);
+
+    // weights alone, without the color blend
+    double weights = ns_per_frame([&]{
+        spin = std::fmod(spin + 0.0137f, 2.f * M_PI_F);
+        for(int o = 0; o < 3; ++o){
+            polar_t C = orb(o);
+            orb_splat(sigma).Weights(C.theta, C.r, F.data());
+            asm volatile("" : : "r"(F.data()) : "memory");
+        }
+    }, iterations);
+
+    double exact_weights = ns_per_frame([&]{
+        spin = std::fmod(spin + 0.0137f, 2.f * M_PI_F);
+        for(int o = 0; o < 3; ++o){
+            polar_t C = orb(o);
+            for(int i = 0; i < LED_COUNT; ++i){
+                polar_t P = lut[i];
+                float dθ = angularDifference(P.theta, C.theta);
+                float r̄ = (P.r + C.r) * 0.5f;
+                float Δr = P.r - C.r;
+                float d2 = (dθ * r̄)*(dθ * r̄) + (Δr * Δr);
+                F[i] = std::exp(-d2 / (2 * sigma * sigma));
+            }
+            asm volatile("" : : "r"(F.data()) : "memory");
+        }
+    }, iterations);
+
+    printf("%-20s %12s %10s\n", "3 orbs x 61 LEDs", "ns/frame", "speedup");
+    printf("%-20s %12.0f %9.2fx\n", "exp + angle diff", exact, 1.0);
+    printf("%-20s %12.0f %9.2fx\n", "splat table", table, exact / table);
+    printf("%-20s %12.0f %9.2fx\n", "splat + float accum", accumulated, exact / accumulated);
+    printf("%-20s %12.0f %9.2fx\n", "weights only, exp", exact_weights, 1.0);
+    printf("%-20s %12.0f %9.2fx\n", "weights only, table", weights, exact_weights / weights);
+    return 0;
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "fixture.h"
+#include "led_output.h"
+#include "ws2812.h"
+
+/*
+.ledcap frame captures, what ledrender writes for diffing builds and for
+feeding other tools.
+
+one fixed size header, then fixed size frame records, little endian, so a
+reader can mmap the file and index frame i directly:
+
+  ledcap_header_t       header_bytes
+  frame 0               frame_bytes
+  frame 1 ...
+
+a frame record is the animation time it shows (int64 ns on the controller's
+anim clock) then the LEDs as they went down the wire: GRB, led_count * 3
+bytes in physical chain order, zero padded to a multiple of 8. the header
+carries the layout (ring sizes, center first, and where each ring starts in
+the frame) so a reader needs nothing from this repo.
+
+frames the controller skips because nothing changed aren't in the file
+either, the timestamps show the gaps. a controller capture starts with the
+power-on off() at time 0 and ends with the shutdown off(), stamped with the
+time of the last frame rendered. frame_count is filled in on Close(),
+a file that never got closed has 0 there and its size gives the count.
+*/
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "ledcap records are written in host order");
+
+constexpr char LEDCAP_MAGIC[8] = {'L', 'E', 'D', 'C', 'A', 'P', '\r', '\n'};
+constexpr uint32_t LEDCAP_VERSION = 1;
+constexpr int LEDCAP_MAX_RINGS = 14;
+
+struct ledcap_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;      //frames start here
+    uint32_t frame_bytes;       //record stride
+    uint32_t led_count;
+    uint32_t ring_count;
+    uint32_t reserved;
+    uint64_t frame_count;       //0 until the writer closes the file
+    uint16_t ring_size[LEDCAP_MAX_RINGS];
+    uint16_t ring_offset[LEDCAP_MAX_RINGS];
+};
+static_assert(sizeof(ledcap_header_t) == 96, "ledcap header layout");
+
+//timestamp + GRB, padded so every record's timestamp stays 8 byte aligned
+constexpr uint32_t ledcap_frame_bytes(uint32_t led_count){ return (8 + led_count * 3 + 7) & ~7u; }
+
+template <class Layout>
+ledcap_header_t ledcap_header(){
+    static_assert(Layout::RINGS <= LEDCAP_MAX_RINGS, "too many rings for a ledcap header");
+    ledcap_header_t h{};
+    memcpy(h.magic, LEDCAP_MAGIC, sizeof(h.magic));
+    h.version = LEDCAP_VERSION;
+    h.header_bytes = sizeof(ledcap_header_t);
+    h.frame_bytes = ledcap_frame_bytes(Layout::LED_COUNT);
+    h.led_count = Layout::LED_COUNT;
+    h.ring_count = Layout::RINGS;
+    for(int r = 0; r < Layout::RINGS; ++r){
+        h.ring_size[r] = static_cast<uint16_t>(Layout::sizes[r]);
+        h.ring_offset[r] = static_cast<uint16_t>(Layout::offsets[r]);
+    }
+    return h;
+}
+
+class CaptureWriter {
+public:
+    ~CaptureWriter(){ Close(); }
+
+    //truncates path and writes the header, layout from ledcap_header<>()
+    bool Open(const std::string& path, const ledcap_header_t& layout){
+        Close();
+        header = layout;
+        header.frame_count = 0;
+        record.assign(header.frame_bytes, 0);
+        f = fopen(path.c_str(), "wb");
+        if(!f){
+            printf("[CaptureWriter] failed to open '%s' - %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+        setvbuf(f, nullptr, _IOFBF, 1 << 16);
+        ok = fwrite(&header, sizeof(header), 1, f) == 1;
+        return ok;
+    }
+    //grb holds led_count * 3 bytes
+    bool Append(int64_t time_ns, const uint8_t* grb){
+        if(!f) return false;
+        memcpy(record.data(), &time_ns, sizeof(time_ns));
+        memcpy(record.data() + sizeof(time_ns), grb, header.led_count * 3);
+        if(fwrite(record.data(), record.size(), 1, f) != 1){
+            ok = false;
+            return false;
+        }
+        header.frame_count++;
+        return true;
+    }
+    //fills in the frame count, false if any write since Open() failed
+    bool Close(){
+        if(!f) return false;
+        ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, f) == 1;
+        ok = fclose(f) == 0 && ok;
+        f = nullptr;
+        return ok;
+    }
+
+    bool IsOpen() const { return f != nullptr; }
+    uint64_t Frames() const { return header.frame_count; }
+    const ledcap_header_t& Header() const { return header; }
+
+private:
+    FILE* f = nullptr;
+    bool ok = false;
+    ledcap_header_t header{};
+    std::vector<uint8_t> record;    //one frame, padding stays zero
+};
+
+//read only view of a capture file, mmapped
+class CaptureReader {
+public:
+    ~CaptureReader(){ Close(); }
+
+    //false if it isn't a capture of this version or is cut short
+    bool Open(const std::string& path){
+        Close();
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0){
+            printf("[CaptureReader] failed to open '%s' - %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+        struct stat st;
+        if(fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ledcap_header_t)){
+            size = static_cast<size_t>(st.st_size);
+            void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(p != MAP_FAILED) data = static_cast<const uint8_t*>(p);
+        }
+        close(fd);
+        if(!data || !validate()){
+            printf("[CaptureReader] '%s' is not a version %u capture\n", path.c_str(), LEDCAP_VERSION);
+            Close();
+            return false;
+        }
+        return true;
+    }
+    void Close(){
+        if(data) munmap(const_cast<uint8_t*>(data), size);
+        data = nullptr;
+        size = 0;
+        frames = 0;
+    }
+
+    const ledcap_header_t& Header() const { return *reinterpret_cast<const ledcap_header_t*>(data); }
+    uint64_t Frames() const { return frames; }
+    int64_t Time(uint64_t i) const {
+        int64_t t;
+        memcpy(&t, record(i), sizeof(t));
+        return t;
+    }
+    //led_count * 3 bytes, GRB in chain order
+    const uint8_t* GRB(uint64_t i) const { return record(i) + sizeof(int64_t); }
+
+private:
+    const uint8_t* record(uint64_t i) const {
+        const ledcap_header_t& h = Header();
+        return data + h.header_bytes + i * h.frame_bytes;
+    }
+    bool validate(){
+        const ledcap_header_t& h = Header();
+        if(memcmp(h.magic, LEDCAP_MAGIC, sizeof(h.magic)) != 0 || h.version != LEDCAP_VERSION) return false;
+        if(h.header_bytes < sizeof(ledcap_header_t) || h.header_bytes > size) return false;
+        if(h.ring_count == 0 || h.ring_count > LEDCAP_MAX_RINGS || h.frame_bytes < ledcap_frame_bytes(h.led_count)) return false;
+        uint64_t fit = (size - h.header_bytes) / h.frame_bytes;
+        if(h.frame_count > fit) return false;
+        frames = h.frame_count ? h.frame_count : fit;
+        return true;
+    }
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    uint64_t frames = 0;
+};
+
+//LEDOutput that decodes each frame back to GRB and appends it to a capture
+//file, stamped with the frame's animation time
+class CaptureFileOutput : public LEDOutput {
+public:
+    CaptureFileOutput(const std::string& path, ws2812_encoding enc = WS2812_ENCODING_8BIT,
+                      const ledcap_header_t& layout = ledcap_header<OrbFixture>())
+        : encoding(enc), rgb(layout.led_count * 3), grb(layout.led_count * 3) {
+        writer.Open(path, layout);
+    }
+
+    bool Ready() const override { return writer.IsOpen(); }
+    //frames from outside the controller carry the last time seen
+    bool Write(const char* buffer, uint32_t len) override { return WriteFrame(buffer, len, last_time); }
+    bool WriteFrame(const char* buffer, uint32_t len, int64_t time_ns) override {
+        last_time = time_ns;
+        if(time_ns > end_ns.load(std::memory_order_relaxed)) return true;
+        if(len != ws2812_frame_bytes(encoding, rgb.size() / 3) || !ws2812_decode(encoding, buffer, len, rgb.data()))
+            return false;
+        for(size_t i = 0; i < rgb.size(); i += 3){
+            grb[i] = rgb[i + 1];
+            grb[i + 1] = rgb[i];
+            grb[i + 2] = rgb[i + 2];
+        }
+        if(!writer.Append(time_ns, grb.data())) return false;
+        count(len);
+        return true;
+    }
+    const char* Name() const override { return "ledcap"; }
+
+    //frames timed after end_ns are accepted but not recorded, so a run cut at
+    //end_ns ends there however far past it the render thread got
+    void SetEnd(int64_t ns){ end_ns.store(ns, std::memory_order_relaxed); }
+    bool Close(){ return writer.Close(); }
+
+private:
+    ws2812_encoding encoding;
+    CaptureWriter writer;
+    std::vector<uint8_t> rgb;
+    std::vector<uint8_t> grb;
+    int64_t last_time = 0;
+    std::atomic<int64_t> end_ns{INT64_MAX};
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// 8-bit LED color and the float HSV conversion, shared by the renderer and
+// the palette tables (palette.h)
+
+struct led_color_t {
+    uint8_t r,g,b;
+
+    led_color_t operator+(const led_color_t& other) const {
+        return { static_cast<uint8_t>(std::min(255, r + other.r)), static_cast<uint8_t>(std::min(255, g + other.g)), static_cast<uint8_t>(std::min(255, b + other.b)) };
+    }
+    led_color_t operator-(const led_color_t& other) const {
+        return { static_cast<uint8_t>(std::max(0, r - other.r)), static_cast<uint8_t>(std::max(0, g - other.g)), static_cast<uint8_t>(std::max(0, b - other.b)) };
+    }
+    led_color_t operator*(float scalar) const {
+
+        return {
+            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, r * scalar))),
+            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, g * scalar))),
+            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, b * scalar)))
+        };
+    }
+    led_color_t operator/(float scalar) const {
+        return {
+            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, r / scalar))),
+            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, g / scalar))),
+            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, b / scalar)))
+        };
+    }
+    bool operator==(const led_color_t& other) const {
+        return r == other.r && g == other.g && b == other.b;
+    }
+
+    bool operator!=(const led_color_t& other) const {
+        return !(*this == other);
+    }
+    bool operator>(const led_color_t& other) const {
+        return r > other.r && g > other.g && b > other.b;
+    }
+    bool operator<(const led_color_t& other) const {
+        return r < other.r && g < other.g && b < other.b;
+    }
+
+    bool operator>=(const led_color_t& other) const {
+        return r >= other.r && g >= other.g && b >= other.b;
+    }
+    bool operator<=(const led_color_t& other) const {
+        return r <= other.r && g <= other.g && b <= other.b;
+    }
+    bool operator<(uint8_t val) const {
+        return r < val && g < val && b < val;
+    }
+    bool operator>(uint8_t val) const {
+        return r > val && g > val && b > val;
+    }
+    bool operator==(uint8_t val) const {
+        return r == val && g == val && b == val;
+    }
+    
+    operator bool() const {
+        return r || g || b;
+    }
+};
+
+struct HSV {
+    float h; // [0,360)
+    float s; // [0,1]
+    float v; // [0,1]
+};
+
+inline led_color_t hsv2rgb(const HSV& hsv) {
+    float H = hsv.h;
+    float S = hsv.s;
+    float V = hsv.v;
+    float C = V * S;
+    float X = C * (1 - std::fabs(fmod(H/60.0f, 2) - 1));
+    float m = V - C;
+
+    float r1, g1, b1;
+    if      (H <  60) { r1 = C; g1 = X; b1 = 0; }
+    else if (H < 120) { r1 = X; g1 = C; b1 = 0; }
+    else if (H < 180) { r1 = 0; g1 = C; b1 = X; }
+    else if (H < 240) { r1 = 0; g1 = X; b1 = C; }
+    else if (H < 300) { r1 = X; g1 = 0; b1 = C; }
+    else              { r1 = C; g1 = 0; b1 = X; }
+
+    uint8_t R = static_cast<uint8_t>(std::round((r1 + m) * 255));
+    uint8_t G = static_cast<uint8_t>(std::round((g1 + m) * 255));
+    uint8_t B = static_cast<uint8_t>(std::round((b1 + m) * 255));
+    return { R, G, B };
+}
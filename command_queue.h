@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+multi producer / single consumer ring of fixed size slots.
+
+used to hand state, palette and parameter commands from any caller thread to
+the render thread. every slot carries a sequence number: a producer claims a
+position with one CAS on head, writes the value and publishes it by bumping
+the slot's sequence, so producers never take a lock or wait on each other and
+the consumer never sees a half written value. push() returns false when the
+ring is full instead of blocking.
+
+the position a value was pushed at is a global sequence number, pop() hands
+it back so the consumer can tell the order commands were issued in.
+*/
+
+template <typename T, size_t N>
+class MpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+public:
+    MpscRing(){
+        for(size_t i = 0; i < N; ++i) slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    //any thread, false if full. position gets the sequence number the value was queued at
+    bool push(const T& value, uint64_t* position = nullptr){
+        size_t pos = head.load(std::memory_order_relaxed);
+        slot_t* slot;
+        while(true){
+            slot = &slots[pos & (N - 1)];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if(dif == 0){
+                if(head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if(dif < 0) return false;  //the consumer hasn't freed this slot yet
+            else pos = head.load(std::memory_order_relaxed);
+        }
+        slot->value = value;
+        slot->seq.store(pos + 1, std::memory_order_release);
+        if(position) *position = pos;
+        return true;
+    }
+    //consumer only, false if empty (or the oldest slot is claimed but not written yet)
+    bool pop(T& value, uint64_t* position = nullptr){
+        size_t t = tail.load(std::memory_order_relaxed);
+        slot_t& slot = slots[t & (N - 1)];
+        if(slot.seq.load(std::memory_order_acquire) != t + 1) return false;
+        value = slot.value;
+        slot.seq.store(t + N, std::memory_order_release);
+        tail.store(t + 1, std::memory_order_release);
+        if(position) *position = t;
+        return true;
+    }
+    //a snapshot, producers may be mid push
+    size_t size() const {
+        size_t t = tail.load(std::memory_order_acquire);
+        size_t h = head.load(std::memory_order_acquire);
+        return h > t ? h - t : 0;
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    struct slot_t {
+        std::atomic<size_t> seq;
+        T value;
+    };
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::array<slot_t, N> slots{};
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "anim_clock.h"
+#include "render_buffer.h"
+
+/*
+layer compositor.
+
+a state's picture is an ordered stack of layers. every layer is an effect
+that renders color (0..255) and coverage (0..1) per LED into a LayerBuffer,
+and the stack blends them bottom to top into one RenderBuffer with each
+layer's BlendMode and opacity. the RenderBuffer is resolved to 8 bits once,
+after the last layer, so stacking never clamps or rounds in between.
+
+an overlay (say a connecting indicator over the dormant glow) is one more
+stack drawn into the same RenderBuffer before the resolve.
+*/
+
+template <size_t N>
+class LayerBuffer {
+public:
+    static constexpr size_t size() { return N; }
+
+    //transparent black
+    void Clear(){
+        std::fill(r, r + N, 0.f);
+        std::fill(g, g + N, 0.f);
+        std::fill(b, b + N, 0.f);
+        std::fill(a, a + N, 0.f);
+    }
+    template <typename C>
+    void Set(size_t i, const C& c, float alpha = 1.f){
+        r[i] = c.r;
+        g[i] = c.g;
+        b[i] = c.b;
+        a[i] = alpha;
+    }
+    template <typename C>
+    void Fill(const C& c, float alpha = 1.f){
+        for(size_t i = 0; i < N; ++i) Set(i, c, alpha);
+    }
+    //color * gain * w[i] at coverage min(1, mix * w[i]); ALPHA blended this
+    //is RenderBuffer::MixSplat
+    template <typename C>
+    void MixSplat(const float* w, const C& c, float gain, float mix){
+        const float cr = c.r * gain, cg = c.g * gain, cb = c.b * gain;
+        for(size_t i = 0; i < N; ++i){
+            r[i] = cr * w[i];
+            g[i] = cg * w[i];
+            b[i] = cb * w[i];
+            a[i] = std::min(1.f, mix * w[i]);
+        }
+    }
+
+    alignas(32) float r[N] = {};
+    alignas(32) float g[N] = {};
+    alignas(32) float b[N] = {};
+    alignas(32) float a[N] = {};
+};
+
+template <size_t N>
+class Layer {
+public:
+    virtual ~Layer() = default;
+    //advance the animation to the frame's time, called once per frame before any layer renders
+    virtual void Update(const frame_time_t& now) { (void)now; }
+    //out starts out transparent black
+    virtual void Render(LayerBuffer<N>& out) = 0;
+};
+
+template <size_t N>
+class Compositor {
+public:
+    struct layer_t {
+        std::unique_ptr<Layer<N>> effect;
+        BlendMode mode;
+        float opacity;
+    };
+
+    //adds a layer on top, returns the effect for callers that keep a handle to it
+    template <typename L>
+    L* Push(std::unique_ptr<L> effect, BlendMode mode = BlendMode::ALPHA, float opacity = 1.f){
+        L* raw = effect.get();
+        layers.push_back({std::move(effect), mode, opacity});
+        return raw;
+    }
+    void Clear(){ layers.clear(); }
+    size_t Size() const { return layers.size(); }
+    bool Empty() const { return layers.empty(); }
+    layer_t& operator[](size_t i){ return layers[i]; }
+    const layer_t& operator[](size_t i) const { return layers[i]; }
+
+    void Update(const frame_time_t& now){
+        for(auto& l : layers) l.effect->Update(now);
+    }
+    //blends every layer over acc, bottom first; scratch holds one layer at a time
+    void Draw(RenderBuffer<N>& acc, LayerBuffer<N>& scratch){
+        for(auto& l : layers){
+            if(l.opacity <= 0.f) continue;
+            scratch.Clear();
+            l.effect->Render(scratch);
+            acc.Blend(scratch.r, scratch.g, scratch.b, scratch.a, l.mode, l.opacity);
+        }
+    }
+
+private:
+    std::vector<layer_t> layers;
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include "ws2812.h"
+
+/*
+fixture geometry as a type.
+
+RingLayout<sizes...> describes a fixture of concentric rings, center first
+(the orb is RingLayout<1, 8, 12, 16, 24>). everything that depends only on
+the geometry is a constexpr member, so the matrix, the polar lookup, the LED
+polar LUT, the splat tables (FixtureRender in ledcontrol.h) and the encoder
+buffer size are generated for each fixture, and several fixtures' geometry
+can be built into one binary. LEDController, its states and its layers are
+still written for OrbFixture; taking the layout there is follow-up work.
+
+the data chain runs from the outer ring inwards: the last ring's LEDs are the
+first in the frame and the center is the last LED. led_ring / led_theta list
+the LEDs center first, led_frame maps each of those entries to its frame
+index, anything drawn into a frame goes through it (or offsets).
+*/
+
+namespace fixture_detail {
+
+template <size_t R>
+constexpr std::array<int, R> ring_offsets(const std::array<int, R>& sizes, int count){
+    std::array<int, R> offsets{};
+    int inner = 0;
+    for(size_t i = 0; i < R; ++i){
+        inner += sizes[i];
+        offsets[i] = count - inner;
+    }
+    return offsets;
+}
+
+template <size_t R>
+constexpr std::array<float, R> ring_incs(const std::array<int, R>& sizes){
+    std::array<float, R> incs{};
+    for(size_t i = 0; i < R; ++i)
+        incs[i] = sizes[i] > 1 ? 360.f / sizes[i] : 0.f;
+    return incs;
+}
+
+//a multiple of 2 * every ring size, so each ring's rounding boundaries fall on
+//a quantum edge, doubled up to at least 1024 steps
+template <size_t R>
+constexpr int angle_steps(const std::array<int, R>& sizes){
+    int steps = 1;
+    for(size_t i = 0; i < R; ++i)
+        if(sizes[i] > 1) steps = std::lcm(steps, 2 * sizes[i]);
+    while(steps < 1024) steps *= 2;
+    return steps;
+}
+
+template <size_t N, size_t R>
+constexpr std::array<uint8_t, N> led_rings(const std::array<int, R>& sizes){
+    std::array<uint8_t, N> rings{};
+    size_t idx = 0;
+    for(size_t ring = 0; ring < R; ++ring)
+        for(int i = 0; i < sizes[ring]; ++i)
+            rings[idx++] = static_cast<uint8_t>(ring);
+    return rings;
+}
+
+template <size_t N, size_t R>
+constexpr std::array<uint8_t, N> led_frames(const std::array<int, R>& sizes, const std::array<int, R>& offsets){
+    std::array<uint8_t, N> frames{};
+    size_t idx = 0;
+    for(size_t ring = 0; ring < R; ++ring)
+        for(int i = 0; i < sizes[ring]; ++i)
+            frames[idx++] = static_cast<uint8_t>(offsets[ring] + i);
+    return frames;
+}
+
+template <size_t N, size_t R>
+constexpr std::array<float, N> led_thetas(const std::array<int, R>& sizes){
+    std::array<float, N> thetas{};
+    size_t idx = 0;
+    for(size_t ring = 0; ring < R; ++ring)
+        for(int i = 0; i < sizes[ring]; ++i)
+            thetas[idx++] = ring == 0 ? 0.f : ((360.f / sizes[ring]) * i) * (static_cast<float>(M_PI) / 180.f);
+    return thetas;
+}
+
+} // namespace fixture_detail
+
+template <int... Sizes>
+struct RingLayout {
+    static_assert(sizeof...(Sizes) >= 1, "a fixture needs at least one ring");
+
+    static constexpr int RINGS = sizeof...(Sizes);
+    static constexpr int LED_COUNT = (Sizes + ...);
+    static constexpr size_t SPI_BYTES = static_cast<size_t>(LED_COUNT) * WS2812B_BYTES_PER_LED;
+
+    static constexpr std::array<int, RINGS> sizes = { Sizes... };
+    //ring 0 is the center: the polar index and LED angles map any angle on it to its one LED
+    static_assert(sizes[0] == 1, "ring 0 must be a single center LED");
+    //degrees between neighbouring LEDs of a ring, 0 for a single LED
+    static constexpr std::array<float, RINGS> incs = fixture_detail::ring_incs(sizes);
+    //first LED of each ring in the physical frame
+    static constexpr std::array<int, RINGS> offsets = fixture_detail::ring_offsets(sizes, LED_COUNT);
+    //angle quanta of the polar lookup
+    static constexpr int ANGLE_STEPS = fixture_detail::angle_steps(sizes);
+
+    //ring and angle (radians) of every LED, center first, ring by ring
+    static constexpr std::array<uint8_t, LED_COUNT> led_ring = fixture_detail::led_rings<LED_COUNT>(sizes);
+    static constexpr std::array<float, LED_COUNT> led_theta = fixture_detail::led_thetas<LED_COUNT>(sizes);
+
+    static_assert(LED_COUNT < 256, "polar lookups store frame indices as uint8_t");
+    //physical frame index of each led_ring / led_theta entry
+    static constexpr std::array<uint8_t, LED_COUNT> led_frame = fixture_detail::led_frames<LED_COUNT>(sizes, offsets);
+};
+
+//the orb: a center LED and rings of 8, 12, 16 and 24
+using OrbFixture = RingLayout<1, 8, 12, 16, 24>;
@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <time.h>
+
+/*
+fixed rate frame pacing against absolute CLOCK_MONOTONIC deadlines.
+
+Wait() sleeps until the next deadline on a fixed grid (start + n * period),
+so time spent rendering and queueing a frame doesn't stretch the period.
+when a frame runs past its deadline:
+  CATCH_UP - the following frames run back to back until the grid is met
+             again (at most MAX_CATCH_UP frames behind, then it resyncs)
+  SKIP     - the missed grid slots are dropped, the next frame waits for
+             the next future deadline
+
+time is read and slept on through a PacingTimer, CLOCK_MONOTONIC unless
+another one is passed in. tests hand it a fake that only moves when told
+to, so every deadline can be checked exactly.
+*/
+
+class PacingTimer {
+public:
+    virtual ~PacingTimer() = default;
+    virtual int64_t Now() = 0;
+    //returns at or after deadline_ns, on the clock Now() reads
+    virtual void SleepUntil(int64_t deadline_ns) = 0;
+};
+
+class MonotonicTimer : public PacingTimer {
+public:
+    int64_t Now() override {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+    void SleepUntil(int64_t deadline_ns) override {
+        timespec ts = { static_cast<time_t>(deadline_ns / 1000000000LL), static_cast<long>(deadline_ns % 1000000000LL) };
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+    }
+};
+
+class FrameClock {
+public:
+    enum class Policy : uint8_t { CATCH_UP, SKIP };
+    static constexpr int64_t MAX_CATCH_UP = 4;
+
+    struct stats_t {
+        float target_fps;
+        float actual_fps;       //measured over the last second
+        uint64_t frames;
+        uint64_t missed;        //deadlines that had already passed when Wait() was called
+        uint64_t skipped;       //grid slots dropped by SKIP or by a CATCH_UP resync
+        int64_t max_late_ns;    //worst lateness seen
+    };
+
+    //timer isn't owned and has to outlive the clock, nullptr is CLOCK_MONOTONIC
+    FrameClock(float fps = 100.f, Policy policy = Policy::SKIP, PacingTimer* timer = nullptr)
+        : policy(policy), timer(timer ? timer : &monotonic()) {
+        SetTargetFPS(fps);
+    }
+
+    //restarts the grid at the next Wait(), only call from the pacing thread
+    void SetTargetFPS(float fps){
+        if(fps <= 0.f) fps = 1.f;
+        period_ns = static_cast<int64_t>(1e9 / fps);
+        target_fps.store(fps, std::memory_order_relaxed);
+        on_grid = false;
+    }
+    float TargetFPS() const { return target_fps.load(std::memory_order_relaxed); }
+    void SetPolicy(Policy p){ policy.store(p, std::memory_order_relaxed); }
+
+    void Wait(){
+        int64_t now = timer->Now();
+        if(!on_grid){
+            //first frame on a new grid runs straight away and opens the fps window
+            on_grid = true;
+            next_deadline = now + period_ns;
+            window_start = now;
+            window_frames = 0;
+            frames.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if(now > next_deadline){
+            missed.fetch_add(1, std::memory_order_relaxed);
+            int64_t late = now - next_deadline;
+            if(late > max_late_ns.load(std::memory_order_relaxed))
+                max_late_ns.store(late, std::memory_order_relaxed);
+
+            //grid slots already in the past
+            int64_t behind = late / period_ns + 1;
+            if(policy.load(std::memory_order_relaxed) == Policy::SKIP || behind > MAX_CATCH_UP){
+                skipped.fetch_add(behind, std::memory_order_relaxed);
+                next_deadline += behind * period_ns;
+                timer->SleepUntil(next_deadline);
+            }
+            //CATCH_UP within bounds: run now, next deadline stays on the grid
+        }
+        else timer->SleepUntil(next_deadline);
+        next_deadline += period_ns;
+        count_frame(timer->Now());
+    }
+
+    stats_t Stats() const {
+        return {
+            target_fps.load(std::memory_order_relaxed), actual_fps.load(std::memory_order_relaxed),
+            frames.load(std::memory_order_relaxed), missed.load(std::memory_order_relaxed),
+            skipped.load(std::memory_order_relaxed), max_late_ns.load(std::memory_order_relaxed)
+        };
+    }
+
+private:
+    static PacingTimer& monotonic(){
+        static MonotonicTimer timer;
+        return timer;
+    }
+    void count_frame(int64_t now){
+        frames.fetch_add(1, std::memory_order_relaxed);
+        window_frames++;
+        if(now - window_start >= 1000000000LL){
+            actual_fps.store(window_frames * 1e9f / static_cast<float>(now - window_start), std::memory_order_relaxed);
+            window_start = now;
+            window_frames = 0;
+        }
+    }
+
+    std::atomic<Policy> policy;
+    PacingTimer* timer;
+    int64_t period_ns = 0;
+    bool on_grid = false;
+    int64_t next_deadline = 0;
+    int64_t window_start = 0;
+    uint32_t window_frames = 0;
+
+    std::atomic<float> target_fps{0.f};
+    std::atomic<float> actual_fps{0.f};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> missed{0};
+    std::atomic<uint64_t> skipped{0};
+    std::atomic<int64_t> max_late_ns{0};
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+single producer / single consumer ring of fixed size slots.
+
+used to hand finished frames from the render thread to the output thread.
+push() and pop() never block or allocate, the caller decides what to do when
+the ring is full (wait, or hand the frame to a LatestSlot instead).
+*/
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+public:
+    //producer side, false if full
+    bool push(const T& value){
+        size_t h = head.load(std::memory_order_relaxed);
+        if(h - tail.load(std::memory_order_acquire) == N) return false;
+        slots[h & (N - 1)] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    //consumer side, false if empty
+    bool pop(T& value){
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(head.load(std::memory_order_acquire) == t) return false;
+        value = slots[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    //exact from either side's own thread, a snapshot from anywhere else
+    size_t size() const {
+        size_t t = tail.load(std::memory_order_acquire);
+        return head.load(std::memory_order_acquire) - t;
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::array<T, N> slots{};
+};
+
+/*
+single producer / single consumer newest-value handoff, a triple buffer.
+
+publish() never waits: it overwrites whatever the consumer hasn't taken yet,
+so take() always gets the newest value published. the producer writes one
+slot, the consumer reads another and the third sits between them; the two
+swap their slot with the middle one, which is the only shared state.
+*/
+
+template <typename T>
+class LatestSlot {
+public:
+    //producer side, true if it replaced a value the consumer never took
+    bool publish(const T& value){
+        slots[back] = value;
+        uint8_t prev = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel);
+        back = prev & INDEX;
+        return prev & FRESH;
+    }
+    //consumer side, false if nothing was published since the last take()
+    bool take(T& value){
+        if(!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        uint8_t prev = middle.exchange(front, std::memory_order_acq_rel);
+        front = prev & INDEX;
+        value = slots[front];
+        return true;
+    }
+    //a snapshot from anywhere
+    bool fresh() const { return middle.load(std::memory_order_acquire) & FRESH; }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;
+    std::array<T, 3> slots{};
+    alignas(64) std::atomic<uint8_t> middle{2};     //slot index, FRESH if not taken yet
+    alignas(64) uint8_t back = 0;                   //producer's slot
+    alignas(64) uint8_t front = 1;                  //consumer's slot
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <time.h>
+
+/*
+per stage frame timing.
+
+every stage of a frame (animation update, draw/splat, compose, encode, SPI
+transfer) records its time into its own LatencyHistogram. recording is a
+couple of relaxed atomic adds, so the render and output threads write into
+the same histograms without locks and a snapshot can be taken from anywhere.
+
+buckets are log-linear: exact below 16 ns, then 8 linear steps per power of
+two, so any percentile is within 12.5% of the real value. max is exact.
+*/
+
+enum class FrameStage : uint8_t {
+    UPDATE,     //animation state (Update() calls, orb motion)
+    DRAW,       //splats, matrix draws, per LED math
+    COMPOSE,    //resolve / clear / framebuffer copies and queueing the frame
+    ENCODE,     //WS2812 symbol encoding
+    TRANSFER,   //LEDOutput::Write
+    COUNT
+};
+
+inline const char* frame_stage_name(FrameStage stage){
+    static const char* names[] = {"update", "draw", "compose", "encode", "transfer"};
+    return stage < FrameStage::COUNT ? names[static_cast<int>(stage)] : "?";
+}
+
+class LatencyHistogram {
+public:
+    static constexpr int LINEAR = 16;
+    static constexpr int SUB_BITS = 3;
+    static constexpr int BUCKETS = LINEAR + (64 - 4) * (1 << SUB_BITS);
+
+    struct summary_t {
+        uint64_t count;
+        int64_t p50_ns;
+        int64_t p99_ns;
+        int64_t max_ns;
+        double mean_ns;
+    };
+
+    void Record(int64_t ns){
+        if(ns < 0) ns = 0;
+        buckets[bucket(static_cast<uint64_t>(ns))].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum_ns.fetch_add(static_cast<uint64_t>(ns), std::memory_order_relaxed);
+        int64_t max = max_ns.load(std::memory_order_relaxed);
+        while(ns > max && !max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+    }
+
+    //ns at or below which a fraction q of the samples fall (bucket upper bound, capped at max)
+    int64_t Percentile(double q) const {
+        uint64_t total = 0;
+        std::array<uint64_t, BUCKETS> snap;
+        for(int i = 0; i < BUCKETS; ++i) total += (snap[i] = buckets[i].load(std::memory_order_relaxed));
+        if(total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+        if(rank < 1) rank = 1;
+        uint64_t seen = 0;
+        int64_t max = max_ns.load(std::memory_order_relaxed);
+        for(int i = 0; i < BUCKETS; ++i){
+            seen += snap[i];
+            if(seen >= rank){
+                int64_t upper = static_cast<int64_t>(bucket_upper(i));
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+
+    summary_t Summary() const {
+        uint64_t n = count.load(std::memory_order_relaxed);
+        return { n, Percentile(0.5), Percentile(0.99), max_ns.load(std::memory_order_relaxed),
+                 n ? static_cast<double>(sum_ns.load(std::memory_order_relaxed)) / n : 0.0 };
+    }
+
+    //not atomic as a whole, samples racing a reset may land on either side
+    void Reset(){
+        for(auto& b : buckets) b.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        sum_ns.store(0, std::memory_order_relaxed);
+        max_ns.store(0, std::memory_order_relaxed);
+    }
+
+    static int bucket(uint64_t ns){
+        if(ns < LINEAR) return static_cast<int>(ns);
+        int e = 63 - __builtin_clzll(ns);  //>= 4
+        int sub = static_cast<int>((ns >> (e - SUB_BITS)) & ((1 << SUB_BITS) - 1));
+        return LINEAR + (e - 4) * (1 << SUB_BITS) + sub;
+    }
+    //largest ns that lands in bucket i
+    static uint64_t bucket_upper(int i){
+        if(i < LINEAR) return static_cast<uint64_t>(i);
+        int e = (i - LINEAR) / (1 << SUB_BITS) + 4;
+        int sub = (i - LINEAR) % (1 << SUB_BITS);
+        uint64_t step = 1ull << (e - SUB_BITS);
+        return (1ull << e) + (sub + 1) * step - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum_ns{0};
+    std::atomic<int64_t> max_ns{0};
+};
+
+class StageStats {
+public:
+    using summary_t = LatencyHistogram::summary_t;
+    static constexpr int STAGES = static_cast<int>(FrameStage::COUNT);
+
+    void Record(FrameStage stage, int64_t ns){ stages[static_cast<int>(stage)].Record(ns); }
+    summary_t Summary(FrameStage stage) const { return stages[static_cast<int>(stage)].Summary(); }
+    std::array<summary_t, STAGES> Snapshot() const {
+        std::array<summary_t, STAGES> out;
+        for(int i = 0; i < STAGES; ++i) out[i] = stages[i].Summary();
+        return out;
+    }
+    void Reset(){
+        for(auto& s : stages) s.Reset();
+    }
+
+    static int64_t now_ns(){
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+private:
+    std::array<LatencyHistogram, STAGES> stages;
+};
+
+/*
+times the stages of one frame on the render thread. Lap(stage) charges the
+time since the previous lap to that stage, Finish() records each stage the
+frame touched once, as its total for the frame.
+*/
+class StageTimer {
+public:
+    explicit StageTimer(StageStats& stats) : stats(stats) {}
+
+    void Start(){
+        acc.fill(-1);
+        last = StageStats::now_ns();
+        running = true;
+    }
+    void Lap(FrameStage stage){
+        if(!running) return;
+        int64_t now = StageStats::now_ns();
+        int64_t& a = acc[static_cast<int>(stage)];
+        a = (a < 0 ? 0 : a) + (now - last);
+        last = now;
+    }
+    //time since the last lap goes to rest
+    void Finish(FrameStage rest = FrameStage::DRAW){
+        if(!running) return;
+        Lap(rest);
+        running = false;
+        for(int i = 0; i < StageStats::STAGES; ++i)
+            if(acc[i] >= 0) stats.Record(static_cast<FrameStage>(i), acc[i]);
+    }
+    bool Running() const { return running; }
+
+private:
+    StageStats& stats;
+    std::array<int64_t, StageStats::STAGES> acc{};
+    int64_t last = 0;
+    bool running = false;
+};
+
+//one line per stage, "stage count p50_us p99_us max_us mean_us"
+inline void write_stage_stats(FILE* f, const std::array<LatencyHistogram::summary_t, StageStats::STAGES>& stages){
+    fprintf(f, "# stage count p50_us p99_us max_us mean_us\n");
+    for(int i = 0; i < StageStats::STAGES; ++i){
+        const auto& s = stages[i];
+        fprintf(f, "%s %llu %.1f %.1f %.1f %.1f\n", frame_stage_name(static_cast<FrameStage>(i)),
+                (unsigned long long)s.count, s.p50_ns / 1e3, s.p99_ns / 1e3, s.max_ns / 1e3, s.mean_ns / 1e3);
+    }
+}
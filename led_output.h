@@ -0,0 +1,294 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "spi.h"
+#include "ws2812.h"
+
+/*
+where encoded frames go.
+
+LEDController hands every encoded frame (the WS2812 SPI byte stream) to one
+LEDOutput. the spidev backend is what runs on the orin, the others let the
+controller run on any linux box:
+  NullOutput    - drops frames, counts them (throughput benchmarks)
+  CaptureOutput - keeps frames in memory (tests)
+  FileOutput    - appends frames to a file or feeds a FIFO
+  SegmentedOutput - splits one frame across several outputs (one per bus)
+*/
+
+class LEDOutput {
+public:
+    virtual ~LEDOutput() = default;
+    //false if the backend failed to open, controller won't start its loop
+    virtual bool Ready() const = 0;
+    virtual bool Write(const char* buffer, uint32_t len) = 0;
+    //the controller's entry point: a frame and the animation time it shows
+    //(anim_clock.h). backends that record time override it, the rest just Write()
+    virtual bool WriteFrame(const char* buffer, uint32_t len, int64_t time_ns){
+        (void)time_ns;
+        return Write(buffer, len);
+    }
+    virtual const char* Name() const = 0;
+
+    uint64_t Frames() const { return frames.load(std::memory_order_relaxed); }
+    uint64_t Bytes() const { return bytes.load(std::memory_order_relaxed); }
+protected:
+    void count(uint32_t len){
+        frames.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(len, std::memory_order_relaxed);
+    }
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+class SpiOutput : public LEDOutput {
+public:
+    SpiOutput(uint32_t speed, const std::string& dev = SPI_DEV, bool lsb_first = SPI_USE_LSB_FIRST)
+        : spi(speed, dev.c_str(), lsb_first) {}
+    //clock and bit order for one of the ws2812 symbol encodings
+    SpiOutput(ws2812_encoding encoding, const std::string& dev = SPI_DEV)
+        : SpiOutput(ws2812_encoding_params(encoding).spi_speed, dev, ws2812_encoding_params(encoding).lsb_first) {}
+
+    bool Ready() const override { return spi.state == SPI_OPEN; }
+    bool Write(const char* buffer, uint32_t len) override {
+        if(!spi.transfer(buffer, len)) return false;
+        count(len);
+        return true;
+    }
+    const char* Name() const override { return "spidev"; }
+private:
+    spi_t spi;
+};
+
+class NullOutput : public LEDOutput {
+public:
+    bool Ready() const override { return true; }
+    bool Write(const char*, uint32_t len) override { count(len); return true; }
+    const char* Name() const override { return "null"; }
+};
+
+class CaptureOutput : public LEDOutput {
+public:
+    //keeps at most max_frames, oldest are dropped first (0 = unbounded)
+    CaptureOutput(size_t max_frames = 0) : max_frames(max_frames) {}
+
+    bool Ready() const override { return true; }
+    bool Write(const char* buffer, uint32_t len) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(max_frames && captured.size() >= max_frames)
+            captured.erase(captured.begin());
+        captured.emplace_back(buffer, buffer + len);
+        count(len);
+        return true;
+    }
+    const char* Name() const override { return "capture"; }
+
+    std::vector<std::vector<char>> Captured() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return captured;
+    }
+    void Clear(){
+        std::lock_guard<std::mutex> lock(mtx);
+        captured.clear();
+    }
+private:
+    size_t max_frames;
+    mutable std::mutex mtx;
+    std::vector<std::vector<char>> captured;
+};
+
+class FileOutput : public LEDOutput {
+public:
+    //regular files are truncated and get frames appended back to back.
+    //FIFOs are opened non-blocking: no reader or a full pipe drops the frame
+    FileOutput(const std::string& path) : path(path) {
+        struct stat st;
+        if(stat(path.c_str(), &st) == 0 && S_ISFIFO(st.st_mode)){
+            is_fifo = true;
+            //O_RDWR so open() doesn't wait for a reader
+            fd = open(path.c_str(), O_RDWR | O_NONBLOCK);
+        }
+        else fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) printf("[FileOutput] failed to open '%s' - %s\n", path.c_str(), strerror(errno));
+    }
+    ~FileOutput(){
+        if(fd >= 0) close(fd);
+    }
+
+    bool Ready() const override { return fd >= 0; }
+    bool Write(const char* buffer, uint32_t len) override {
+        if(fd < 0) return false;
+        uint32_t done = 0;
+        while(done < len){
+            ssize_t n = write(fd, buffer + done, len - done);
+            if(n < 0){
+                if(errno == EINTR) continue;
+                if(is_fifo && errno == EAGAIN && done == 0){
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                //a partial frame already went into the pipe, finish it
+                if(is_fifo && errno == EAGAIN){ usleep(100); continue; }
+                printf("[FileOutput] write to '%s' failed - %s\n", path.c_str(), strerror(errno));
+                return false;
+            }
+            done += static_cast<uint32_t>(n);
+        }
+        count(len);
+        return true;
+    }
+    const char* Name() const override { return is_fifo ? "fifo" : "file"; }
+
+    uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+private:
+    std::string path;
+    int fd = -1;
+    bool is_fifo = false;
+    std::atomic<uint64_t> dropped{0};
+};
+
+/*
+one logical frame driven over several buses at once.
+
+each segment maps a range of LEDs of the frame onto its own output, and every
+output gets its own transfer thread. Write() starts all of them together and
+returns once every bus is done, so the next frame never overlaps this one.
+
+WS2812 strips latch once their data line has been low for a while after the
+last bit. with sync_latch each segment is right-aligned in a transfer as long
+as the longest segment, the front padded with zero bytes (line held low), so
+all buses finish their data - and latch - at the same moment.
+*/
+struct led_segment_t {
+    std::unique_ptr<LEDOutput> out;
+    size_t first_led;
+    size_t count;
+};
+
+class SegmentedOutput : public LEDOutput {
+public:
+    //bytes_per_led follows the frame's ws2812 encoding
+    SegmentedOutput(std::vector<led_segment_t> segs, bool sync_latch = true,
+                    size_t bytes_per_led = WS2812B_BYTES_PER_LED) : bytes_per_led(bytes_per_led) {
+        size_t longest = 0;
+        for(auto& s : segs) longest = std::max(longest, s.count * bytes_per_led);
+        for(auto& s : segs){
+            auto w = std::make_unique<worker_t>();
+            w->seg = std::move(s);
+            w->len = sync_latch ? longest : w->seg.count * bytes_per_led;
+            w->buffer.assign(w->len, 0);
+            workers.push_back(std::move(w));
+        }
+        for(auto& w : workers)
+            w->thread = std::thread(&SegmentedOutput::run_worker, this, w.get());
+    }
+    ~SegmentedOutput(){
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        start_cv.notify_all();
+        for(auto& w : workers)
+            if(w->thread.joinable()) w->thread.join();
+    }
+
+    bool Ready() const override {
+        if(workers.empty()) return false;
+        for(auto& w : workers)
+            if(!w->seg.out || !w->seg.out->Ready()) return false;
+        return true;
+    }
+    //len must cover every segment, false if it doesn't or any bus failed
+    bool Write(const char* buffer, uint32_t len) override {
+        for(auto& w : workers)
+            if((w->seg.first_led + w->seg.count) * bytes_per_led > len) return false;
+
+        std::unique_lock<std::mutex> lock(mtx);
+        frame = buffer;
+        pending = workers.size();
+        failed = false;
+        first_done = last_done = 0;
+        generation++;
+        start_cv.notify_all();
+        done_cv.wait(lock, [this]{ return pending == 0; });
+        frame = nullptr;
+
+        int64_t skew = last_done - first_done;
+        if(skew > max_skew_ns.load(std::memory_order_relaxed))
+            max_skew_ns.store(skew, std::memory_order_relaxed);
+        if(failed) return false;
+        count(len);
+        return true;
+    }
+    const char* Name() const override { return "segmented"; }
+
+    size_t Segments() const { return workers.size(); }
+    const LEDOutput& Segment(size_t i) const { return *workers[i]->seg.out; }
+    //widest spread between the first and the last bus finishing a frame
+    int64_t MaxSkewNs() const { return max_skew_ns.load(std::memory_order_relaxed); }
+
+private:
+    struct worker_t {
+        led_segment_t seg;
+        size_t len = 0;
+        std::vector<char> buffer;  //padding at the front stays zero
+        std::thread thread;
+    };
+
+    static int64_t now_ns(){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void run_worker(worker_t* w){
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mtx);
+        while(true){
+            start_cv.wait(lock, [&]{ return stop || generation != seen; });
+            if(stop) return;
+            seen = generation;
+            const char* src = frame + w->seg.first_led * bytes_per_led;
+            lock.unlock();
+
+            size_t bytes = w->seg.count * bytes_per_led;
+            memcpy(w->buffer.data() + (w->len - bytes), src, bytes);
+            bool ok = w->seg.out->Write(w->buffer.data(), static_cast<uint32_t>(w->len));
+            int64_t t = now_ns();
+
+            lock.lock();
+            if(!ok) failed = true;
+            if(!first_done) first_done = t;
+            last_done = t;
+            if(--pending == 0) done_cv.notify_one();
+        }
+    }
+
+    const size_t bytes_per_led;
+    std::vector<std::unique_ptr<worker_t>> workers;
+
+    std::mutex mtx;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    uint64_t generation = 0;
+    const char* frame = nullptr;
+    size_t pending = 0;
+    bool failed = false;
+    bool stop = false;
+    int64_t first_done = 0;
+    int64_t last_done = 0;
+    std::atomic<int64_t> max_skew_ns{0};
+};
@@ -1,5 +1,3 @@
-#ifdef __aarch64__
-
 #include "ledcontrol.h"
 #include <random>
 #include <exception>
@@ -31,24 +29,297 @@ led_color_t generate_random_color() {
     return {r,g,b};
 }
 
-using LEDArray = std::array<led_color_t, LED_COUNT>;
+int LEDController::state_slot(LEDState s){
+    return __builtin_ctz(static_cast<unsigned>(s)) % STATE_SLOTS;
+}
+
+bool LEDController::queue_command(command_t cmd){
+    cmd.queued_ns = StageStats::now_ns();
+    if(!commands.push(cmd)){
+        commands_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    commands_queued.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool LEDController::SetState(LEDState s){
+    command_t cmd{};
+    cmd.type = command_t::Type::SET_STATE;
+    cmd.state = s;
+    return queue_command(cmd);
+}
+
+bool LEDController::RequestState(LEDState newState, const std::array<HSV,3>& targetHSV){
+    command_t cmd{};
+    cmd.type = command_t::Type::REQUEST_STATE;
+    cmd.state = newState;
+    cmd.hsv = targetHSV;
+    return queue_command(cmd);
+}
+
+void LEDController::apply_commands(){
+    std::optional<LEDState> set;
+    int64_t set_queued = 0;
+    std::optional<command_t> request;
+    std::optional<led_color_t> color;
+    std::optional<uint8_t> overlay_mask;
+    std::array<int64_t, COMMAND_SLOTS> queued;
+    size_t n = 0;
+    uint64_t coalesced = 0;
+    command_t cmd;
+    //commands come off in the order they were queued, fold them into the last of each kind
+    while(n < COMMAND_SLOTS && commands.pop(cmd)){
+        queued[n++] = cmd.queued_ns;
+        switch(cmd.type){
+        case command_t::Type::SET_STATE:
+            coalesced += set.has_value() + request.has_value();
+            set = cmd.state;
+            set_queued = cmd.queued_ns;
+            request.reset();
+            break;
+        case command_t::Type::REQUEST_STATE:
+            coalesced += request.has_value();
+            request = cmd;
+            break;
+        case command_t::Type::PLACEHOLDER_COLOR:
+            coalesced += color.has_value();
+            color = cmd.color;
+            break;
+        case command_t::Type::OVERLAY: {
+            coalesced += overlay_mask.has_value();
+            uint8_t bit = 1u << state_slot(cmd.state);
+            overlay_mask = cmd.on ? (overlay_mask.value_or(overlays) | bit) : (overlay_mask.value_or(overlays) & ~bit);
+            break;
+        }
+        }
+    }
+    if(n == 0) return;
+
+    int64_t now = StageStats::now_ns();
+    if(set){
+        //a direct state change cuts an in-flight transition short where it stands
+        if(transition){
+            currentHSV = transition->Current();
+            transition = nullptr;
+            transitions_cut.fetch_add(1, std::memory_order_relaxed);
+        }
+        pendingNextState.reset();
+        state.store(*set, std::memory_order_relaxed);
+        state_latency.Record(now - set_queued);
+    }
+    if(request){
+        //an in-flight transition turns towards the new palette from the colours it shows now
+        if(transition){
+            transition->Retarget(request->hsv);
+            transitions_retargeted.fetch_add(1, std::memory_order_relaxed);
+        }
+        pendingNextState = request->state;
+        nextHSV = request->hsv;
+        state_latency.Record(now - request->queued_ns);
+    }
+    if(color) placeholder_layer->SetColor(*color);
+    if(overlay_mask) overlays = *overlay_mask;
+
+    for(size_t i = 0; i < n; ++i) command_latency.Record(now - queued[i]);
+    commands_applied.fetch_add(n, std::memory_order_relaxed);
+    commands_coalesced.fetch_add(coalesced, std::memory_order_relaxed);
+}
+
+void LEDController::SetStateFPS(LEDState s, float fps){
+    state_fps[state_slot(s)].store(fps, std::memory_order_relaxed);
+}
+
+float LEDController::StateFPS(LEDState s) const {
+    return state_fps[state_slot(s)].load(std::memory_order_relaxed);
+}
+
+void LEDController::pace(float fps){
+    //a simulated clock is stepped a frame period instead of waited on
+    if(anim_clock->Simulated()){
+        anim_clock->Advance(static_cast<int64_t>(1e9 / (fps > 0.f ? fps : 1.f)));
+        return;
+    }
+    if(fps != frame_clock.TargetFPS())
+        frame_clock.SetTargetFPS(fps);
+    frame_clock.Wait();
+}
+
+void LEDController::publish_calibration(){
+    //slots are rings, at their physical frame offsets
+    uint8_t led_slot[LED_COUNT];
+    for(int ring = 0; ring < 5; ++ring)
+        for(int i = 0; i < ring_sizes[ring]; ++i)
+            led_slot[ring_offset(ring) + i] = static_cast<uint8_t>(ring);
+    auto cal = std::make_shared<const ws2812_calibration>(
+        ws2812_build_calibration(gamma, brightness, ring_gain.data(), ring_gain.size(), led_slot, LED_COUNT));
+    std::atomic_store(&calibration, std::move(cal));
+    output_cv.notify_one();
+}
+
+void LEDController::SetBrightness(float b){
+    std::lock_guard<std::mutex> lock(calib_mtx);
+    brightness = std::min(std::max(b, 0.f), 1.f);
+    publish_calibration();
+}
+
+float LEDController::Brightness(){
+    std::lock_guard<std::mutex> lock(calib_mtx);
+    return brightness;
+}
+
+void LEDController::SetGamma(float g){
+    std::lock_guard<std::mutex> lock(calib_mtx);
+    gamma = g > 0.f ? g : 1.f;
+    publish_calibration();
+}
+
+void LEDController::SetRingGain(int ring, float gain){
+    if(ring < 0 || ring >= static_cast<int>(ring_gain.size())) throw std::out_of_range("ring index out of range");
+    std::lock_guard<std::mutex> lock(calib_mtx);
+    ring_gain[ring] = std::max(gain, 0.f);
+    publish_calibration();
+}
 
-void LEDController::buildLUT() {
-    int idx = 0;
-    for(int ring = 0; ring < 5; ++ring) {
-        int count = ring_sizes[ring];
-        for(int i = 0; i < count; ++i) {
-            float theta = (ring == 0)
-                        ? 0.0f
-                        : DEG2RAD((360.0f / count) * i);
-            led_lut[idx++] = polar_t{ theta, static_cast<float>(ring) };
+void LEDController::update_leds(){
+    if(have_last_queued && memcmp(leds.data(), last_queued.data(), sizeof(LEDArray)) == 0){
+        frames_skipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if(!output_running.load(std::memory_order_acquire)){
+        //before start / after shutdown there is no output thread, send from here
+        transmit(leds, ticker.Time().now_ns);
+        last_queued = leds;
+        have_last_queued = true;
+        return;
+    }
+    if(output_policy.load(std::memory_order_relaxed) == OutputPolicy::LATEST_WINS){
+        //never waits, a frame the output thread hasn't taken yet is replaced
+        if(latest_frame.publish({leds, ticker.Time().now_ns}))
+            frames_dropped.fetch_add(1, std::memory_order_relaxed);
+        last_queued = leds;
+        have_last_queued = true;
+        output_cv.notify_one();
+        return;
+    }
+    while(!frame_queue.push({leds, ticker.Time().now_ns}))
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    last_queued = leds;
+    have_last_queued = true;
+
+    size_t depth = frame_queue.size();
+    size_t max_depth = max_queue_depth.load(std::memory_order_relaxed);
+    while(depth > max_depth && !max_queue_depth.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)) {}
+    output_cv.notify_one();
+}
+
+void LEDController::transmit(const LEDArray& frame, int64_t time_ns){
+    int64_t t0 = StageStats::now_ns();
+    tx_calibration = std::atomic_load(&calibration);
+    encode_frame(*tx_calibration, encoding, frame.data(), LED_COUNT, tx.get());
+    int64_t t1 = StageStats::now_ns();
+    stage_stats.Record(FrameStage::ENCODE, t1 - t0);
+    tx_frame = frame;
+    tx_time = time_ns;
+    tx_valid = false;
+    bool ok = output->WriteFrame(tx.get(), tx_bytes, time_ns);
+    stage_stats.Record(FrameStage::TRANSFER, StageStats::now_ns() - t1);
+    if(!ok) {
+        //damn that sucks
+        puts("LED output write failed");
+        return;
+    }
+    tx_valid = true;
+    last_send_time = std::chrono::steady_clock::now();
+    frames_sent.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LEDController::run_output(){
+    queued_frame_t frame;
+    while(true){
+        if(frame_queue.pop(frame)){
+            transmit(frame.leds, frame.time_ns);
+            continue;
+        }
+        if(latest_frame.take(frame)){
+            //a frame queued just before a switch to QUEUE may already have overtaken it
+            if(tx_valid && frame.time_ns < tx_time) frames_dropped.fetch_add(1, std::memory_order_relaxed);
+            else transmit(frame.leds, frame.time_ns);
+            continue;
+        }
+        if(!output_running.load(std::memory_order_acquire) && frame_queue.empty() && !latest_frame.fresh()) break;
+
+        //calibration changed under a static frame, send it through the new tables
+        if(tx_valid && std::atomic_load(&calibration) != tx_calibration){
+            transmit(tx_frame, tx_time);
+            continue;
         }
+
+        int64_t metrics_interval = metrics_interval_ms.load(std::memory_order_relaxed);
+        if(metrics_interval > 0 &&
+           std::chrono::steady_clock::now() - last_metrics_time >= std::chrono::milliseconds(metrics_interval)){
+            write_metrics();
+            last_metrics_time = std::chrono::steady_clock::now();
+        }
+
+        //nothing new, resend the stored encoding if the keep-alive expired
+        int64_t keepalive = keepalive_ms.load(std::memory_order_relaxed);
+        if(tx_valid && keepalive > 0 &&
+           std::chrono::steady_clock::now() - last_send_time >= std::chrono::milliseconds(keepalive)){
+            if(output->WriteFrame(tx.get(), tx_bytes, tx_time)){
+                last_send_time = std::chrono::steady_clock::now();
+                frames_sent.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+        //push() only notifies, the timeout covers a wakeup racing this wait
+        std::unique_lock<std::mutex> lock(output_mtx);
+        output_cv.wait_for(lock, std::chrono::milliseconds(1));
     }
 }
 
-void LEDController::run_transition(LEDMatrix* matrix) {
-    static std::optional<TransitionSpiral> transition;
+void LEDController::SetMetricsFile(const std::string& path, std::chrono::milliseconds interval){
+    std::lock_guard<std::mutex> lock(metrics_mtx);
+    metrics_path = path;
+    metrics_interval_ms.store(path.empty() ? 0 : interval.count(), std::memory_order_relaxed);
+}
+
+//output thread, written whole to path.tmp and renamed so readers never see half a file
+void LEDController::write_metrics(){
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(metrics_mtx);
+        path = metrics_path;
+    }
+    if(path.empty()) return;
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "w");
+    if(!f) return;
+    stats_t stats = GetStats();
+    fprintf(f, "# pacing target_fps actual_fps frames missed skipped max_late_us\n");
+    fprintf(f, "pacing %.1f %.1f %llu %llu %llu %.1f\n", stats.pacing.target_fps, stats.pacing.actual_fps,
+            (unsigned long long)stats.pacing.frames, (unsigned long long)stats.pacing.missed,
+            (unsigned long long)stats.pacing.skipped, stats.pacing.max_late_ns / 1e3);
+    fprintf(f, "# commands queued applied coalesced rejected p50_us p99_us max_us\n");
+    fprintf(f, "commands %llu %llu %llu %llu %.1f %.1f %.1f\n", (unsigned long long)stats.commands.queued,
+            (unsigned long long)stats.commands.applied, (unsigned long long)stats.commands.coalesced,
+            (unsigned long long)stats.commands.rejected, stats.commands.latency.p50_ns / 1e3,
+            stats.commands.latency.p99_ns / 1e3, stats.commands.latency.max_ns / 1e3);
+    fprintf(f, "# state_change count p50_us p99_us max_us retargeted cut\n");
+    fprintf(f, "state_change %llu %.1f %.1f %.1f %llu %llu\n", (unsigned long long)stats.commands.state_latency.count,
+            stats.commands.state_latency.p50_ns / 1e3, stats.commands.state_latency.p99_ns / 1e3,
+            stats.commands.state_latency.max_ns / 1e3, (unsigned long long)stats.commands.retargeted,
+            (unsigned long long)stats.commands.cut);
+    fprintf(f, "# frames sent skipped dropped queue_depth max_queue_depth\n");
+    fprintf(f, "frames %llu %llu %llu %zu %zu\n", (unsigned long long)stats.frames.sent,
+            (unsigned long long)stats.frames.skipped, (unsigned long long)stats.frames.dropped,
+            stats.frames.queue_depth, stats.frames.max_queue_depth);
+    write_stage_stats(f, stats.stages);
+    bool ok = fclose(f) == 0;
+    if(!ok || rename(tmp.c_str(), path.c_str()) != 0) remove(tmp.c_str());
+}
 
+void LEDController::run_transition(const frame_time_t& now) {
     // Set initial HSV values for testing if not already set
     if (currentHSV[0].h == 0 && currentHSV[0].s == 0 && currentHSV[0].v == 0) {
         currentHSV = {
@@ -63,18 +334,21 @@ void LEDController::run_transition(LEDMatrix* matrix) {
     if (pendingNextState && !transition) {
         printf("Starting transition to state %d\n", static_cast<int>(*pendingNextState));
         
-        // Create the transition object with the current and next HSV values
-        transition.emplace(currentHSV, nextHSV);
+        // Restart the spiral with the current and next HSV values
+        spiral.Start(currentHSV, nextHSV);
+        transition = &spiral;
     }
     
     // If there's an active transition, update and draw it
     if (transition) {
         // Update transition animation
-        transition->Update();
+        transition->Update(now);
+        frame_timer.Lap(FrameStage::UPDATE);
         
         // Clear LEDs and draw the transition effect using the improved Draw method
-        // that takes leds and led_lut directly for Gaussian blending
-        transition->DrawTransition(matrix, leds, led_lut);
+        // that takes leds directly for Gaussian blending
+        transition->DrawTransition(leds);
+        frame_timer.Lap(FrameStage::DRAW);
         
         // Push to hardware
         update_leds();
@@ -85,7 +359,7 @@ void LEDController::run_transition(LEDMatrix* matrix) {
             currentHSV = nextHSV;
             LEDState newState = *pendingNextState;
             pendingNextState.reset();
-            transition.reset();
+            transition = nullptr;
             
             // Actually set the new state once transition is complete
             printf("Transition finished, setting state to %d\n", static_cast<int>(newState));
@@ -97,6 +371,13 @@ void LEDController::run_transition(LEDMatrix* matrix) {
 }
 
 void LEDController::run_transition_test() {
+    // this loop is the render thread here: it drains the command queue and
+    // draws into leds itself, so a running run() would be a second consumer
+    if (control_thread.joinable()) {
+        printf("run_transition_test: the render thread is running, not starting a second one\n");
+        return;
+    }
+
     // Set up test values
     std::unique_ptr<LEDMatrix> matrix = std::make_unique<LEDMatrix>();
     
@@ -118,6 +399,8 @@ void LEDController::run_transition_test() {
     
     // Initialize currentHSV array from srcHSV
     currentHSV = srcHSV;
+    std::array<led_color_t, 3> srcRGB;
+    hsv2rgb_batch(srcHSV.data(), srcHSV.size(), srcRGB.data());
     
     // Target HSV values for transition
     std::array<HSV, 3> targetHSV = {
@@ -126,51 +409,36 @@ void LEDController::run_transition_test() {
         HSV{240.0f, 0.8f, 1.0f}    // Blue
     };
     
-    std::vector<float> sigma = {1.0f, 1.0f, 1.0f};  // Gaussian blur radius
-    std::vector<float> I = {0.7f, 0.7f, 0.7f};      // Intensity
+    const std::array<float, 3> sigma = {1.0f, 1.0f, 1.0f};  // Gaussian blur radius
+    const std::array<float, 3> I = {0.7f, 0.7f, 0.7f};      // Intensity
+    const std::array<const SplatTable*, 3> splat = {&Render::Splat(sigma[0]), &Render::Splat(sigma[1]), &Render::Splat(sigma[2])};
     
     // Run test for a few seconds
+    FrameTicker test_ticker;
     for (int frame = 0; frame < 1000 && should_run.load(std::memory_order_relaxed); frame++) {
         matrix->Clear(leds);
         
         // Manually update orbs
+        const frame_time_t& now = test_ticker.Tick(*anim_clock);
         for (auto& anim : scene) {
-            anim->Update();
+            anim->Update(now);
         }
         
-        // Reset LED buffer for this frame
-        for (int i = 0; i < LED_COUNT; ++i) {
-            leds[i] = {0, 0, 0};
-        }
+        // Reset render buffer for this frame
+        canvas.Clear();
         
-        // Render each orb with Gaussian distribution
+        // Render each orb with Gaussian distribution, additive blend
+        std::array<float, LED_COUNT> F;
         for (size_t o = 0; o < scene.size(); ++o) {
             auto orbPtr = dynamic_cast<Orb*>(scene[o].get());
             polar_t C = orbPtr->GetOrigin();
             
             // Make sure the coordinate is valid (normalized)
             C.normalize();
-            
-            // For each LED
-            for (int i = 0; i < LED_COUNT; ++i) {
-                polar_t P = led_lut[i];
-                
-                float dθ = angularDifference(P.theta, C.theta);
-                float r̄ = (P.r + C.r) * 0.5f;
-                float Δr = P.r - C.r;
-                float d2 = (dθ * r̄)*(dθ * r̄) + (Δr * Δr);
-                float F = std::exp(-d2 / (2 * sigma[o] * sigma[o]));
-                
-                // Orb-specific base color
-                led_color_t base = hsv2rgb(srcHSV[o]);
-                
-                // Scaled contribution
-                led_color_t contrib = base * (I[o] * F);
-                
-                // Additive blend
-                leds[i] = leds[i] + contrib;
-            }
+            splat[o]->Weights(C.theta, C.r, F.data());
+            canvas.AddSplat(F.data(), srcRGB[o], I[o]);
         }
+        canvas.Resolve(leds.data());
         
         // Push to hardware
         update_leds();
@@ -184,19 +452,33 @@ void LEDController::run_transition_test() {
             } else {
                 RequestState(LEDState::ACTIVE, srcHSV);
             }
+            apply_commands();
             
             // Run the transition (will continue until finished)
             while (pendingNextState && should_run.load(std::memory_order_relaxed)) {
+                pace(transition_fps.load(std::memory_order_relaxed));
                 matrix->Clear(leds);
-                run_transition(matrix.get());
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                run_transition(test_ticker.Tick(*anim_clock));
             }
         }
         
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        pace(transition_fps.load(std::memory_order_relaxed));
     }
 }
 
+//helper for ang diff, orb separation in run()
+static float angularDifference(float a, float b) {
+    // Normalize angles to [0, 2π) if not already
+    while (a < 0) a += 2.0f * M_PI_F;
+    while (a >= 2.0f * M_PI_F) a -= 2.0f * M_PI_F;
+    while (b < 0) b += 2.0f * M_PI_F;
+    while (b >= 2.0f * M_PI_F) b -= 2.0f * M_PI_F;
+    
+    float d = fabs(a - b);
+    d = fmod(d, 2.0f * M_PI_F);
+    return (d > M_PI_F) ? (2.0f * M_PI_F - d) : d;
+}
+
 void LEDController::run(){
     
     std::unique_ptr<LEDMatrix> matrix = std::make_unique<LEDMatrix>();
@@ -206,9 +488,7 @@ void LEDController::run(){
     puts("LED controller running main loop");
 
     auto set_line = [&](float angle_deg, led_color_t color){
-        for(int i = 0; i < 5; ++i){
-            matrix->set_led(angle_deg, i, color);
-        }
+        matrix->draw_line(angle_deg, 0, LEDMatrix::RINGS - 1, color);
     };
 
     std::vector<std::unique_ptr<Animatable>> scene;
@@ -224,19 +504,24 @@ void LEDController::run(){
 
     // —— Stage 4: parameters for all orbs ——  
     // (must match your scene.push_back order)
-    std::vector<HSV> orbHSV = {
+    std::array<HSV, 3> orbHSV = {{
         {245.0f, 0.8f, 1.0f},   // white-ish
         { 40.0f, 0.8f, 1.0f},   // blue
         {240.0f, 0.8f, 1.0f}    // magenta
-    };
+    }};
     
     // Initialize the currentHSV array from orbHSV
     for (size_t i = 0; i < std::min(orbHSV.size(), currentHSV.size()); i++) {
         currentHSV[i] = orbHSV[i];
     }
+    // orb colors are fixed, convert them once
+    std::array<led_color_t, 3> orbRGB;
+    hsv2rgb_batch(orbHSV.data(), orbHSV.size(), orbRGB.data());
     
-    std::vector<float> sigma = { 1.0f, 1.0f, 1.0f };
-    std::vector<float> I = { 0.7f, 0.7f, 0.7f };
+    const std::array<float, 3> sigma = { 1.0f, 1.0f, 1.0f };
+    const std::array<float, 3> I = { 0.7f, 0.7f, 0.7f };
+    // tables looked up once, not per orb per frame
+    const std::array<const SplatTable*, 3> splat = { &Render::Splat(sigma[0]), &Render::Splat(sigma[1]), &Render::Splat(sigma[2]) };
     
     // set_line(0.f, {255,0,0});
     // set_line(90.f, {0,255,0});
@@ -249,6 +534,18 @@ void LEDController::run(){
     static LEDState lastState = state.load(std::memory_order_relaxed);
     
     while(should_run.load(std::memory_order_relaxed)){
+        // Each frame waits for its deadline at the rate of what it is about to
+        // render, then picks up commands so they show in this very frame
+        frame_timer.Finish(FrameStage::COMPOSE);
+        pace(transition || pendingNextState ? transition_fps.load(std::memory_order_relaxed)
+                                            : StateFPS(state.load(std::memory_order_relaxed)));
+        //shutdown may have come in while pacing, don't render past it
+        if(!should_run.load(std::memory_order_relaxed)) break;
+        frame_timer.Start();
+        // the one clock read of the frame, every animation moves to it
+        const frame_time_t& now = ticker.Tick(*anim_clock);
+        apply_commands();
+
         // Get current state
         LEDState currentState = state.load(std::memory_order_relaxed);
         
@@ -260,76 +557,27 @@ void LEDController::run(){
             lastState = currentState;
         }
    
-        // Check for pending transition first
-        if (pendingNextState) {
-            // Modified to ensure transition completes fully before continuing
-            // Keep running transition updates until the transition is complete
-            printf("DEBUG: Starting transition loop for state %d\n", static_cast<int>(*pendingNextState));
-            auto transitionStartTime = std::chrono::high_resolution_clock::now();
-            int loopCount = 0;
-            
-            while (pendingNextState && should_run.load(std::memory_order_relaxed)) {
-                auto loopStartTime = std::chrono::high_resolution_clock::now();
-                
-                // REMOVED: matrix->Clear(leds) - This was causing the blank screen during transitions
-                // The clearing is now handled inside run_transition
-                
-                run_transition(matrix.get());
-                
-                auto loopEndTime = std::chrono::high_resolution_clock::now();
-                auto loopDuration = std::chrono::duration_cast<std::chrono::milliseconds>(loopEndTime - loopStartTime).count();
-                
-                loopCount++;
-                if (loopCount % 50 == 0) {  // Log every 50 iterations
-                    auto totalDuration = std::chrono::duration_cast<std::chrono::milliseconds>(loopEndTime - transitionStartTime).count();
-                    printf("DEBUG: Transition loop iteration %d, loop time: %ldms, total time: %ldms\n", 
-                           loopCount, loopDuration, totalDuration);
-                }
-                
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-            
-            auto transitionEndTime = std::chrono::high_resolution_clock::now();
-            auto totalTransitionTime = std::chrono::duration_cast<std::chrono::milliseconds>(transitionEndTime - transitionStartTime).count();
-            printf("DEBUG: Transition complete after %d iterations, total time: %ldms\n", 
-                   loopCount, totalTransitionTime);
-            
-            continue; // Skip normal rendering after transition is complete
-        }
-       
-        // Handle each state
-        if(currentState == LEDState::DORMANT){
-            run_dormant();
-            continue;
-        }
-        else if(currentState == LEDState::RESPOND_TO_USER){
-            run_respond_to_user();
-            continue;
-        }
-        else if(currentState == LEDState::BOOT){
-            run_boot();
-            continue;
-        }
-        else if(currentState == LEDState::PROMPT){
-            run_prompt();
+        // A transition is one more stage of the frame loop, a request landing
+        // mid-transition retargets or cuts it short in apply_commands()
+        if (transition || pendingNextState) {
+            run_transition(now);
             continue;
         }
-        else if(currentState == LEDState::CONNECTING){
-            run_connecting();
-            continue;
-        }
-        else if(currentState == LEDState::PLACEHOLDER_TRANSITION){
-            run_placeholder_transition();
+
+        // Every state but ACTIVE is a layer stack
+        if(currentState != LEDState::ACTIVE){
+            run_layers(currentState, now);
             continue;
         }
         
         // Must be in ACTIVE state if we get here
         // Clear the matrix for rendering
         matrix->Clear(leds);
+        frame_timer.Lap(FrameStage::COMPOSE);
 
         // 6.1 linear motion
         for(auto& anim : scene){
-            anim->Update();
+            anim->Update(now);
         }
        
         // once-only for triggering spiral
@@ -352,9 +600,7 @@ void LEDController::run(){
        
         float sep01 = sep(c0, c1), sep12 = sep(c1, c2);
        
-        uint64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
-                          std::chrono::high_resolution_clock::now() - scene[0]->start
-                       ).count();
+        uint64_t nowUs = static_cast<uint64_t>(scene[0]->Elapsed(now) * 1e6f);
        
         if (!spiralTriggered && sep01 < 0.25f && sep12 < 0.25f) {
             spiralTriggered = true;
@@ -365,7 +611,7 @@ void LEDController::run(){
         if (spiralTriggered) {
             uint64_t dt = nowUs - spiralStartUs;
             float tNorm = std::min(1.0f, dt / float(spiralDurationUs));
-            float e     = easeInOut(tNorm);
+            float e     = ease(Ease::IN_OUT, tNorm);
            
             // apply r(t) = mix(r_start, 0, e)
             for (auto &anim : scene) {
@@ -378,6 +624,8 @@ void LEDController::run(){
                 orb->SetOrigin(C);
             }
         }
+        update_overlays(currentState, now);
+        frame_timer.Lap(FrameStage::UPDATE);
        
         static bool once=true;
         if(once){
@@ -387,40 +635,27 @@ void LEDController::run(){
                 polar_t C = orbPtr->GetOrigin();
                 printf("Orb %zu at r=%.1f,θ=%.1f°\n", 
                        i, C.r, RAD2DEG(C.theta));
-                led_color_t test = hsv2rgb(orbHSV[i])*(I[i]*1.0f);
+                led_color_t test = orbRGB[i]*(I[i]*1.0f);
                 printf("  RGB=(%u,%u,%u)\n", test.r, test.g, test.b);
             }
         }
  
-        // zero‐out LED framebuffer
-        for(int i = 0; i < LED_COUNT; ++i)
-            leds[i] = {0,0,0};
+        // zero‐out render buffer
+        canvas.Clear();
 
-        // for each orb…
+        // for each orb… scaled contribution in its own color, additive blend
+        std::array<float, LED_COUNT> F;
         for(size_t o = 0; o < scene.size(); ++o) {
             auto orbPtr = dynamic_cast<Orb*>(scene[o].get());
             polar_t C = orbPtr->GetOrigin();
-
-            // for each LED
-            for(int i = 0; i < LED_COUNT; ++i) {
-                polar_t P = led_lut[i];
-
-                float dθ = angularDifference(P.theta, C.theta);
-                float r̄ = (P.r + C.r) * 0.5f;
-                float Δr = P.r - C.r;
-                float d2 = (dθ * r̄)*(dθ * r̄) + (Δr * Δr);
-                float F  = std::exp(-d2 / (2 * sigma[o] * sigma[o]));
-
-                // orb‐specific base color
-                led_color_t base = hsv2rgb(orbHSV[o]);
-
-                // scaled contribution
-                led_color_t contrib = base * (I[o] * F);
-
-                // additive blend (operator+ clamps at 255)
-                leds[i] = leds[i] + contrib;
-            }
+            splat[o]->Weights(C.theta, C.r, F.data());
+            canvas.AddSplat(F.data(), orbRGB[o], I[o]);
         }
+        draw_overlays(currentState);
+        frame_timer.Lap(FrameStage::DRAW);
+
+        // saturate once, into the LED framebuffer
+        canvas.Resolve(leds.data());
 
         // push to hardware
         update_leds();
@@ -434,185 +669,32 @@ void LEDController::run(){
         // std::this_thread::sleep_for(std::chrono::microseconds(750));
     }
     
+    frame_timer.Finish(FrameStage::COMPOSE);
     puts("LED controller exiting main loop");
 }
 
-void LEDController::run_dormant(){
-    static std::unique_ptr<LEDMatrix> dormant_matrix = std::make_unique<LEDMatrix>();
-    static Glow dormGlow(5, led_color_t{40, 120, 255}, led_color_t{5,5,10});
-    
-    // Clear the LED buffer
-    dormant_matrix->Clear(leds);
-    
-    // Update the glow animation timing
-    dormGlow.Update();
-    
-    // Get animation parameters
-    float current_size = dormGlow.current_size;
-    float max_size = static_cast<float>(dormGlow.max_size);
-    float animation_phase = current_size / max_size;  // 0-1 through the cycle
-    led_color_t base_color = dormGlow.base_color;
-    led_color_t min_color = dormGlow.min_color;
-    bool is_expanding = dormGlow.inc > 0;
-    
-    // Constant dim core intensity to match at beginning and end of cycle
-    const float dim_core_intensity = 0.25f;
-    
-    // Keep track of cycle transition points
-    static bool in_transition = false;
-    static float transition_progress = 0.0f;
-    const float transition_threshold = 0.1f; // Size threshold to consider in transition
-
-    // Detect cycle transition points
-    if (current_size < transition_threshold) {
-        in_transition = true;
-        transition_progress = current_size / transition_threshold;
-    } else if (in_transition && current_size >= transition_threshold) {
-        in_transition = false;
-    }
-    
-    // CRITICAL: Set center ring first to ensure it's always on regardless of animation phase
-    // This guarantees the center never turns off during any state
-    dormGlow.set_ring(0, min_color + ((base_color - min_color) * dim_core_intensity));
-    
-    // For each ring, calculate its brightness
-    for (int ring = 0; ring < 5; ring++) {
-        // Skip center ring as we've already set it to ensure it's always on
-        if (ring == 0) continue;
-        
-        float intensity = 0.0f;
-        
-        if (is_expanding) {
-            // EXPANSION PHASE: smooth wave of light moving outward
-            // Calculate how far the wave has progressed through this ring
-            float wave_position = current_size - static_cast<float>(ring);
-            
-            // Create a window function for smooth transition (0->1->0)
-            // Use a smoothstep-like function for more natural transitions
-            if (wave_position >= -1.0f && wave_position <= 1.0f) {
-                // Smooth transition as wave passes through ring (0->1)
-                float t = (wave_position + 1.0f) * 0.5f; // normalize to 0-1
-                // Smoothstep function: 3t² - 2t³ (smoother than linear)
-                intensity = t * t * (3.0f - 2.0f * t);
-            } else if (wave_position > 1.0f) {
-                // After wave has passed, maintain a glow that fades with distance
-                intensity = 1.0f - std::min(0.5f, (wave_position - 1.0f) * 0.1f);
-            }
-        } else {
-            // CONTRACTION PHASE: smooth wave of darkness moving inward
-            
-            // During contraction, we want rings to gradually dim from outside to inside
-            // Normalize current_size to go from max_size to 0
-            float contraction_progress = current_size / max_size;
-            
-            // Calculate normalized ring position (0 = center, 1 = outermost)
-            float ring_position = static_cast<float>(ring) / (max_size - 1.0f);
-            
-            // Calculate how far the dimming wave has progressed relative to this ring
-            // Negative means ring is ahead of the wave (still bright)
-            // Positive means wave has passed this ring (dimming/dimmed)
-            float dimming_factor = ring_position - contraction_progress;
-            
-            // Apply a smooth curve for dimming transition
-            // We want a value that goes from 1.0 (fully lit) to dim_core_intensity (mostly dimmed)
-            if (dimming_factor <= 0.0f) {
-                // Ring is ahead of the wave - still fully illuminated
-                intensity = 1.0f;
-            } else if (dimming_factor > 0.0f && dimming_factor < 0.5f) {
-                // Ring is being dimmed by the wave - smooth transition
-                // Use cubic ease-out function for gentle dimming start with accelerated falloff
-                float t = dimming_factor / 0.5f; // normalize to 0-1
-                intensity = 1.0f - (t * t * t); // cubic falloff
-            } else {
-                // Ring is well behind the wave - maintain a minimal glow
-                // that gradually fades to the minimum as we approach the center
-                float remaining = 0.15f * (1.0f - std::min(1.0f, (dimming_factor - 0.5f) * 2.0f));
-                intensity = remaining;
-            }
-        }
-        
-        // Apply natural distance falloff from center
-        float distance_falloff = 1.0f - (ring * 0.1f);
-        intensity *= distance_falloff;
-        
-        // Apply easing at extremes of the animation for smooth cycle transition
-        if (current_size < 0.5f || current_size > (max_size - 0.5f)) {
-            // Ease intensity changes at the start/end of cycle
-            float cycle_transition = std::min(current_size, max_size - current_size) * 2.0f;
-            float transition_ease = cycle_transition * cycle_transition * 0.25f + 0.75f;
-            
-            // Apply transition easing where appropriate
-            if ((!is_expanding && ring == 4)) {
-                intensity *= transition_ease;
-            }
-        }
-        
-        // Apply intensity to color without gamma correction
-        led_color_t ring_color = min_color + ((base_color - min_color) * intensity);
-        
-        // Set the calculated color for this ring
-        dormGlow.set_ring(ring, ring_color);
-    }
-    
-    // Draw to matrix and update LEDs
-    dormGlow.Draw(dormant_matrix.get());
-    dormant_matrix->Update(leds);
-    update_leds();
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-}
+void RingWaveLayer::Update(const frame_time_t& now){
+    glow.Update(now);
+
+    float current_size = glow.current_size;
+    float max_size = static_cast<float>(glow.max_size);
+    led_color_t base_color = glow.base_color;
+    led_color_t min_color = glow.min_color;
+    bool is_expanding = glow.inc > 0;
 
-void LEDController::run_respond_to_user(){
-    static std::unique_ptr<LEDMatrix> respond_matrix = std::make_unique<LEDMatrix>();
-    static Glow respondGlow(5, led_color_t{255, 140, 0}, led_color_t{10,5,0});  // Orange color
-    
-    // Clear the LED buffer
-    respond_matrix->Clear(leds);
-    
-    // Update the glow animation timing
-    respondGlow.Update();
-    
-    // Get animation parameters
-    float current_size = respondGlow.current_size;
-    float max_size = static_cast<float>(respondGlow.max_size);
-    float animation_phase = current_size / max_size;  // 0-1 through the cycle
-    led_color_t base_color = respondGlow.base_color;
-    led_color_t min_color = respondGlow.min_color;
-    bool is_expanding = respondGlow.inc > 0;
-    
     // Constant dim core intensity to match at beginning and end of cycle
     const float dim_core_intensity = 0.25f;
-    
-    // Keep track of cycle transition points
-    static bool in_transition = false;
-    static float transition_progress = 0.0f;
-    const float transition_threshold = 0.1f; // Size threshold to consider in transition
-
-    // Detect cycle transition points
-    if (current_size < transition_threshold) {
-        in_transition = true;
-        transition_progress = current_size / transition_threshold;
-    } else if (in_transition && current_size >= transition_threshold) {
-        in_transition = false;
-    }
-    
-    // CRITICAL: Set center ring first to ensure it's always on regardless of animation phase
-    // This guarantees the center never turns off during any state
-    respondGlow.set_ring(0, min_color + ((base_color - min_color) * dim_core_intensity));
-    
-    // For each ring, calculate its brightness
-    for (int ring = 0; ring < 5; ring++) {
-        // Skip center ring as we've already set it to ensure it's always on
-        if (ring == 0) continue;
-        
+
+    // The center never turns off during any phase
+    ring_colors[0] = min_color + ((base_color - min_color) * dim_core_intensity);
+
+    for (int ring = 1; ring < OrbFixture::RINGS; ring++) {
         float intensity = 0.0f;
-        
+
         if (is_expanding) {
             // EXPANSION PHASE: smooth wave of light moving outward
-            // Calculate how far the wave has progressed through this ring
             float wave_position = current_size - static_cast<float>(ring);
-            
-            // Create a window function for smooth transition (0->1->0)
-            // Use a smoothstep-like function for more natural transitions
+
             if (wave_position >= -1.0f && wave_position <= 1.0f) {
                 // Smooth transition as wave passes through ring (0->1)
                 float t = (wave_position + 1.0f) * 0.5f; // normalize to 0-1
@@ -624,324 +706,182 @@ void LEDController::run_respond_to_user(){
             }
         } else {
             // CONTRACTION PHASE: smooth wave of darkness moving inward
-            
-            // During contraction, we want rings to gradually dim from outside to inside
-            // Normalize current_size to go from max_size to 0
             float contraction_progress = current_size / max_size;
-            
+
             // Calculate normalized ring position (0 = center, 1 = outermost)
             float ring_position = static_cast<float>(ring) / (max_size - 1.0f);
-            
-            // Calculate how far the dimming wave has progressed relative to this ring
-            // Negative means ring is ahead of the wave (still bright)
-            // Positive means wave has passed this ring (dimming/dimmed)
+
+            // Negative means ring is ahead of the wave (still bright),
+            // positive means wave has passed this ring (dimming/dimmed)
             float dimming_factor = ring_position - contraction_progress;
-            
-            // Apply a smooth curve for dimming transition
-            // We want a value that goes from 1.0 (fully lit) to dim_core_intensity (mostly dimmed)
+
             if (dimming_factor <= 0.0f) {
-                // Ring is ahead of the wave - still fully illuminated
                 intensity = 1.0f;
-            } else if (dimming_factor > 0.0f && dimming_factor < 0.5f) {
-                // Ring is being dimmed by the wave - smooth transition
-                // Use cubic ease-out function for gentle dimming start with accelerated falloff
+            } else if (dimming_factor < 0.5f) {
+                // cubic falloff: gentle dimming start, accelerating
                 float t = dimming_factor / 0.5f; // normalize to 0-1
-                intensity = 1.0f - (t * t * t); // cubic falloff
+                intensity = 1.0f - (t * t * t);
             } else {
                 // Ring is well behind the wave - maintain a minimal glow
                 // that gradually fades to the minimum as we approach the center
-                float remaining = 0.15f * (1.0f - std::min(1.0f, (dimming_factor - 0.5f) * 2.0f));
-                intensity = remaining;
+                intensity = 0.15f * (1.0f - std::min(1.0f, (dimming_factor - 0.5f) * 2.0f));
             }
         }
-        
+
         // Apply natural distance falloff from center
         float distance_falloff = 1.0f - (ring * 0.1f);
         intensity *= distance_falloff;
-        
-        // Apply easing at extremes of the animation for smooth cycle transition
-        if (current_size < 0.5f || current_size > (max_size - 0.5f)) {
-            // Ease intensity changes at the start/end of cycle
+
+        // Ease the outer ring at the turning points of the contraction
+        if (!is_expanding && ring == OrbFixture::RINGS - 1 &&
+            (current_size < 0.5f || current_size > (max_size - 0.5f))) {
             float cycle_transition = std::min(current_size, max_size - current_size) * 2.0f;
-            float transition_ease = cycle_transition * cycle_transition * 0.25f + 0.75f;
-            
-            // Apply transition easing where appropriate
-            if ((!is_expanding && ring == 4)) {
-                intensity *= transition_ease;
-            }
+            intensity *= cycle_transition * cycle_transition * 0.25f + 0.75f;
         }
-        
+
         // Apply intensity to color without gamma correction
-        led_color_t ring_color = min_color + ((base_color - min_color) * intensity);
-        
-        // Set the calculated color for this ring
-        respondGlow.set_ring(ring, ring_color);
+        ring_colors[ring] = min_color + ((base_color - min_color) * intensity);
     }
-    
-    // Draw to matrix and update LEDs
-    respondGlow.Draw(respond_matrix.get());
-    respond_matrix->Update(leds);
-    update_leds();
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
 }
 
-void LEDController::run_prompt() {
-    static std::unique_ptr<LEDMatrix> prompt_matrix = std::make_unique<LEDMatrix>();
-    
-    // Static variables for animation state
-    static float angle = 0.0f;
-    static const float ROTATION_SPEED = 300.0f; // degrees per second - increased by 5x
-    static auto last_update = std::chrono::high_resolution_clock::now();
-    
-    // Create our single large orb with constant parameters
-    static polar_t orb_position = polar_t::Degrees(angle, 3); // Radius 3
-
-    // Clear matrix
-    prompt_matrix->Clear(leds); 
+void RingWaveLayer::Render(FrameLayerBuffer& out){
+    for(int ring = 0; ring < OrbFixture::RINGS; ++ring)
+        for(int i = 0; i < OrbFixture::sizes[ring]; ++i)
+            out.Set(OrbFixture::offsets[ring] + i, ring_colors[ring]);
+}
 
-    // Update rotation angle based on elapsed time (for smooth constant movement)
-    auto now = std::chrono::high_resolution_clock::now();
-    float elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_update).count();
-    last_update = now;
-    
-    // Apply rotation at constant speed (degrees per frame)
-    angle += (ROTATION_SPEED / 1000.0f) * elapsed_ms;
+void SpinOrbLayer::Update(const frame_time_t& now){
+    // Rotate at constant speed whatever the frame rate
+    angle += speed * now.dt;
     if (angle >= 360.0f) angle -= 360.0f;
-    
-    // Update orb position
-    orb_position = polar_t::Degrees(angle, 3);
-    
-    // Define HSV color and lighting parameters
-    HSV orbHSV = {0.0f, 0.0f, 1.0f}; 
-    float sigma = 3.5f;                  // blur radius (larger = bigger orb)
-    float intensity = 1.2f;              // global brightness (increased for better contrast)
-    
-    // First set all LEDs to 50% white (background)
-    for (int i = 0; i < LED_COUNT; ++i) {
-        leds[i] = led_color_t{0, 0, 0}; // 50% white (128/255 = 0.5 or 50%)
-    }
-    
-    // Calculate orb influence for each LED
-    std::vector<float> orb_influence(LED_COUNT, 0.0f);
-    float max_influence = 0.0f;
-    
-    for (int i = 0; i < LED_COUNT; ++i) {
-        polar_t p = led_lut[i];
-        
-        // Calculate distance metrics
-        float dθ = angularDifference(p.theta, orb_position.theta);
-        float r̄ = (p.r + orb_position.r) * 0.5f;
-        float Δr = p.r - orb_position.r;
-        
-        // Squared distance (for Gaussian)
-        float d2 = (dθ * r̄)*(dθ * r̄) + (Δr * Δr);
-        
-        // Gaussian falloff function
-        float F = std::exp(-d2 / (2 * sigma * sigma));
-        orb_influence[i] = F;
-        
-        if (F > max_influence) max_influence = F;
-    }
-    
-    // Apply colors based on influence
-    for (int i = 0; i < LED_COUNT; ++i) {
-        float F = orb_influence[i];
-        
-        // Calculate orb color with intensity falloff
-        led_color_t orb_color = hsv2rgb(orbHSV) * (intensity * F);
-        
-        // Blend with background based on influence
-        // Higher influence = more orb color, less background
-        float blend_factor = std::min(1.0f, F * 2.0f); // Scale influence for stronger effect
-        
-        // Weighted blend between background white and orb color
-        leds[i].r = static_cast<uint8_t>((1.0f - blend_factor) * 128 + blend_factor * orb_color.r);
-        leds[i].g = static_cast<uint8_t>((1.0f - blend_factor) * 128 + blend_factor * orb_color.g);
-        leds[i].b = static_cast<uint8_t>((1.0f - blend_factor) * 128 + blend_factor * orb_color.b);
-    }
-    
-    // Push to hardware
-    update_leds();
-    
-    // Smooth timing
-    std::this_thread::sleep_for(std::chrono::milliseconds(20));
 }
 
-void LEDController::run_boot() {
-    // Same base implementation as run_prompt but with blue orb and white background
-    static std::unique_ptr<LEDMatrix> boot_matrix = std::make_unique<LEDMatrix>();
-
-    // Animation state shared across calls
-    static float angle = 0.0f;
-    static const float ROTATION_SPEED = 300.0f; // degrees per second
-    static auto last_update = std::chrono::high_resolution_clock::now();
-
-    // Clear matrix for this frame
-    boot_matrix->Clear(leds);
-
-    // Time keeping for smooth motion
-    auto now = std::chrono::high_resolution_clock::now();
-    float elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_update).count();
-    last_update = now;
-
-    // Update rotation angle
-    angle += (ROTATION_SPEED / 1000.0f) * elapsed_ms;
-    if (angle >= 360.0f) angle -= 360.0f;
+void SpinOrbLayer::Render(FrameLayerBuffer& out){
+    polar_t position = polar_t::Degrees(angle, 3);
+    std::array<float, LED_COUNT> influence;
+    splat.Weights(position.theta, position.r, influence.data());
+    out.MixSplat(influence.data(), color, gain, mix);
+}
 
-    // Orb polar coordinates (radius 3)
-    polar_t orb_position = polar_t::Degrees(angle, 3);
+WiFiLayer::WiFiLayer(led_color_t color, float direction_deg)
+: color(color), symbol(direction_deg) {
+    const float d = ELEMENT_DURATION;
+    reveal.Track({{0.f, 1.f, Ease::HOLD}, {d, 2.f, Ease::HOLD}, {2 * d, 3.f, Ease::HOLD},
+                  {3 * d, 4.f, Ease::HOLD}, {4 * d, 0.f, Ease::HOLD}, {5 * d, 0.f}});
+    reveal.SetLoop(true);
+}
 
-    // Colour palette – dormant style blue for orb, white/grey background
-    HSV orbHSV = {220.0f, 0.8f, 1.0f};       // Bright blue
-    const led_color_t bg_colour = {128, 128, 128}; // 50% white background
+void WiFiLayer::Update(const frame_time_t& now){
+    t = std::fmod(t + now.dt, reveal.Duration());
+    reveal.Evaluate(t);
+    shown = static_cast<int>(reveal[0]);
+}
 
-    // Visual parameters
-    float sigma      = 3.5f;  // blur radius
-    float intensity  = 1.2f;  // overall brightness multiplier
+void WiFiLayer::Render(FrameLayerBuffer& out){
+    matrix.Clear(frame);
+    symbol.Draw(&matrix, color, shown);
+    matrix.Update(frame);
+    // only the lit LEDs cover what is below
+    for(int i = 0; i < LED_COUNT; ++i)
+        if(frame[i].r | frame[i].g | frame[i].b) out.Set(i, frame[i]);
+}
 
-    // Fill background first
-    for (int i = 0; i < LED_COUNT; ++i) {
-        leds[i] = bg_colour;
+void SectorFillLayer::Update(const frame_time_t& now){
+    if(!initialized){
+        filled_angle_deg = 30.0f;
+        current_radius   = 0;
+        initialized      = true;
     }
-
-    // Pre-allocate influence array
-    std::vector<float> influence(LED_COUNT, 0.0f);
-
-    // Compute Gaussian influence per LED
-    for (int i = 0; i < LED_COUNT; ++i) {
-        polar_t p = led_lut[i];
-        float dθ  = angularDifference(p.theta, orb_position.theta);
-        float r̄   = (p.r + orb_position.r) * 0.5f;
-        float Δr  = p.r - orb_position.r;
-        float d2  = (dθ * r̄) * (dθ * r̄) + (Δr * Δr);
-        float F   = std::exp(-d2 / (2 * sigma * sigma));
-        influence[i] = F;
+    else {
+        // Grow the lit sector by ANGULAR_SPEED * dt
+        filled_angle_deg += ANGULAR_SPEED * now.dt;
     }
 
-    // Apply colour to framebuffer
-    for (int i = 0; i < LED_COUNT; ++i) {
-        float F = influence[i];
-        led_color_t orb_rgb = hsv2rgb(orbHSV) * (intensity * F);
-
-        // Blend with background – stronger influence = more orb colour
-        float blend = std::min(1.0f, F * 2.0f);
-        leds[i].r = static_cast<uint8_t>((1.0f - blend) * bg_colour.r + blend * orb_rgb.r);
-        leds[i].g = static_cast<uint8_t>((1.0f - blend) * bg_colour.g + blend * orb_rgb.g);
-        leds[i].b = static_cast<uint8_t>((1.0f - blend) * bg_colour.b + blend * orb_rgb.b);
+    // When the sector completes a full circle, move to the next ring
+    if (filled_angle_deg >= 360.0f) {
+        filled_angle_deg = 0.0f;
+        if (current_radius < OrbFixture::RINGS - 1) current_radius++;
     }
 
-    // Push to hardware
-    update_leds();
-
-    // Frame pacing
-    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    // Once every ring is filled, just keep the entire matrix lit
+    fully_filled = (current_radius >= OrbFixture::RINGS - 1 && filled_angle_deg >= 359.9f);
 }
 
-void LEDController::run_connecting() {
-    // Create a static matrix and WiFi symbol
-    static std::unique_ptr<LEDMatrix> wifi_matrix = std::make_unique<LEDMatrix>();
-    static WiFiSymbol wifi_symbol(270.0f);  // Signal pointing upward (270 degrees)
-    
-    // WiFi blue color (same as before)
-    const led_color_t wifi_blue = {40, 120, 255};  // Nice blue like dormant state
-
-    // Clear LED buffer for this frame
-    wifi_matrix->Clear(leds);
-
-    // Animation state: builds WiFi symbol element by element
-    static int current_element = 0;
-    static auto last_element_change = std::chrono::high_resolution_clock::now();
-    constexpr int ELEMENT_DURATION_MS = 800;  // Time to show each element
-
-    // Advance to next element
-    auto now_time = std::chrono::high_resolution_clock::now();
-    if (std::chrono::duration_cast<std::chrono::milliseconds>(now_time - last_element_change).count() >= ELEMENT_DURATION_MS) {
-        current_element = (current_element + 1) % (wifi_symbol.GetElementCount() + 1);  // +1 for pause between cycles
-        last_element_change = now_time;
-    }
-
-    // Draw WiFi symbol up to current element (skip the pause cycle)
-    if (current_element < wifi_symbol.GetElementCount()) {
-        wifi_symbol.Draw(wifi_matrix.get(), wifi_blue, current_element + 1);
-    }
+void SectorFillLayer::Render(FrameLayerBuffer& out){
+    for (int i = 0; i < LED_COUNT; ++i) {
+        polar_t p = OrbRender::led_lut[i];
 
-    // Update matrix -> leds array, then push to hardware
-    wifi_matrix->Update(leds);
-    update_leds();
+        // Normalize angle to [0, 360)
+        float ang_deg = p.angle_deg();
+        while (ang_deg < 0.0f)   ang_deg += 360.0f;
+        while (ang_deg >= 360.0f) ang_deg -= 360.0f;
 
-    // Frame pacing
-    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        bool radius_ok = (p.r <= static_cast<float>(current_radius) + 0.01f);
+        bool angle_ok  = (ang_deg <= filled_angle_deg);
+        if (fully_filled || (radius_ok && angle_ok)) out.Set(i, color);
+    }
 }
 
-void LEDController::run_placeholder_transition() {
-    // Matrix reused across frames
-    static std::unique_ptr<LEDMatrix> ph_matrix = std::make_unique<LEDMatrix>();
-
-    // Reset animation variables if requested
-    if(!ph_initialized){
-        ph_filled_angle_deg = 30.0f;
-        ph_current_radius   = 0;
-        ph_last_update      = std::chrono::high_resolution_clock::now();
-        ph_initialized      = true;
-    }
+void LEDController::build_layers(){
+    const led_color_t grey = {128, 128, 128};   // 50% white background
 
-    // Tunable parameters
-    constexpr float ANGULAR_SPEED = 720.0f;         // Degrees per second that the sector grows
-    const     led_color_t OFF_COLOUR    = {0, 0, 0};
+    state_layers[state_slot(LEDState::DORMANT)].Push(
+        std::make_unique<RingWaveLayer>(led_color_t{40, 120, 255}, led_color_t{5, 5, 10}));
+    state_layers[state_slot(LEDState::RESPOND_TO_USER)].Push(
+        std::make_unique<RingWaveLayer>(led_color_t{255, 140, 0}, led_color_t{10, 5, 0}));   // Orange
 
-    //---------------------------------------------------------------------
-    // Time keeping to make animation frame-rate independent
-    auto now  = std::chrono::high_resolution_clock::now();
-    float dt_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - ph_last_update).count();
-    ph_last_update = now;
+    auto& prompt = state_layers[state_slot(LEDState::PROMPT)];
+    prompt.Push(std::make_unique<SolidLayer>(grey));
+    prompt.Push(std::make_unique<SpinOrbLayer>(hsv2rgb_fast({0.0f, 0.0f, 1.0f})));
 
-    // Grow the lit sector by ANGULAR_SPEED * dt
-    ph_filled_angle_deg += ANGULAR_SPEED * (dt_ms / 1000.0f);
+    // Same as prompt with a bright blue orb
+    auto& boot = state_layers[state_slot(LEDState::BOOT)];
+    boot.Push(std::make_unique<SolidLayer>(grey));
+    boot.Push(std::make_unique<SpinOrbLayer>(hsv2rgb_fast({220.0f, 0.8f, 1.0f})));
 
-    // When the sector completes a full circle, move to the next ring
-    if (ph_filled_angle_deg >= 360.0f) {
-        ph_filled_angle_deg = 0.0f;
-        if (ph_current_radius < 4) {
-            ph_current_radius++;          // Advance to next ring (layer-by-layer)
-        }
-    }
+    state_layers[state_slot(LEDState::CONNECTING)].Push(
+        std::make_unique<WiFiLayer>(led_color_t{40, 120, 255}));   // blue like dormant
 
-    // Once every ring is filled, just keep the entire matrix lit
-    bool fully_filled = (ph_current_radius >= 4 && ph_filled_angle_deg >= 359.9f);
-
-    //---------------------------------------------------------------------
-    // Clear framebuffer for this frame
-    ph_matrix->Clear(leds);
-
-    // Iterate through each LED to decide if it should be lit this frame
-    for (int i = 0; i < LED_COUNT; ++i) {
-        polar_t p = led_lut[i];
+    placeholder_layer = state_layers[state_slot(LEDState::PLACEHOLDER_TRANSITION)].Push(
+        std::make_unique<SectorFillLayer>(led_color_t{255, 255, 255}));
+}
 
-        // Normalize angle to [0, 360)
-        float ang_deg = p.angle_deg();
-        while (ang_deg < 0.0f)   ang_deg += 360.0f;
-        while (ang_deg >= 360.0f) ang_deg -= 360.0f;
+//overlay stacks go over s, the state's own stack is never drawn twice
+void LEDController::update_overlays(LEDState s, const frame_time_t& now){
+    for(int slot = 0; slot < STATE_SLOTS; ++slot)
+        if(overlays & (1u << slot) && slot != state_slot(s)) state_layers[slot].Update(now);
+}
+void LEDController::draw_overlays(LEDState s){
+    for(int slot = 0; slot < STATE_SLOTS; ++slot)
+        if(overlays & (1u << slot) && slot != state_slot(s)) state_layers[slot].Draw(canvas, layer_scratch);
+}
 
-        bool radius_ok = (p.r <= static_cast<float>(ph_current_radius) + 0.01f);
-        bool angle_ok  = (ang_deg <= ph_filled_angle_deg);
+void LEDController::run_layers(LEDState s, const frame_time_t& now){
+    FrameCompositor& stack = state_layers[state_slot(s)];
+    stack.Update(now);
+    update_overlays(s, now);
+    frame_timer.Lap(FrameStage::UPDATE);
 
-        if (fully_filled || (radius_ok && angle_ok)) {
-            leds[i] = placeholderColor;
-        } else {
-            leds[i] = OFF_COLOUR;
-        }
-    }
+    canvas.Clear();
+    stack.Draw(canvas, layer_scratch);
+    draw_overlays(s);
+    frame_timer.Lap(FrameStage::DRAW);
 
-    // Push framebuffer to LEDs
+    canvas.Resolve(leds.data());
     update_leds();
-
-    // Modest frame pacing to reduce CPU
-    std::this_thread::sleep_for(std::chrono::milliseconds(20));
 }
 
-void LEDController::SetPlaceholderColor(const led_color_t& c){
-    placeholderColor = c;
-    ph_initialized = false; // force animation reset next time it runs
+bool LEDController::SetOverlay(LEDState s, bool on){
+    command_t cmd{};
+    cmd.type = command_t::Type::OVERLAY;
+    cmd.state = s;
+    cmd.on = on;
+    return queue_command(cmd);
 }
 
-#endif
+bool LEDController::SetPlaceholderColor(const led_color_t& c){
+    command_t cmd{};
+    cmd.type = command_t::Type::PLACEHOLDER_COLOR;
+    cmd.color = c;
+    return queue_command(cmd);
+}
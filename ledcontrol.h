@@ -1,6 +1,5 @@
 #pragma once
 
-#ifdef __aarch64__
 #include <thread>
 #include <queue>
 #include <mutex>
@@ -12,109 +11,40 @@
 #include <cmath>
 #include <optional>
 #include <array>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "spi.h"
+#include "ws2812.h"
+#include "led_output.h"
+#include "frame_queue.h"
+#include "command_queue.h"
+#include "frame_clock.h"
+#include "color.h"
+#include "palette.h"
+#include "splat.h"
+#include "render_buffer.h"
+#include "compositor.h"
+#include "fixture.h"
+#include "frame_stats.h"
+#include "anim_clock.h"
+#include "timeline.h"
 
 #define M_PI_F		((float)(M_PI))	
 #define RAD2DEG( x )  ( (float)(x) * (float)(180.f / M_PI_F) )
 #define DEG2RAD( x )  ( (float)(x) * (float)(M_PI_F / 180.f) )
 
 // Forward declaration
-class LEDMatrix;
+template <class Layout> class BasicLEDMatrix;
+using LEDMatrix = BasicLEDMatrix<OrbFixture>;
 
 //https://jetsonhacks.com/nvidia-jetson-agx-orin-gpio-header-pinout/
 //https://controllerstech.com/ws2812-leds-using-spi/
 
-#define LED_COUNT 61
-#define WS2812B_SPI_SPEED 2500000
-#define WS2812B_HIGH 0b11100000  //  WS2812 "1"
-#define WS2812B_LOW  0b10000000  //  WS2812 "0"
-
-struct led_color_t {
-    uint8_t r,g,b;
-
-    led_color_t operator+(const led_color_t& other) const {
-        return { static_cast<uint8_t>(std::min(255, r + other.r)), static_cast<uint8_t>(std::min(255, g + other.g)), static_cast<uint8_t>(std::min(255, b + other.b)) };
-    }
-    led_color_t operator-(const led_color_t& other) const {
-        return { static_cast<uint8_t>(std::max(0, r - other.r)), static_cast<uint8_t>(std::max(0, g - other.g)), static_cast<uint8_t>(std::max(0, b - other.b)) };
-    }
-    led_color_t operator*(float scalar) const {
-
-        return {
-            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, r * scalar))),
-            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, g * scalar))),
-            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, b * scalar)))
-        };
-    }
-    led_color_t operator/(float scalar) const {
-        return {
-            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, r / scalar))),
-            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, g / scalar))),
-            static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, b / scalar)))
-        };
-    }
-    bool operator==(const led_color_t& other) const {
-        return r == other.r && g == other.g && b == other.b;
-    }
-
-    bool operator!=(const led_color_t& other) const {
-        return !(*this == other);
-    }
-    bool operator>(const led_color_t& other) const {
-        return r > other.r && g > other.g && b > other.b;
-    }
-    bool operator<(const led_color_t& other) const {
-        return r < other.r && g < other.g && b < other.b;
-    }
-
-    bool operator>=(const led_color_t& other) const {
-        return r >= other.r && g >= other.g && b >= other.b;
-    }
-    bool operator<=(const led_color_t& other) const {
-        return r <= other.r && g <= other.g && b <= other.b;
-    }
-    bool operator<(uint8_t val) const {
-        return r < val && g < val && b < val;
-    }
-    bool operator>(uint8_t val) const {
-        return r > val && g > val && b > val;
-    }
-    bool operator==(uint8_t val) const {
-        return r == val && g == val && b == val;
-    }
-    
-    operator bool() const {
-        return r || g || b;
-    }
-};
-
-struct HSV {
-    float h; // [0,360)
-    float s; // [0,1]
-    float v; // [0,1]
-};
-
-inline led_color_t hsv2rgb(const HSV& hsv) {
-    float H = hsv.h;
-    float S = hsv.s;
-    float V = hsv.v;
-    float C = V * S;
-    float X = C * (1 - std::fabs(fmod(H/60.0f, 2) - 1));
-    float m = V - C;
-
-    float r1, g1, b1;
-    if      (H <  60) { r1 = C; g1 = X; b1 = 0; }
-    else if (H < 120) { r1 = X; g1 = C; b1 = 0; }
-    else if (H < 180) { r1 = 0; g1 = C; b1 = X; }
-    else if (H < 240) { r1 = 0; g1 = X; b1 = C; }
-    else if (H < 300) { r1 = X; g1 = 0; b1 = C; }
-    else              { r1 = C; g1 = 0; b1 = X; }
-
-    uint8_t R = static_cast<uint8_t>(std::round((r1 + m) * 255));
-    uint8_t G = static_cast<uint8_t>(std::round((g1 + m) * 255));
-    uint8_t B = static_cast<uint8_t>(std::round((b1 + m) * 255));
-    return { R, G, B };
-}
+//the controller drives the orb, other fixtures go through the templates in fixture.h
+constexpr int LED_COUNT = OrbFixture::LED_COUNT;
 
 // —— Stage 6: time functions ——
 // t ∈ [0,1] ease-in/out
@@ -143,11 +73,12 @@ struct polar_t{
     void set_angle_deg(float angle_deg){
         theta = DEG2RAD(angle_deg);
     }
-    polar_t& normalize(){
+    //theta into [0, 2pi), r into [0, max_r], the orb's outer ring by default
+    polar_t& normalize(float max_r = OrbFixture::RINGS - 1){
         while(theta >= 2.f * M_PI_F) theta -= 2.f * M_PI_F;
         while(theta < 0.f) theta += 2.f * M_PI_F;
         r = fabsf(r);
-        if(r > 4.0f) r = 4.0f;
+        if(r > max_r) r = max_r;
         return *this;
     }
     operator std::pair<float, int>() const {
@@ -173,13 +104,6 @@ struct polar_t{
     }
 };
 
-inline void encode_color(uint8_t r, uint8_t g, uint8_t b, char* buffer) {
-    for (int i = 0; i < 8; i++) {
-        buffer[i] = (g & (1 << (7 - i))) ? WS2812B_HIGH : WS2812B_LOW;
-        buffer[8 + i] = (r & (1 << (7 - i))) ? WS2812B_HIGH : WS2812B_LOW;
-        buffer[16 + i] = (b & (1 << (7 - i))) ? WS2812B_HIGH : WS2812B_LOW;
-    }
-}
 inline void encode_color(const led_color_t& c, char* buffer) {
     for (int i = 0; i < 8; i++) {
         buffer[i] = (c.g & (1 << (7 - i))) ? WS2812B_HIGH : WS2812B_LOW;
@@ -188,6 +112,22 @@ inline void encode_color(const led_color_t& c, char* buffer) {
     }
 }
 
+static_assert(sizeof(led_color_t) == 3, "encoder expects packed r,g,b");
+
+//encodes count LEDs in one pass, buffer must hold count * WS2812B_BYTES_PER_LED
+inline void encode_frame(const led_color_t* leds, size_t count, char* buffer) {
+    ws2812_encode(&leds->r, count, buffer);
+}
+//same, through gamma / brightness / per ring correction tables
+inline void encode_frame(const ws2812_calibration& cal, const led_color_t* leds, size_t count, char* buffer) {
+    ws2812_encode_calibrated(cal, &leds->r, count, buffer);
+}
+//same in any symbol encoding, buffer must hold ws2812_frame_bytes(encoding, count)
+inline void encode_frame(const ws2812_calibration& cal, ws2812_encoding encoding,
+                         const led_color_t* leds, size_t count, char* buffer) {
+    ws2812_encode_calibrated(cal, encoding, &leds->r, count, buffer);
+}
+
 
 
 struct led_action_t{
@@ -215,9 +155,6 @@ struct led_action_t{
 /*
 needs effect things (see dylans notebook for what this means lol)
 
-needs global brightness modifier 
-
-
 */
 
 #define DEFAULT_COLOR {128, 128, 128}
@@ -236,104 +173,151 @@ enum class LEDState : uint8_t {
 using LEDArray = std::array<led_color_t, LED_COUNT>;
 
 //1, 8, 12, 16, 24
-const int ring_sizes[] = {1, 8, 12, 16, 24};
-const float ring_incs[] = {0.f, 45.f, 30.f, 22.5f, 15.f};
+inline constexpr const auto& ring_sizes = OrbFixture::sizes;
+inline constexpr const auto& ring_incs = OrbFixture::incs;
 
 inline float ringunit(int ring, float mul){
     return ((ring_incs[ring] - 0.6) * mul);
 }
 
-class LEDRingBase{
+//set_led semantics: a color adds onto the LED (clamped), black clears it
+inline void blend_led(led_color_t& led, led_color_t color){
+    led = color ? led + color : color;
+}
+
+//first LED of a ring in the frame. the chain runs from the outer ring inwards,
+//so ring 4 is LEDs 0..23 and the center is the last LED
+constexpr int ring_offset(int ring){
+    return OrbFixture::offsets[ring];
+}
+
+//polar position of every LED in physical frame order (outer ring first,
+//center last), the order LEDMatrix frames and RenderBuffer use
+template <class Layout>
+constexpr std::array<polar_t, Layout::LED_COUNT> make_led_lut(){
+    std::array<polar_t, Layout::LED_COUNT> lut{};
+    for(int i = 0; i < Layout::LED_COUNT; ++i)
+        lut[Layout::led_frame[i]] = polar_t{ Layout::led_theta[i], static_cast<float>(Layout::led_ring[i]) };
+    return lut;
+}
+
+//non-owning view of one ring inside a LEDMatrix frame
+class LEDRingView {
 public:
-    LEDRingBase(int index) : index(index) {
+    LEDRingView() = default;
+    LEDRingView(int index, int count, led_color_t* data) : index(index), count(count), data(data) {
     }
 
-    virtual void Update(LEDArray& leds) = 0;
+    int Count() const { return count; }
+    int Index() const { return index; }
+    led_color_t* Data() const { return data; }
+    led_color_t& operator[](int idx) const { return data[idx]; }
 
-    virtual const int Count() const = 0;
-    const auto Index() const {
-        return index;
+    void set_led(int idx, led_color_t color) const {
+        if(idx < 0 || idx >= count) throw std::out_of_range("LED index out of range");
+        blend_led(data[idx], color);
     }
-    virtual void clear(led_color_t clr = {0,0,0}) = 0;
-    virtual void set_led(int idx, led_color_t color) = 0;
-protected:
-    const int index;
+    void clear(led_color_t clr = {0,0,0}) const {
+        std::fill(data, data + count, clr);
+    }
+private:
+    int index = 0;
+    int count = 0;
+    led_color_t* data = nullptr;
 };
 
-template <std::size_t N>
-class LEDRing : public LEDRingBase {
-public:
-    LEDRing(int index) : LEDRingBase(index), led_count(leds.size()) {
-        start_idx = 0;
-        for(int i = 0; i < index; ++i)
-            start_idx += ring_sizes[i];
-        end_idx = start_idx + N;
-        assert(end_idx <= LED_COUNT);
-
-        //flip indices 
-        int temp = start_idx;
-        start_idx = LED_COUNT - end_idx;
-        end_idx = LED_COUNT - temp;
-        printf("Ring[%d] %d: %d - %d\n", index, led_count, start_idx, end_idx);
-        
-        for(auto& led : leds)
-            led = {125,125,125};// generate_random_color();
-    }
+struct animLED{
+    polar_t origin;
+    led_color_t color;
+};
 
-    const int Count() const override { return led_count; }
+/*
+(angle, radius) -> (ring, led) without normalisation loops or divisions.
 
+the angle is cut into the layout's ANGLE_STEPS quanta, a multiple of 2 * every
+ring size so each ring's rounding boundaries fall exactly on a quantum edge,
+and the table holds the LED polar_to_ring(polar_t) would pick for that
+quantum. the radius only needs |r|, a clamp and a round, so that stays
+arithmetic. the tables are generated at compile time per layout.
+*/
+struct polar_index_t {
+    uint8_t ring;
+    uint8_t led;
+};
 
-    void Update(LEDArray& all) override {
-        for(int i = start_idx; i < end_idx; ++i){
-            if(index == 4) all[i] = leds[i - start_idx] * 0.37f;
-            else if(index == 3) all[i] = leds[i - start_idx] * 1.66f;
-            else all[i] = leds[i - start_idx];
+template <class Layout>
+class BasicPolarIndex {
+public:
+    static constexpr int ANGLE_STEPS = Layout::ANGLE_STEPS;
+    static constexpr int RINGS = Layout::RINGS;
+
+    constexpr BasicPolarIndex() {
+        for(int ring = 0; ring < RINGS; ++ring){
+            const int n = Layout::sizes[ring];
+            for(int q = 0; q < ANGLE_STEPS; ++q){
+                //round(q * n / ANGLE_STEPS), halves up like std::round on positives
+                int led = ring == 0 ? 0 : (2 * q * n + ANGLE_STEPS) / (2 * ANGLE_STEPS);
+                if(led == n) led = 0;
+                table[ring][q] = static_cast<uint8_t>(led);
+                frame[ring][q] = static_cast<uint8_t>(Layout::offsets[ring] + led);
+            }
         }
-
     }
-
-
-    void set_led(int idx, led_color_t color) override {
-        if(idx < 0 || idx >= N) throw std::out_of_range("LED index out of range");
-        if(color)
-            leds[idx] = leds[idx] + color;
-        else 
-            leds[idx] = color;
+    polar_index_t operator()(polar_t p) const {
+        int ring = ring_of(p.r);
+        return { static_cast<uint8_t>(ring), table[ring][quantum(p.theta)] };
+    }
+    //the same LED as an index into the physical frame
+    int Frame(polar_t p) const {
+        int ring = ring_of(p.r);
+        return frame[ring][quantum(p.theta)];
     }
 
-    void clear(led_color_t clr = {0,0,0}) override {
-        for(auto& led : leds)
-            led = clr;
+private:
+    static int ring_of(float r){
+        r = std::fabs(r);
+        return r < 0.5f ? 0 : std::min(RINGS - 1, static_cast<int>(r + 0.5f));
     }
-protected:
-    const int led_count;
-    int start_idx;
-    int end_idx;
-    std::array<led_color_t, N> leds; 
+    static int quantum(float theta){
+        int q = static_cast<int>(std::floor(theta * (ANGLE_STEPS / (2.f * M_PI_F)))) % ANGLE_STEPS;
+        return q < 0 ? q + ANGLE_STEPS : q;
+    }
+
+    uint8_t table[RINGS][ANGLE_STEPS] = {};
+    uint8_t frame[RINGS][ANGLE_STEPS] = {};
 };
 
-class LEDMatrix {
+template <class Layout>
+inline constexpr BasicPolarIndex<Layout> polar_index_v{};
+
+using PolarIndex = BasicPolarIndex<OrbFixture>;
+inline const PolarIndex& polar_index(){
+    return polar_index_v<OrbFixture>;
+}
+
+template <class Layout>
+class BasicLEDMatrix {
 public:
-    LEDMatrix() {
-        this->rings = {
-            std::make_unique<LEDRing<1>>(0),
-            std::make_unique<LEDRing<8>>(1),
-            std::make_unique<LEDRing<12>>(2),
-            std::make_unique<LEDRing<16>>(3),
-            std::make_unique<LEDRing<24>>(4),
-        };
-        set_all({0,0,0});
+    static constexpr int RINGS = Layout::RINGS;
+    using frame_t = std::array<led_color_t, Layout::LED_COUNT>;
+
+    //one frame in physical order, rings are views into it
+    BasicLEDMatrix() {
+        frame.fill({0,0,0});
+        for(int i = 0; i < RINGS; ++i)
+            rings[i] = LEDRingView(i, Layout::sizes[i], frame.data() + Layout::offsets[i]);
     }
+    //the ring views point into this matrix's own frame
+    BasicLEDMatrix(const BasicLEDMatrix&) = delete;
+    BasicLEDMatrix& operator=(const BasicLEDMatrix&) = delete;
 
-    void Clear(LEDArray& leds, led_color_t clr = {0,0,0}){
-        for(auto& ring : rings){
-            ring->clear(clr);
-        }
+    void Clear(frame_t& leds, led_color_t clr = {0,0,0}){
+        frame.fill(clr);
         this->Update(leds);
     }
     //returns ring index, led index within ring 
     std::pair<int, int> polar_to_ring(float angle_deg, int radius){
-        if(std::abs(radius) > 4) return {0xffff, 0xffff};
+        if(std::abs(radius) > RINGS - 1) return {0xffff, 0xffff};
         if(radius == 0) return {0, 0};
         if(angle_deg >= 360.f){
             while(angle_deg >= 360.f) angle_deg -= 360.f;
@@ -344,7 +328,7 @@ public:
 
         int ring = abs(radius); 
         float angle = DEG2RAD(angle_deg);
-        float led_idx_f = (angle / (2.f * M_PI_F) ) * (ring_sizes[ring] - 1);
+        float led_idx_f = (angle / (2.f * M_PI_F) ) * (Layout::sizes[ring] - 1);
        
         int led = static_cast<int>(std::round(led_idx_f));
 
@@ -352,24 +336,24 @@ public:
         return {ring, led};
     }
     std::pair<int, int> polar_to_ring(polar_t coords){
-        if(std::abs(coords.r) > 4.0f) return {0xffff, 0xffff};
+        if(std::abs(coords.r) > RINGS - 1) return {0xffff, 0xffff};
         if(coords.r < 0.5f) return {0, 0};  // Consider values less than 0.5 as center
-        coords.normalize();
+        coords.normalize(RINGS - 1);
 
         int ring = static_cast<int>(std::round(coords.r)); 
-        ring = std::min(4, std::max(0, ring)); // Clamp to valid range
+        ring = std::min(RINGS - 1, std::max(0, ring)); // Clamp to valid range
        
-        float led_idx_f = (coords.theta / (2.f * M_PI_F) ) * ( static_cast<float>(ring_sizes[ring]));
+        float led_idx_f = (coords.theta / (2.f * M_PI_F) ) * ( static_cast<float>(Layout::sizes[ring]));
        
         int led = static_cast<int>(std::round(led_idx_f) );
-        if(led != 0 && led == ring_sizes[ring]) led = 0;
+        if(led != 0 && led == Layout::sizes[ring]) led = 0;
 
         //printf("angle: %f, radius: %f, ring: %d, led: %d\n", RAD2DEG(coords.theta), coords.r, ring, led); 
         return {ring, led};
     }
     std::pair<int, int> grid_to_ring(int x, int y) {
         if(x == 0 && y == 0) return {0, 0};
-        if(std::abs(x) > 4 || std::abs(y) > 4) return {0xffff, 0xffff};
+        if(std::abs(x) > RINGS - 1 || std::abs(y) > RINGS - 1) return {0xffff, 0xffff};
 
         float theta = atan2(y, x);
 
@@ -379,14 +363,11 @@ public:
         return polar_to_ring(RAD2DEG(theta), radius);
     }
 
-    void Update(LEDArray& leds) {
-
-        for(auto& ring : rings){
-            ring->Update(leds);
-        }
-
-
+    void Update(frame_t& leds) {
+        leds = frame;
     }
+    const frame_t& Frame() const { return frame; }
+    const LEDRingView& Ring(int ring) const { return rings[ring]; }
 
 
     void set_led(float angle_deg, int radius, led_color_t color){
@@ -394,7 +375,7 @@ public:
         if(ring == 0xffff || led == 0xffff) {
             throw std::out_of_range("Invalid coords: " + std::to_string(angle_deg) + ", " + std::to_string(radius));
         }
-        rings[ring]->set_led(led, color);
+        rings[ring].set_led(led, color);
     }
 
     void set_led(float angle_deg, float radius, led_color_t color){
@@ -404,13 +385,128 @@ public:
 
     void set_led(polar_t coords, led_color_t color){
         // Ensure coords are normalized before processing
-        coords.normalize();
+        coords.normalize(RINGS - 1);
         auto [ring, led] = polar_to_ring(coords);
         if(ring == 0xffff || led == 0xffff){
             printf("Invalid coords: %f, %f\n", RAD2DEG(coords.theta), coords.r);
             return;
         }
-        rings[ring]->set_led(led, color);
+        rings[ring].set_led(led, color);
+    }
+
+    //batch set_led(polar_t): count points through the polar index, straight into the frame
+    void set_leds(const polar_t* coords, const led_color_t* colors, size_t count){
+        const auto& index = polar_index_v<Layout>;
+        for(size_t i = 0; i < count; ++i)
+            blend_led(frame[index.Frame(coords[i])], colors[i]);
+    }
+    //draws a sprite: each LED at origin + its own offset
+    void set_leds(polar_t origin, const animLED* sprite, size_t count){
+        const auto& index = polar_index_v<Layout>;
+        for(size_t i = 0; i < count; ++i)
+            blend_led(frame[index.Frame(origin + sprite[i].origin)], sprite[i].color);
+    }
+
+    /*
+    clipped rasterizer, none of it throws or allocates. LED i of a ring sits at
+    i * inc degrees and owns half an inc either side of it. shapes are drawn
+    straight from each ring's index range, so every covered LED is visited
+    once and the cost is the LEDs touched; rings outside the fixture are
+    skipped. colors blend like set_led. with aa the edge LEDs get the color
+    scaled by how much of them the shape covers (a black color always
+    clears whole LEDs). each returns the number of LEDs written.
+    */
+
+    //one LED, or with aa split between the two LEDs either side of the angle
+    int draw_point(float angle_deg, int ring, led_color_t color, bool aa = false) noexcept {
+        if(ring < 0 || ring >= RINGS || !std::isfinite(angle_deg)) return 0;
+        const int n = Layout::sizes[ring];
+        const LEDRingView& view = rings[ring];
+        if(n == 1){
+            blend_led(view[0], color);
+            return 1;
+        }
+        float x = std::fmod(angle_deg, 360.f) / Layout::incs[ring];
+        if(!aa || !color){
+            blend_led(view[wrap(static_cast<int>(std::floor(x + 0.5f)), n)], color);
+            return 1;
+        }
+        int i = static_cast<int>(std::floor(x));
+        float f = x - static_cast<float>(i);
+        return plot(view, wrap(i, n), color, 1.f - f) + plot(view, wrap(i + 1, n), color, f);
+    }
+    //radius rounds to the nearest ring, past the outer ring is clipped
+    int draw_point(polar_t p, led_color_t color, bool aa = false) noexcept {
+        float r = std::fabs(p.r);
+        if(!(r < RINGS - 0.5f)) return 0;
+        return draw_point(RAD2DEG(p.theta), static_cast<int>(r + 0.5f), color, aa);
+    }
+
+    //every LED of a ring
+    int draw_ring(int ring, led_color_t color) noexcept {
+        if(ring < 0 || ring >= RINGS) return 0;
+        const LEDRingView& view = rings[ring];
+        for(int i = 0; i < view.Count(); ++i) blend_led(view[i], color);
+        return view.Count();
+    }
+
+    //span_deg of ring from start_deg (negative spans run clockwise); without
+    //aa the LEDs whose centers fall inside it, ends included
+    int draw_arc(int ring, float start_deg, float span_deg, led_color_t color, bool aa = false) noexcept {
+        if(ring < 0 || ring >= RINGS || !std::isfinite(start_deg) || !std::isfinite(span_deg)) return 0;
+        if(span_deg < 0.f){
+            start_deg += span_deg;
+            span_deg = -span_deg;
+        }
+        const int n = Layout::sizes[ring];
+        if(n == 1 || span_deg >= 360.f) return draw_ring(ring, color);
+        const LEDRingView& view = rings[ring];
+        const float inc = Layout::incs[ring];
+        //the arc in LED units, from a to b
+        const float a = std::fmod(start_deg, 360.f) / inc;
+        const float b = a + span_deg / inc;
+        if(!aa || !color){
+            constexpr float eps = 1e-4f;    //angles that land on a center by arithmetic count as on it
+            int first = static_cast<int>(std::ceil(a - eps));
+            int count = std::min(n, static_cast<int>(std::floor(b + eps)) - first + 1);
+            for(int k = 0, i = wrap(first, n); k < count; ++k, i = i + 1 == n ? 0 : i + 1)
+                blend_led(view[i], color);
+            return std::max(count, 0);
+        }
+        //LED i covers [i - 0.5, i + 0.5), the ends are the LEDs a and b fall in.
+        //a span under 360 covers at most n + 1 of them, the last one then
+        //being the first LED again, so its share folds into the first
+        const int first = static_cast<int>(std::floor(a + 0.5f));
+        const int last = static_cast<int>(std::floor(b + 0.5f));
+        auto cover = [&](int i){
+            return std::min(b, i + 0.5f) - std::max(a, i - 0.5f);
+        };
+        const int count = std::min(n, last - first + 1);
+        int written = 0;
+        for(int k = 0, i = first; k < count; ++k, ++i){
+            float c = cover(i);
+            if(k == 0 && last - first + 1 > n) c += cover(last);
+            written += plot(view, wrap(i, n), color, c);
+        }
+        return written;
+    }
+
+    //a pie slice over rings r0..r1, the center is included when r0 is 0
+    int draw_wedge(float start_deg, float span_deg, int r0, int r1, led_color_t color, bool aa = false) noexcept {
+        if(r0 > r1) std::swap(r0, r1);
+        int written = 0;
+        for(int ring = std::max(r0, 0); ring <= std::min(r1, RINGS - 1); ++ring)
+            written += draw_arc(ring, start_deg, span_deg, color, aa);
+        return written;
+    }
+
+    //a spoke from ring r0 out to r1 at one angle, one LED per ring (two with aa)
+    int draw_line(float angle_deg, int r0, int r1, led_color_t color, bool aa = false) noexcept {
+        if(r0 > r1) std::swap(r0, r1);
+        int written = 0;
+        for(int ring = std::max(r0, 0); ring <= std::min(r1, RINGS - 1); ++ring)
+            written += draw_point(angle_deg, ring, color, aa);
+        return written;
     }
 
     void set_all(led_color_t color){
@@ -421,28 +517,32 @@ public:
                   set_all_count, color.r, color.g, color.b);
         }
         
-        for(auto& ring : rings){
-            for(int i = 0; i < ring->Count(); ++i){
-                ring->set_led(i, color);
-            }
-        }
+        for(auto& led : frame)
+            blend_led(led, color);
     }
 
 protected:
-    std::array<std::unique_ptr<LEDRingBase>, 5> rings;
-};
+    frame_t frame;
+    std::array<LEDRingView, RINGS> rings;
 
-struct animLED{
-    polar_t origin;
-    led_color_t color;
+private:
+    static int wrap(int i, int n) noexcept {
+        i %= n;
+        return i < 0 ? i + n : i;
+    }
+    //color scaled by coverage, nothing if that rounds to black
+    static int plot(const LEDRingView& view, int i, led_color_t color, float coverage) noexcept {
+        led_color_t c = color * std::min(coverage, 1.f);
+        if(!c) return 0;
+        blend_led(view[i], c);
+        return 1;
+    }
 };
 
 class Animatable{
 public:
-    Animatable() {
-        start = std::chrono::high_resolution_clock::now();
-    }
-    virtual void Update() = 0;
+    //advance to the frame's time, see anim_clock.h
+    virtual void Update(const frame_time_t& now) = 0;
     virtual void Draw(LEDMatrix* matrix) = 0;
     virtual ~Animatable() = default;
 
@@ -459,10 +559,19 @@ public:
         return origin;
     }
     
-    // Make start time accessible for fusion calculations
-    std::chrono::time_point<std::chrono::high_resolution_clock> start;
-    
+    // Seconds since the first Update() after construction or Restart()
+    float Elapsed(const frame_time_t& now){
+        if(!started){
+            start_ns = now.now_ns;
+            started = true;
+        }
+        return now.Since(start_ns);
+    }
+    void Restart(){ started = false; }
+
 protected:
+    int64_t start_ns = 0;
+    bool started = false;
     std::vector<animLED> leds;
     polar_t origin;
 };
@@ -520,15 +629,14 @@ class Orb : public Animatable{
             }
             mul *= mulmul;
         }
-        last_update = std::chrono::high_resolution_clock::now();
     }
 
-    void Update() override {
-        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - last_update).count();
-        if(us < 2000) return; //smoothing this would be nice
-        last_update = std::chrono::high_resolution_clock::now();
+    // The speed ramps and rotation below are tuned per STEP of time
+    static constexpr float STEP = 0.005f;
 
-       uint64_t delta_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    void Update(const frame_time_t& now) override {
+        const float steps = now.dt / STEP;
+        uint64_t delta_ms = static_cast<uint64_t>(Elapsed(now) * 1000.f);
         
         
         float scale = exp((rot_speed * 0.0001f) / max_speed);
@@ -540,12 +648,12 @@ class Orb : public Animatable{
         const uint64_t hold_time = 2500;
         if(!speed_up && delta_ms > (hold_time + last_speedchange) && std::abs(rot_speed) > base_speed){
               
-            rot_speed *= (imul);
+            rot_speed *= std::pow(imul, steps);
             //printf("not speed up: %f \n", rot_speed);
         }
         else if(speed_up && delta_ms > (hold_time + last_speedchange) && std::abs(rot_speed) < max_speed){
           
-            rot_speed *= (mul);
+            rot_speed *= std::pow(mul, steps);
             //printf("speed up %f \n", rot_speed);
         }
         if((rot_speed <= base_speed || std::abs(rot_speed) > max_speed) && delta_ms > (hold_time + last_speedchange)){
@@ -556,7 +664,7 @@ class Orb : public Animatable{
            // printf("speed change: %f, %d, %lu\n", rot_speed, speed_up, last_speedchange);
         }
 
-       this->origin.rotate_deg(rot_speed * m);
+       this->origin.rotate_deg(rot_speed * m * steps);
        
        // Update all LED colors if the main color has changed
        if (color != prev_color) {
@@ -592,10 +700,7 @@ class Orb : public Animatable{
     }
     
     void Draw(LEDMatrix* matrix) override {
-        for(auto& led : leds){
-            auto real_pos = origin + led.origin;
-            matrix->set_led(real_pos, led.color);
-        }
+        matrix->set_leds(origin, leds.data(), leds.size());
     }
     
     // Set the orb's color and update all LEDs
@@ -612,7 +717,6 @@ class Orb : public Animatable{
     float rot_speed = max_speed;
     bool speed_up = false;
     uint64_t last_speedchange = 0;
-    std::chrono::time_point<std::chrono::high_resolution_clock> last_update;
     float m = 1.f;
 };
 
@@ -630,7 +734,6 @@ class Glow : public Animatable{
         }
         current_size = 0.f;
         inc = 0.015f;
-        last_update = std::chrono::high_resolution_clock::now();
     }
     void set_ring(int ring, led_color_t color){
         int idx = 1;
@@ -641,21 +744,21 @@ class Glow : public Animatable{
             leds[idx + i].color = color;
         }
     }
-    void Update() override {
+    // inc is the pulse's growth per STEP of time
+    static constexpr float STEP = 0.01f;
+
+    void Update(const frame_time_t& now) override {
         for(auto& led : leds){
             led.color = min_color;
         }
      //   leds[0].color = base_color; 
-        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - last_update).count();
-        if(us < 800) return; //smoothing this would be nice
-        last_update = std::chrono::high_resolution_clock::now();
         led_color_t dif = base_color - min_color;
         for(int i = 0; i < std::round(current_size + 0.5f); ++i){
             float mul = ((current_size - i) / (float)max_size) + (min_color.r / 255.f);
             //if(i < 2) mul = std::max(1.f, mul * (3 - i));
             set_ring(i , base_color * mul); 
         }
-        current_size += inc;
+        current_size += inc * (now.dt / STEP);
         if(current_size >= (float)max_size) { inc = inc * -1.f; current_size = ((float)(max_size) - 0.01); pulses++; }
         if(current_size <= 0.f) { inc = inc * -1.f; current_size = 0.001f; pulses++; }
       //  printf("Glow: %f - inc: %f\n", current_size, inc);
@@ -663,10 +766,7 @@ class Glow : public Animatable{
       // this->origin.rotate_deg(1.f);
     }
     void Draw(LEDMatrix* matrix) override {
-        for(auto& led : leds){
-            auto real_pos = origin + led.origin;
-            matrix->set_led(real_pos, led.color);
-        }
+        matrix->set_leds(origin, leds.data(), leds.size());
     }
 
     led_color_t base_color;
@@ -675,21 +775,30 @@ class Glow : public Animatable{
     float current_size;
     float inc;
     int pulses = 0;
-     std::chrono::time_point<std::chrono::high_resolution_clock> last_update;
 };
 
-//helper for ang diff
-static float angularDifference(float a, float b) {
-    // Normalize angles to [0, 2π) if not already
-    while (a < 0) a += 2.0f * M_PI_F;
-    while (a >= 2.0f * M_PI_F) a -= 2.0f * M_PI_F;
-    while (b < 0) b += 2.0f * M_PI_F;
-    while (b >= 2.0f * M_PI_F) b -= 2.0f * M_PI_F;
-    
-    float d = fabs(a - b);
-    d = fmod(d, 2.0f * M_PI_F);
-    return (d > M_PI_F) ? (2.0f * M_PI_F - d) : d;
-}
+//what the Gaussian renderers need from a layout: every LED's polar position
+//and the splat tables, both in physical frame order. one table per sigma and
+//layout, built on first use and shared between everything drawing on it
+template <class Layout>
+class FixtureRender {
+public:
+    static constexpr std::array<polar_t, Layout::LED_COUNT> led_lut = make_led_lut<Layout>();
+
+    static const SplatTable& Splat(float sigma){
+        static std::mutex mtx;
+        static std::vector<std::unique_ptr<SplatTable>> tables;
+        std::lock_guard<std::mutex> lock(mtx);
+        for(auto& t : tables)
+            if(t->Sigma() == sigma) return *t;
+        tables.push_back(std::make_unique<SplatTable>(sigma, led_lut.data(), led_lut.size()));
+        return *tables.back();
+    }
+};
+
+using OrbRender = FixtureRender<OrbFixture>;
+//the orb's splat table for sigma, look it up once and keep the reference
+inline const SplatTable& orb_splat(float sigma){ return OrbRender::Splat(sigma); }
 
 // Improved TransitionSpiral class with Gaussian blending
 class TransitionSpiral : public Animatable {
@@ -705,57 +814,34 @@ public:
     
     // Improved HSV interpolation function
     static HSV interpolateHSV(const HSV& a, const HSV& b, float t) {
-        // Handle hue specially to find shortest path around the circle
-        float h_diff = b.h - a.h;
-        
-        // Adjust for wrap-around
-        if (h_diff > 180.0f) h_diff -= 360.0f;
-        else if (h_diff < -180.0f) h_diff += 360.0f;
-        
-        float h = a.h + (h_diff * t);
-        // Normalize h to [0, 360)
-        while (h >= 360.0f) h -= 360.0f;
-        while (h < 0.0f) h += 360.0f;
-        
-        return HSV{
-            h,
-            a.s + (b.s - a.s) * t,
-            a.v + (b.v - a.v) * t
-        };
+        return hsv_lerp(a, b, t);
     }
     
-    // Constructor with HSV palettes
-    TransitionSpiral(const std::array<HSV,3>& from,
-                     const std::array<HSV,3>& to,
-                     float duration = 1.8f)
-    : hsv_from(from), hsv_to(to), phase(IN), t_phase(0.0f) {
-        last_update = std::chrono::high_resolution_clock::now();
-        
-        // Set unique rotation speeds for each orb for more dynamic movement
-        orb_speeds = {320.0f, 340.0f, 300.0f};
-        
-        // Set Gaussian parameters for each orb
-        sigma = {1.0f, 1.0f, 1.0f};       // Gaussian blur radius
-        intensity = {0.9f, 0.9f, 0.9f};   // Intensity - higher than in active state
-        
-        // Initialize orbs at 120 degrees apart at radius 3 (outer ring)
+    // The orbs, ramps and render buffer live as long as the spiral, Start()
+    // only resets them, so a transition never allocates
+    TransitionSpiral()
+    : ramps{Gradient(HSV{}, HSV{}), Gradient(HSV{}, HSV{}), Gradient(HSV{}, HSV{})},
+      orbs{Orb(4, {0,0,0}, polar_t::Degrees(0.f, 3)), Orb(4, {0,0,0}, polar_t::Degrees(120.f, 3)),
+           Orb(4, {0,0,0}, polar_t::Degrees(240.f, 3))},
+      phase(DONE), t_phase(0.0f) {
+        build_timeline();
+    }
+
+    // Start a transition between two HSV palettes
+    void Start(const std::array<HSV,3>& from, const std::array<HSV,3>& to) {
+        hsv_from = from;
+        hsv_to = to;
+        phase = IN;
+        t_phase = 0.0f;
+        blend = 0.0f;
+        blend_base = 0.0f;
+        Restart();  // the timeline starts at the next Update()
+
+        // Orbs start 120 degrees apart on ring 3 in their source colours
         for(int k = 0; k < 3; ++k) {
-            // Start at radius 3 (standard outer orbit radius) for consistency
-            orbs.emplace_back(std::make_unique<Orb>(4, hsv2rgb(hsv_from[k]), polar_t::Degrees(k * 120.f, 3)));
-            
-            // Customize each orb's rotation speed slightly for variation
-            Orb* orbPtr = dynamic_cast<Orb*>(orbs[k].get());
-            orbPtr->rot_speed = orb_speeds[k];
-            orbPtr->max_speed = orb_speeds[k] * 1.2f;
-        }
-        
-        // Set phase start times for timing progress
-        phase_start_time = std::chrono::high_resolution_clock::now();
-        this->dt = 0.0f;
-        
-        // Record initial positions for animation
-        for (int i = 0; i < 3; i++) {
-            initial_positions.push_back(dynamic_cast<Orb*>(orbs[i].get())->GetOrigin());
+            orbs[k].SetOrigin(polar_t::Degrees(k * 120.f, 3));
+            orbs[k].SetColor(hsv2rgb(hsv_from[k]));
+            ramps[k].Assign(hsv_from[k], hsv_to[k]);
         }
     }
 
@@ -775,212 +861,48 @@ public:
     }
 
     bool finished() const { return phase == DONE; }
-    
-    void Update() override {
-        // advance t_phase based on elapsed time
-        auto now = std::chrono::high_resolution_clock::now();
-        dt = std::chrono::duration<float>(now - last_update).count();
-        last_update = now;
-        t_phase += dt;
-        
-        // Update phase based on timing
-        bool phase_changed = false;
-        switch(phase) {
-            case IN:
-                if (t_phase >= T_in) { 
-                    phase = FUSION; 
-                    t_phase = 0.0f; 
-                    phase_changed = true;
-                }
-                break;
-            case FUSION:
-                if (t_phase >= T_fusion) { 
-                    phase = FLASH; 
-                    t_phase = 0.0f; 
-                    phase_changed = true;
-                }
-                break;
-            case FLASH:
-                if (t_phase >= T_flash) { 
-                    phase = EXPANSION; 
-                    t_phase = 0.0f; 
-                    phase_changed = true;
-                }
-                break;
-            case EXPANSION:
-                if (t_phase >= T_expansion) { 
-                    phase = OUT; 
-                    t_phase = 0.0f; 
-                    phase_changed = true;
-                }
-                break;
-            case OUT:
-                if (t_phase >= T_out) { 
-                    phase = DONE; 
-                    phase_changed = true;
-                }
-                break;
-            default:
-                break;
-        }
-        
-        if (phase_changed) {
-            phase_start_time = std::chrono::high_resolution_clock::now();
+
+    // Palette the orbs show right now
+    std::array<HSV,3> Current() const {
+        std::array<HSV,3> hsv;
+        for(int k = 0; k < 3; ++k) hsv[k] = hsv_lerp(hsv_from[k], hsv_to[k], ramp_pos(blend));
+        return hsv;
+    }
+
+    // Turn towards a new palette mid-flight: the colours continue from what is
+    // shown now and reach `to` when the transition ends. Too close to the end
+    // to blend in what's left, the spiral starts over from the current colours
+    void Retarget(const std::array<HSV,3>& to) {
+        std::array<HSV,3> from = Current();
+        if(1.f - blend < 0.1f){
+            Start(from, to);
+            return;
         }
+        hsv_from = from;
+        hsv_to = to;
+        blend_base = blend;
+        for(int k = 0; k < 3; ++k) ramps[k].Assign(hsv_from[k], hsv_to[k]);
+    }
+    
+    void Update(const frame_time_t& now) override {
+        float t = Elapsed(now);
+        timeline.Evaluate(t);
 
-        // Calculate overall transition progress (0.0 - 1.0)
-        float totalDuration = T_in + T_fusion + T_flash + T_expansion + T_out;
-        float elapsedTime = std::chrono::duration<float>(now - start).count();
-        float overallProgress = std::min(1.0f, elapsedTime / totalDuration);
-        
-        // Get normalized time within the current phase (0-1)
-        float t_norm = getNormalizedTime();
-        
-        // Apply easing for smoother animation
-        float e = easeInOut(t_norm);
-        
-        // Calculate distance between orbs for fusion effect
-        bool close_enough_for_fusion = false;
-        if (phase >= FUSION) {
-            close_enough_for_fusion = true;
-        } else if (phase == IN && t_norm > 0.7f) {
-            // During late IN phase, check if orbs are close enough
-            auto c0 = dynamic_cast<Orb*>(orbs[0].get())->GetOrigin();
-            auto c1 = dynamic_cast<Orb*>(orbs[1].get())->GetOrigin();
-            auto c2 = dynamic_cast<Orb*>(orbs[2].get())->GetOrigin();
-            
-            auto sep = [](const polar_t &a, const polar_t &b){
-                // Euclid dist in LED units
-                float dθ = angularDifference(a.theta, b.theta);
-                float r̄  = (a.r + b.r) * 0.5f;
-                float Δr  = a.r - b.r;
-                return sqrtf((dθ*r̄)*(dθ*r̄) + Δr*Δr);
-            };
-            
-            float sep01 = sep(c0, c1);
-            float sep12 = sep(c1, c2);
-            float sep20 = sep(c2, c0);
-            
-            close_enough_for_fusion = (sep01 < 0.5f && sep12 < 0.5f && sep20 < 0.5f);
+        // The phase is only a name for where t falls, the motion is all in the timeline
+        if (timeline.Done(t)) {
+            phase = DONE;
+        } else {
+            int p = 0;
+            while (p < OUT && t >= phase_ends[p]) ++p;
+            phase = static_cast<Phase>(p);
+            t_phase = t - (p > 0 ? phase_ends[p - 1] : 0.f);
         }
 
-        // Update each orb
-        for(size_t k = 0; k < orbs.size(); ++k) {
-            Orb* orb = dynamic_cast<Orb*>(orbs[k].get());
-            
-            // Base positioning based on phase
-            float start_angle = initial_positions[k].theta;
-            float current_radius = 3.0f;  // Default outer ring radius
-            float target_angle = start_angle;
-            float color_blend = 0.0f;     // How much to blend from source to target color
-            
-            if (phase == IN) {
-                // During IN phase: initial rotation where orbs move toward each other
-                // Create a dynamic rotational movement
-                float base_speed = orb_speeds[k] * 0.5f;
-                float angle_offset = base_speed * t_norm;
-                
-                // Orbs start moving toward meeting point (gradually slowing down)
-                float meetingPoint = 0.0f;  // Center angle for all orbs to approach
-                float approach_factor = std::pow(t_norm, 2);  // Accelerates toward end
-                
-                // Blend from initial angle toward meeting point
-                target_angle = start_angle + angle_offset * (1.0f - approach_factor);
-                target_angle += (meetingPoint - start_angle) * approach_factor;
-                
-                // Keep radius at 3.0 during most of IN phase
-                current_radius = 3.0f;
-                
-                // Begin color transition during IN phase (first 30%)
-                color_blend = 0.3f * t_norm;
-            } 
-            else if (phase == FUSION) {
-                // During FUSION: orbs spiral inward to center
-                float spiral_factor = e;  // Ease-in-out for smoother spiral
-                
-                // Gradually reduce radius from 3.0 to 0.5
-                current_radius = mixf(3.0f, 0.5f, spiral_factor);
-                
-                // Increase rotation as orbs get closer to center
-                float rotation_speed = mixf(1.0f, 3.0f, spiral_factor);
-                target_angle = start_angle + rotation_speed * 120.0f * spiral_factor;
-                
-                // Continue color transition (30% to 60%)
-                color_blend = 0.3f + (0.3f * e);
-            }
-            else if (phase == FLASH) {
-                // During FLASH phase: orbs are at center, pulsing
-                current_radius = 0.2f;
-                
-                // Slight rotation at center
-                target_angle = start_angle + t_norm * 30.0f;
-                
-                // Mid-point of color transition (60%)
-                color_blend = 0.6f;
-            }
-            else if (phase == EXPANSION) {
-                // During EXPANSION: orbs spiral outward from center
-                float expansion_factor = e;
-                
-                // Gradually increase radius from 0.5 to 3.0
-                current_radius = mixf(0.5f, 3.0f, expansion_factor);
-                
-                // Rotation decreases as orbs move outward
-                float rotation_speed = mixf(3.0f, 1.0f, expansion_factor);
-                target_angle = start_angle + 150.0f + rotation_speed * 120.0f * (1.0f - expansion_factor);
-                
-                // Continue color transition (60% to 90%)
-                color_blend = 0.6f + (0.3f * e);
-            }
-            else if (phase == OUT) {
-                // During OUT phase: orbs continue rotation at their final positions
-                // Create a dynamic rotational movement
-                float base_speed = orb_speeds[k] * 0.5f;
-                float angle_offset = base_speed * t_norm;
-                
-                // Target positions for each orb (120 degrees apart)
-                float targetAngle = k * 120.0f;
-                float approach_factor = std::pow(t_norm, 2);  // Accelerates toward end
-                
-                // Blend from current angle toward final position
-                target_angle = (start_angle + 270.0f) + angle_offset * (1.0f - approach_factor);
-                target_angle += (targetAngle - (start_angle + 270.0f)) * approach_factor;
-                
-                // Keep radius at 3.0 during OUT phase
-                current_radius = 3.0f;
-                
-                // Complete color transition (90% to 100%)
-                color_blend = 0.9f + (0.1f * t_norm);
-            }
-            
-            // Normalize angle to valid range
-            while (target_angle >= 360.0f) target_angle -= 360.0f;
-            while (target_angle < 0.0f) target_angle += 360.0f;
-            
-            // Special case for FUSION phase: check if orbs should spiral inward
-            if (phase == IN && close_enough_for_fusion && t_norm > 0.8f) {
-                // Begin spiral toward center
-                float spiral_progress = (t_norm - 0.8f) / 0.2f;
-                current_radius = mixf(current_radius, 1.0f, spiral_progress);
-            }
-            
-            // Set the orb position
-            polar_t newPos = polar_t::Degrees(target_angle, current_radius);
-            newPos.normalize();
-            orb->SetOrigin(newPos);
-            
-            // Update the orb color based on transition progress
-            HSV currentHSV = interpolateHSV(hsv_from[k], hsv_to[k], color_blend);
-            orb->SetColor(hsv2rgb(currentHSV));
-            
-            // Update speeds for dynamics
-            if (phase == FUSION || phase == EXPANSION) {
-                // Faster speed during fusion/expansion
-                orb->rot_speed = orb_speeds[k] * 1.2f;
-            } else {
-                // Normal speed during other phases
-                orb->rot_speed = orb_speeds[k];
-            }
+        blend = timeline[BLEND];
+        for(int k = 0; k < 3; ++k) {
+            polar_t pos{DEG2RAD(timeline[ANGLE + k]), timeline[RADIUS + k]};
+            orbs[k].SetOrigin(pos.normalize());
+            orbs[k].SetColor(ramps[k].Sample(ramp_pos(blend)));
         }
     }
 
@@ -991,23 +913,18 @@ public:
     }
     
     // Our custom Draw method that takes additional parameters
-    void DrawTransition(LEDMatrix* matrix, std::array<led_color_t, LED_COUNT>& leds, const std::array<polar_t, LED_COUNT>& led_lut) {
+    void DrawTransition(std::array<led_color_t, LED_COUNT>& leds) {
         // If in FLASH phase, create a bright flash effect
         if (phase == FLASH) {
             // Flash phase: pulse white with subtle color undertones
-            float flashIntensity = 1.0f;
-            if (t_phase < T_flash * 0.5f) {
-                flashIntensity = t_phase / (T_flash * 0.5f);
-            } else {
-                flashIntensity = 1.0f - ((t_phase - T_flash * 0.5f) / (T_flash * 0.5f));
-            }
+            float flashIntensity = timeline[FLASH_LEVEL];
             
             // Create a bright white/color blend with subtle color hints
             for (int i = 0; i < LED_COUNT; ++i) {
                 // Get a blend of all three orb colors for a richer flash effect
-                led_color_t base_color1 = dynamic_cast<Orb*>(orbs[0].get())->color;
-                led_color_t base_color2 = dynamic_cast<Orb*>(orbs[1].get())->color;
-                led_color_t base_color3 = dynamic_cast<Orb*>(orbs[2].get())->color;
+                led_color_t base_color1 = orbs[0].color;
+                led_color_t base_color2 = orbs[1].color;
+                led_color_t base_color3 = orbs[2].color;
                 
                 // Average the colors and add white for flash
                 uint8_t r = static_cast<uint8_t>((base_color1.r + base_color2.r + base_color3.r) / 3);
@@ -1026,53 +943,98 @@ public:
         }
         
         // For all other phases, use the Gaussian blending from run() function
-        // Reset the LED buffer for this frame
-        for (int i = 0; i < LED_COUNT; ++i) {
-            leds[i] = {0, 0, 0};
-        }
+        // Reset the render buffer for this frame
+        canvas.Clear();
         
         // Apply Gaussian blending for each orb (similar to the active state)
+        std::array<float, LED_COUNT> F;
         for (size_t o = 0; o < orbs.size(); ++o) {
-            auto orbPtr = dynamic_cast<Orb*>(orbs[o].get());
+            auto orbPtr = &orbs[o];
             polar_t C = orbPtr->GetOrigin();
+            splat[o]->Weights(C.theta, C.r, F.data());
             
-            // For each LED in the matrix
-            for (int i = 0; i < LED_COUNT; ++i) {
-                polar_t P = led_lut[i];
-                
-                // Calculate Gaussian influence based on distance
-                float dθ = angularDifference(P.theta, C.theta);
-                float r̄ = (P.r + C.r) * 0.5f;
-                float Δr = P.r - C.r;
-                float d2 = (dθ * r̄)*(dθ * r̄) + (Δr * Δr);
-                float F = std::exp(-d2 / (2 * sigma[o] * sigma[o]));
-                
-                // Get current color of the orb 
-                led_color_t base = orbPtr->color;
-                
-                // Apply intensity and falloff
-                led_color_t contrib = base * (intensity[o] * F);
-                
-                // Additive blend (clamped at 255)
-                leds[i] = leds[i] + contrib;
-            }
+            // Current color of the orb with intensity and falloff, additive blend
+            canvas.AddSplat(F.data(), orbPtr->color, intensity[o]);
         }
+        canvas.Resolve(leds.data());
     }
     
 private:
     std::array<HSV, 3> hsv_from;
     std::array<HSV, 3> hsv_to;
-    std::vector<std::unique_ptr<Orb>> orbs;
-    std::vector<float> orb_speeds;
-    std::vector<float> sigma;        // Gaussian blur radius for each orb
-    std::vector<float> intensity;    // Intensity multiplier for each orb
-    std::vector<polar_t> initial_positions; // Store initial positions
-    
+    std::array<Gradient, 3> ramps;   // hsv_from -> hsv_to per orb
+    float blend = 0.f;               // overall colour progress of the last Update, 0..1
+    float blend_base = 0.f;          // progress the ramps start at, moved up by Retarget()
+    float ramp_pos(float b) const { return (b - blend_base) / (1.f - blend_base); }
+    std::array<Orb, 3> orbs;         // pool, reset by Start()
+    // unique sweep speeds for each orb for more dynamic movement
+    static constexpr std::array<float, 3> orb_speeds = {320.0f, 340.0f, 300.0f};
+    static constexpr std::array<float, 3> sigma = {1.0f, 1.0f, 1.0f};       // Gaussian blur radius for each orb
+    // tables looked up once, not per orb per frame
+    std::array<const SplatTable*, 3> splat = {&orb_splat(sigma[0]), &orb_splat(sigma[1]), &orb_splat(sigma[2])};
+    RenderBuffer<LED_COUNT> canvas;  // orbs accumulate here before the final clamp
+    static constexpr std::array<float, 3> intensity = {0.9f, 0.9f, 0.9f};   // higher than in the active state
+
+    // End of each phase, seconds from the start
+    static constexpr std::array<float, 5> phase_ends = {
+        T_in, T_in + T_fusion, T_in + T_fusion + T_flash,
+        T_in + T_fusion + T_flash + T_expansion, T_in + T_fusion + T_flash + T_expansion + T_out};
+
+    // Tracks: the angle (degrees, unwrapped) and radius of each orb, then the
+    // colour progress and the flash level shared by all three
+    enum { ANGLE = 0, RADIUS = 3, BLEND = 6, FLASH_LEVEL = 7, TRACKS = 8 };
+    Timeline<TRACKS, 64> timeline;
+
+    void build_timeline() {
+        const float in = phase_ends[0], fusion = phase_ends[1], flash = phase_ends[2];
+        const float expansion = phase_ends[3], out = phase_ends[4];
+        for(int k = 0; k < 3; ++k) {
+            const float s = k * 120.f;
+            // IN: each orb sweeps ahead at its own speed, then all meet at 0 degrees.
+            // FUSION spins them together one turn while they spiral in, FLASH
+            // drifts them through the center, EXPANSION flings them back apart
+            // and OUT settles each one a full turn on, where it started
+            timeline.Track({
+                {0.f,           s,                                  Ease::SMOOTH},
+                {in * 0.5f,     s + 0.1875f * orb_speeds[k] - 0.25f * s, Ease::SMOOTH},
+                {in,            360.f,                              Ease::IN_OUT},
+                {fusion,        720.f,                              Ease::LINEAR},
+                {flash,         750.f,                              Ease::OUT},
+                {expansion,     900.f + s,                          Ease::OUT},
+                {out,           1080.f + s},
+            });
+        }
+        for(int k = 0; k < 3; ++k) {
+            timeline.Track({
+                {0.f,           3.f,    Ease::LINEAR},
+                {in * 0.8f,     3.f,    Ease::IN_OUT},
+                {fusion,        0.5f,   Ease::LINEAR},
+                {flash,         0.5f,   Ease::IN_OUT},
+                {expansion,     3.f,    Ease::LINEAR},
+                {out,           3.f},
+            });
+        }
+        // colour: 30% over IN, to 60% by the flash, 90% after expansion, the rest in OUT
+        timeline.Track({
+            {0.f,       0.f,    Ease::LINEAR},
+            {in,        0.3f,   Ease::IN_OUT},
+            {fusion,    0.6f,   Ease::HOLD},
+            {flash,     0.6f,   Ease::IN_OUT},
+            {expansion, 0.9f,   Ease::LINEAR},
+            {out,       1.f},
+        });
+        // the flash ramps up and back down across its phase
+        timeline.Track({
+            {0.f,                           0.f,    Ease::HOLD},
+            {fusion,                        0.f,    Ease::LINEAR},
+            {(fusion + flash) * 0.5f,       1.f,    Ease::LINEAR},
+            {flash,                         0.f,    Ease::HOLD},
+            {out,                           0.f},
+        });
+    }
+
     Phase phase;
     float t_phase;
-    float dt;
-    std::chrono::time_point<std::chrono::high_resolution_clock> last_update;
-    std::chrono::time_point<std::chrono::high_resolution_clock> phase_start_time;
 };
 
 class WiFiSymbol {
@@ -1114,28 +1076,15 @@ public:
         if (!elem.is_arc) {
             // Draw single point
             polar_t world_pos = TransformPoint(elem.position);
-            try {
-                matrix->set_led(world_pos, color);
-            } catch(...) {}
+            matrix->draw_point(world_pos, color);
         } else {
             // Draw arc
             polar_t arc_center = TransformPoint(elem.position);
             float half_span = elem.arc_span_deg * 0.5f;
             
-            // Calculate start and end angles in world coordinates
-            float start_angle = direction - half_span;
-            float end_angle = direction + half_span;
-            
-            // Determine step size based on ring
+            // The arc spans the signal direction, one LED per center it covers
             int ring = static_cast<int>(arc_center.r);
-            float step_deg = GetStepSizeForRing(ring);
-            
-            // Draw the arc
-            for (float angle = start_angle; angle <= end_angle + 0.01f; angle += step_deg) {
-                try {
-                    matrix->set_led(angle, ring, color);
-                } catch(...) {}
-            }
+            matrix->draw_arc(ring, direction - half_span, elem.arc_span_deg, color);
         }
     }
     
@@ -1163,87 +1112,364 @@ private:
         result.normalize();
         return result;
     }
-    
-    float GetStepSizeForRing(int ring) {
-        // Return appropriate step size based on number of LEDs in ring
-        switch(ring) {
-            case 1: return 45.0f;   // 8 LEDs
-            case 2: return 30.0f;   // 12 LEDs  
-            case 3: return 22.5f;   // 16 LEDs
-            case 4: return 15.0f;   // 24 LEDs
-            default: return 30.0f;
-        }
-    }
+};
+
+/*
+effects for the layer compositor (compositor.h), one per look the states are
+built from. they render in physical frame order like RenderBuffer: index i
+is the i-th LED on the chain, whether it comes from ring offsets, a matrix
+frame or the splat tables and make_led_lut().
+*/
+using FrameLayer = Layer<LED_COUNT>;
+using FrameLayerBuffer = LayerBuffer<LED_COUNT>;
+using FrameCompositor = Compositor<LED_COUNT>;
+
+// one color over the whole fixture
+class SolidLayer : public FrameLayer {
+public:
+    SolidLayer(led_color_t color, float alpha = 1.f) : color(color), alpha(alpha) {}
+    void Render(FrameLayerBuffer& out) override { out.Fill(color, alpha); }
+
+    led_color_t color;
+    float alpha;
+};
+
+// breathing rings: a wave of light running out from the center and a wave of
+// dark running back in, the center always lit (dormant and respond-to-user)
+class RingWaveLayer : public FrameLayer {
+public:
+    RingWaveLayer(led_color_t base_color, led_color_t min_color) : glow(OrbFixture::RINGS, base_color, min_color) {}
+    void Update(const frame_time_t& now) override;
+    void Render(FrameLayerBuffer& out) override;
+
+private:
+    Glow glow;  // pulse timing
+    std::array<led_color_t, OrbFixture::RINGS> ring_colors{};
+};
+
+// one wide Gaussian orb circling at radius 3, pulling the layers below
+// towards its color by twice its weight
+class SpinOrbLayer : public FrameLayer {
+public:
+    SpinOrbLayer(led_color_t color, float degrees_per_sec = 300.f, float sigma = 3.5f, float gain = 1.2f, float mix = 2.f)
+    : color(color), speed(degrees_per_sec), gain(gain), mix(mix), splat(orb_splat(sigma)) {}
+    void Update(const frame_time_t& now) override;
+    void Render(FrameLayerBuffer& out) override;
+
+private:
+    led_color_t color;
+    float speed, gain, mix;
+    const SplatTable& splat;
+    float angle = 0.f;
+};
+
+// WiFi symbol drawn element by element, a pause, then again
+class WiFiLayer : public FrameLayer {
+public:
+    WiFiLayer(led_color_t color, float direction_deg = 270.f);
+    void Update(const frame_time_t& now) override;
+    void Render(FrameLayerBuffer& out) override;
+
+private:
+    static constexpr float ELEMENT_DURATION = 0.8f;  // Time to show each element, seconds
+    led_color_t color;
+    WiFiSymbol symbol;
+    LEDMatrix matrix;
+    LEDArray frame;
+    Timeline<1, 8> reveal;      // elements shown: one more every step, then a step of none, looped
+    int shown = 0;
+    float t = 0.f;              // seconds into the reveal
+};
+
+// a sector sweeping round each ring in turn until the whole fixture is lit
+class SectorFillLayer : public FrameLayer {
+public:
+    explicit SectorFillLayer(led_color_t color) : color(color) {}
+    //restarts the sweep
+    void SetColor(led_color_t c){ color = c; initialized = false; }
+    void Update(const frame_time_t& now) override;
+    void Render(FrameLayerBuffer& out) override;
+
+private:
+    static constexpr float ANGULAR_SPEED = 720.0f;  // Degrees per second that the sector grows
+    led_color_t color;
+    float filled_angle_deg = 30.0f;
+    int current_radius = 0;
+    bool fully_filled = false;
+    bool initialized = false;
 };
 
 class LEDController
 {
 public:
-    LEDController() : spi(WS2812B_SPI_SPEED) {
-        buildLUT();
-        if(spi.state == SPI_OPEN){
+    //output defaults to the spidev backend, pass any LEDOutput to run off-target.
+    //encoding picks the WS2812 symbol density, the default spidev output is clocked to match.
+    //clock drives the animations (anim_clock.h), monotonic by default; a SimClock
+    //renders as fast as the output takes frames, on simulated time
+    LEDController(std::unique_ptr<LEDOutput> out = nullptr, ws2812_encoding enc = WS2812_ENCODING_8BIT,
+                  std::unique_ptr<AnimClock> clock = nullptr)
+        : encoding(enc), tx_bytes(ws2812_frame_bytes(enc, LED_COUNT)), output(std::move(out)),
+          anim_clock(clock ? std::move(clock) : std::make_unique<MonotonicClock>()), tx(alloc_tx()) {
+        if(!output) output = std::make_unique<SpiOutput>(encoding);
+        for(auto& s : default_state_fps)
+            state_fps[state_slot(s.first)].store(s.second, std::memory_order_relaxed);
+        publish_calibration();
+        build_layers();
+        if(output->Ready()){
             off();
+            output_running.store(true);
+            output_thread = std::thread(&LEDController::run_output, this);
             control_thread = std::thread(&LEDController::run, this);
         }
-        else puts("ledcontrol failed to init SPI");
-        ph_last_update = std::chrono::high_resolution_clock::now();
+        else printf("ledcontrol failed to init output '%s'\n", output->Name());
     }
     ~LEDController(){
         shutdown();
     }
 
-    //void SetState(LEDState s) { state.store(s, std::memory_order_relaxed); }
-
-    void SetState(LEDState state) { this->state.store(state, std::memory_order_relaxed); }
-    
-    // Add a method to request state transition with HSV profiles
-    void RequestState(LEDState newState, const std::array<HSV,3>& targetHSV) {
-        pendingNextState = newState;
-        nextHSV = targetHSV;
-    }
+    //state, palette and placeholder changes from any thread go through a
+    //lock-free queue and the render thread applies them at its next frame
+    //boundary, several landing in one frame coalesce (the last of each kind
+    //wins, a SetState drops a RequestState queued before it). none of these
+    //block, false means the queue was full and the command was dropped
+    bool SetState(LEDState state);
+    // transition to newState, blending the orbs towards targetHSV
+    bool RequestState(LEDState newState, const std::array<HSV,3>& targetHSV);
+    //state the render thread is in
+    LEDState State() const { return state.load(std::memory_order_relaxed); }
     
-    // Add transition function for testing
+    // Add transition function for testing. it renders on the calling thread,
+    // so only runs when the render thread isn't (output not ready, or after
+    // shutdown), never next to it
     void run_transition_test();
 
     // --- Customisation for placeholder transition ---
-    void SetPlaceholderColor(const led_color_t& c);
+    bool SetPlaceholderColor(const led_color_t& c);
+
+    //draws the layers of state s over whatever state is showing (s itself
+    //excepted), e.g. SetOverlay(LEDState::CONNECTING, true) puts the WiFi
+    //symbol over the dormant glow. queued like SetState
+    bool SetOverlay(LEDState s, bool on);
+
+    LEDOutput* Output() const { return output.get(); }
+    AnimClock* Clock() const { return anim_clock.get(); }
+    ws2812_encoding Encoding() const { return encoding; }
+
+    //resend an unchanged frame after this long, 0 = only send on change
+    void SetKeepAlive(std::chrono::milliseconds interval) { keepalive_ms.store(interval.count(), std::memory_order_relaxed); }
+
+    //how finished frames reach the output thread
+    enum class OutputPolicy : uint8_t {
+        QUEUE,          //every frame is sent, render waits when the queue is full
+        LATEST_WINS     //render never waits, output sends the newest frame, ones it never got to are dropped
+    };
+    void SetOutputPolicy(OutputPolicy policy) { output_policy.store(policy, std::memory_order_relaxed); }
+
+    //frames per second a state is rendered at, takes effect on its next frame
+    void SetStateFPS(LEDState s, float fps);
+    float StateFPS(LEDState s) const;
+    void SetTransitionFPS(float fps) { transition_fps.store(fps, std::memory_order_relaxed); }
+    void SetFramePolicy(FrameClock::Policy policy) { frame_clock.SetPolicy(policy); }
+    //pacing of the render thread: target vs actual fps, missed deadlines
+    FrameClock::stats_t FrameStats() const { return frame_clock.Stats(); }
+
+    //output calibration, folded into the encoder tables. every change builds
+    //new tables and swaps them in whole, a static frame is re-sent with them.
+    //ring gains go by the LED's physical ring, so they apply in every state,
+    //the Gaussian orb states included, not only those drawn through LEDRing
+    void SetBrightness(float brightness);   //0..1
+    void SetGamma(float gamma);             //1 = linear
+    void SetRingGain(int ring, float gain);
+    float Brightness();
+
+    struct frame_counters_t {
+        uint64_t sent;
+        uint64_t skipped;   //identical to the last frame, not queued, encoded or transferred
+        uint64_t dropped;   //rendered but never sent, overtaken by a newer frame under LATEST_WINS
+        size_t queue_depth;
+        size_t max_queue_depth;
+    };
+    frame_counters_t FrameCounters() const {
+        return { frames_sent.load(std::memory_order_relaxed), frames_skipped.load(std::memory_order_relaxed),
+                 frames_dropped.load(std::memory_order_relaxed), frame_queue.size(),
+                 max_queue_depth.load(std::memory_order_relaxed) };
+    }
+
+    //per stage frame timing (update, draw, compose on the render thread,
+    //encode and transfer on the output thread), see frame_stats.h
+    struct command_stats_t {
+        uint64_t queued;
+        uint64_t applied;       //taken off the queue by the render thread
+        uint64_t coalesced;     //of those, overridden by a later command in the same frame
+        uint64_t rejected;      //queue full
+        LatencyHistogram::summary_t latency;    //queued -> applied
+        //SetState / RequestState queued -> state switched or transition started,
+        //at most one frame of the slowest state plus its render time
+        LatencyHistogram::summary_t state_latency;
+        uint64_t retargeted;    //transitions turned towards a newer RequestState
+        uint64_t cut;           //transitions ended early by a SetState
+    };
+    command_stats_t CommandStats() const {
+        return { commands_queued.load(std::memory_order_relaxed), commands_applied.load(std::memory_order_relaxed),
+                 commands_coalesced.load(std::memory_order_relaxed), commands_rejected.load(std::memory_order_relaxed),
+                 command_latency.Summary(), state_latency.Summary(),
+                 transitions_retargeted.load(std::memory_order_relaxed), transitions_cut.load(std::memory_order_relaxed) };
+    }
+    struct stats_t {
+        FrameClock::stats_t pacing;
+        frame_counters_t frames;
+        std::array<LatencyHistogram::summary_t, StageStats::STAGES> stages;
+        command_stats_t commands;
+    };
+    stats_t GetStats() const { return { frame_clock.Stats(), FrameCounters(), stage_stats.Snapshot(), CommandStats() }; }
+    //clears the stage and command latency histograms, counters keep counting
+    void ResetStats() { stage_stats.Reset(); command_latency.Reset(); state_latency.Reset(); }
+    //the output thread rewrites path (through path.tmp + rename) every interval
+    //while it is idle, an empty path or a zero interval turns it off
+    void SetMetricsFile(const std::string& path, std::chrono::milliseconds interval);
 
 private:
-    spi_t spi;
-    std::array<polar_t, LED_COUNT> led_lut;
+    //the states, layers and LEDArray are written for the orb, only the
+    //geometry below them (matrix, LUT, splat tables, buffers) takes a layout
+    using Fixture = OrbFixture;
+    using Render = FixtureRender<Fixture>;
+    static constexpr size_t TX_BYTES = Fixture::SPI_BYTES;  //8 bit symbols, the densest encodings need less
+    static constexpr size_t PAGE_BYTES = 4096;
+    using tx_buffer_t = std::unique_ptr<char, decltype(&free)>;
+    static tx_buffer_t alloc_tx(){
+        void* mem = nullptr;
+        size_t size = (TX_BYTES + PAGE_BYTES - 1) / PAGE_BYTES * PAGE_BYTES;
+        if(posix_memalign(&mem, PAGE_BYTES, size) != 0) throw std::bad_alloc();
+        memset(mem, 0, size);
+        return tx_buffer_t(static_cast<char*>(mem), &free);
+    }
+
+    const ws2812_encoding encoding;
+    const size_t tx_bytes;  //bytes of one encoded frame
+    std::unique_ptr<LEDOutput> output;
+    std::unique_ptr<AnimClock> anim_clock;
+    FrameTicker ticker;     //render thread, the time of the current frame
+
+    //render pacing. ACTIVE's orbs step once per frame, 200 fps is what the
+    //old unpaced loop managed with a 61 LED transfer in it
+    static constexpr int STATE_SLOTS = 8;
+    static constexpr std::pair<LEDState, float> default_state_fps[] = {
+        {LEDState::DORMANT, 100.f}, {LEDState::ACTIVE, 200.f}, {LEDState::RESPOND_TO_USER, 100.f},
+        {LEDState::PROMPT, 50.f}, {LEDState::CONNECTING, 20.f}, {LEDState::BOOT, 50.f},
+        {LEDState::PLACEHOLDER_TRANSITION, 50.f},
+    };
+    static int state_slot(LEDState s);
+    FrameClock frame_clock;
+    std::atomic<float> state_fps[STATE_SLOTS] = {};
+    std::atomic<float> transition_fps{100.f};
+    //switches the clock to fps if needed, then waits for the next deadline
+    //(or steps a simulated anim_clock one period)
+    void pace(float fps);
+
+    //render thread side: frames go out through frame_queue or latest_frame when they change
+    LEDArray last_queued;
+    bool have_last_queued = false;
+    //a frame and the animation time it was rendered for
+    struct queued_frame_t {
+        LEDArray leds;
+        int64_t time_ns;
+    };
+    SpscRing<queued_frame_t, 4> frame_queue;   //QUEUE, every frame in order
+    LatestSlot<queued_frame_t> latest_frame;    //LATEST_WINS, only the newest
+    std::atomic<OutputPolicy> output_policy{OutputPolicy::QUEUE};
+
+    //output thread side, only touched synchronously before/after it runs
+    std::thread output_thread;
+    std::atomic_bool output_running{false};
+    std::mutex output_mtx;              //only for sleeping, never held by the render thread
+    std::condition_variable output_cv;
+    //encoded frame, persists across frames and is only rewritten on change
+    tx_buffer_t tx;
+    bool tx_valid = false;
+    LEDArray tx_frame;                                      //frame tx was encoded from
+    int64_t tx_time = 0;                                    //and its animation time
+    std::shared_ptr<const ws2812_calibration> tx_calibration;   //and the tables it went through
+    std::chrono::steady_clock::time_point last_send_time;
+    std::atomic<int64_t> keepalive_ms{0};
+
+    //calibration parameters, published as a whole table set through
+    //atomic_store / atomic_load. the output thread never waits on calib_mtx
+    //or a table rebuild, only on the shared_ptr swap itself (a spinlock in
+    //libstdc++, held for a pointer copy)
+    std::mutex calib_mtx;
+    float gamma = 1.f;
+    float brightness = 1.f;
+    //rings 3 and 4 don't match the others on the board
+    std::array<float, 5> ring_gain = {1.f, 1.f, 1.f, 1.66f, 0.37f};
+    std::shared_ptr<const ws2812_calibration> calibration;
+    void publish_calibration();
+
+    std::atomic<uint64_t> frames_sent{0};
+    std::atomic<uint64_t> frames_skipped{0};
+    std::atomic<uint64_t> frames_dropped{0};
+    std::atomic<size_t> max_queue_depth{0};
+
+    StageStats stage_stats;
+    StageTimer frame_timer{stage_stats};    //render thread only
+    std::mutex metrics_mtx;
+    std::string metrics_path;
+    std::atomic<int64_t> metrics_interval_ms{0};
+    std::chrono::steady_clock::time_point last_metrics_time;
+    void write_metrics();
+
+    struct command_t {
+        enum class Type : uint8_t { SET_STATE, REQUEST_STATE, PLACEHOLDER_COLOR, OVERLAY };
+        Type type;
+        LEDState state;
+        bool on;
+        std::array<HSV, 3> hsv;
+        led_color_t color;
+        int64_t queued_ns;
+    };
+    static constexpr size_t COMMAND_SLOTS = 64;
+    MpscRing<command_t, COMMAND_SLOTS> commands;
+    LatencyHistogram command_latency;
+    std::atomic<uint64_t> commands_queued{0};
+    std::atomic<uint64_t> commands_applied{0};
+    std::atomic<uint64_t> commands_coalesced{0};
+    std::atomic<uint64_t> commands_rejected{0};
+    LatencyHistogram state_latency;
+    std::atomic<uint64_t> transitions_retargeted{0};
+    std::atomic<uint64_t> transitions_cut{0};
+    bool queue_command(command_t cmd);
+    //render thread, drains at most one queue's worth per frame
+    void apply_commands();
+
+    //float accumulation for the layered Gaussian states, resolved into leds once per frame
+    RenderBuffer<LED_COUNT> canvas;
     std::thread control_thread;
     std::atomic_bool should_run{true};
 
     std::array<led_color_t, LED_COUNT> leds;
-    static_assert(LED_COUNT * 24 < SPI_BUFFER_SIZE );
     
     std::atomic<LEDState> state{LEDState::DORMANT};
     
-    // For transition states
+    // For transition states, render thread only (see apply_commands)
+    TransitionSpiral spiral;                //reused by every transition
+    TransitionSpiral* transition = nullptr; //&spiral while one is running
     std::optional<LEDState> pendingNextState;
     std::array<HSV, 3> currentHSV;
     std::array<HSV, 3> nextHSV;
 
-    // Variables for Placeholder Transition Animation
-    led_color_t placeholderColor{255,255,255};
-    float       ph_filled_angle_deg = 30.0f;
-    int         ph_current_radius   = 0;
-    std::chrono::time_point<std::chrono::high_resolution_clock> ph_last_update;
-    bool        ph_initialized = false;
-
-    void buildLUT();
-
-    inline void update_leds(){
-        char tx[LED_COUNT * 24] = {0};
-        for (int j = 0; j < LED_COUNT; j++) {
-                encode_color(this->leds[j], &tx[j * 24]);
-        }
-        if(!spi.transfer(tx, sizeof(tx))) {
-            //damn that sucks
-            puts("SPI transfer failed");
-        }
-        usleep(5);
-    };
+    //layer stack of every state but ACTIVE, by state_slot(), render thread only
+    std::array<FrameCompositor, STATE_SLOTS> state_layers;
+    FrameLayerBuffer layer_scratch;
+    SectorFillLayer* placeholder_layer = nullptr;
+    uint8_t overlays = 0;   //state_slot() bits of the stacks drawn over every state
+    void build_layers();
+    void update_overlays(LEDState s, const frame_time_t& now);
+    void draw_overlays(LEDState s);
+    void run_layers(LEDState s, const frame_time_t& now);
+
+    //hands leds to the output thread (or sends it directly when that isn't running)
+    void update_leds();
+    void run_output();
+    void transmit(const LEDArray& frame, int64_t time_ns);
 
     inline void set_all(const led_color_t& color, bool no_update = false){
         for(int i = 0; i < LED_COUNT; ++i)
@@ -1257,26 +1483,18 @@ private:
         update_leds();
     }
     void run();
-    void run_transition(LEDMatrix* matrix);
+    void run_transition(const frame_time_t& now);
     void shutdown(){
-        if(spi.state == SPI_OPEN) off();
         should_run.store(false);
+        anim_clock->Release();
         if(control_thread.joinable())
             control_thread.join();
+        //output thread drains whatever is queued before it exits
+        output_running.store(false);
+        output_cv.notify_one();
+        if(output_thread.joinable())
+            output_thread.join();
+        if(output->Ready()) off();
         puts("LEDController cleanly shutdown");
     }
-  
-    void run_dormant();
-    void run_respond_to_user();
-    void run_prompt();
-    void run_connecting();
-    void run_boot();
-    void run_placeholder_transition();
 };
-
-
-
-
-
-
-#endif
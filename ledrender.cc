@@ -0,0 +1,230 @@
+#include "ledcontrol.h"
+#include "capture.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// headless renderer: runs the controller on a SimClock at full speed, no SPI,
+// and reports render throughput per state. with -o every frame goes to a
+// .ledcap capture (capture.h) to diff against another build or feed a tool.
+//
+//   ledrender -s active -t 10 -o active.ledcap
+//   ledrender -s all -t 5
+//   ledrender -f demo.script -t 12 -o demo.ledcap
+//
+// a script is one command per line, at a time in simulated seconds:
+//   0    set dormant
+//   2.5  request prompt 0,1,1 30,1,1 60,1,1    (three orb colors, h,s,v)
+//   4    overlay connecting on
+//   6    color 200,40,10                       (placeholder color)
+// the clock is held at each command's time, so it lands on the first frame
+// after it in every run, whatever the machine.
+
+struct state_name_t { LEDState state; const char* name; };
+static const state_name_t state_names[] = {
+    {LEDState::DORMANT, "dormant"},
+    {LEDState::ACTIVE, "active"},
+    {LEDState::RESPOND_TO_USER, "respond"},
+    {LEDState::PROMPT, "prompt"},
+    {LEDState::CONNECTING, "connecting"},
+    {LEDState::BOOT, "boot"},
+    {LEDState::PLACEHOLDER_TRANSITION, "placeholder"},
+};
+
+static bool parse_state(const char* s, LEDState& out){
+    for(auto& n : state_names)
+        if(strcmp(s, n.name) == 0){ out = n.state; return true; }
+    return false;
+}
+
+struct command_t {
+    enum Kind { SET, REQUEST, OVERLAY, COLOR } kind;
+    int64_t at_ns;
+    LEDState state;
+    std::array<HSV, 3> hsv;
+    bool on;
+    led_color_t color;
+};
+
+static bool load_script(const char* path, std::vector<command_t>& script){
+    FILE* f = fopen(path, "r");
+    if(!f){
+        printf("can't open script '%s' - %s\n", path, strerror(errno));
+        return false;
+    }
+    char line[256];
+    int n = 0;
+    bool ok = true;
+    while(ok && fgets(line, sizeof(line), f)){
+        n++;
+        char* hash = strchr(line, '#');
+        if(hash) *hash = 0;
+        double at;
+        char verb[32], arg[32];
+        int used = 0;
+        int fields = sscanf(line, " %lf %31s %31s %n", &at, verb, arg, &used);
+        if(fields <= 0) continue;   //blank or comment
+        command_t c{};
+        c.at_ns = static_cast<int64_t>(at * 1e9);
+        ok = fields == 3 && at >= 0.0;
+        if(ok && strcmp(verb, "set") == 0){
+            c.kind = command_t::SET;
+            ok = parse_state(arg, c.state);
+        }
+        else if(ok && strcmp(verb, "request") == 0){
+            c.kind = command_t::REQUEST;
+            HSV* h = c.hsv.data();
+            ok = parse_state(arg, c.state) &&
+                 sscanf(line + used, "%f,%f,%f %f,%f,%f %f,%f,%f", &h[0].h, &h[0].s, &h[0].v,
+                        &h[1].h, &h[1].s, &h[1].v, &h[2].h, &h[2].s, &h[2].v) == 9;
+        }
+        else if(ok && strcmp(verb, "overlay") == 0){
+            c.kind = command_t::OVERLAY;
+            char on[8];
+            ok = parse_state(arg, c.state) && sscanf(line + used, "%7s", on) == 1;
+            c.on = ok && strcmp(on, "on") == 0;
+        }
+        else if(ok && strcmp(verb, "color") == 0){
+            c.kind = command_t::COLOR;
+            unsigned r, g, b;
+            ok = sscanf(arg, "%u,%u,%u", &r, &g, &b) == 3 && r < 256 && g < 256 && b < 256;
+            c.color = {static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b)};
+        }
+        else ok = false;
+        if(ok && !script.empty() && c.at_ns < script.back().at_ns){
+            printf("%s:%d: commands must be in time order\n", path, n);
+            ok = false;
+        }
+        else if(!ok) printf("%s:%d: can't parse '%s'\n", path, n, line);
+        if(ok) script.push_back(c);
+    }
+    fclose(f);
+    return ok;
+}
+
+static bool issue(LEDController& ctrl, const command_t& c){
+    switch(c.kind){
+        case command_t::SET:     return ctrl.SetState(c.state);
+        case command_t::REQUEST: return ctrl.RequestState(c.state, c.hsv);
+        case command_t::OVERLAY: return ctrl.SetOverlay(c.state, c.on);
+        case command_t::COLOR:   return ctrl.SetPlaceholderColor(c.color);
+    }
+    return false;
+}
+
+//runs script up to end_ns, false if the render thread never got there
+static bool render(const char* label, const std::vector<command_t>& script, int64_t end_ns,
+                   const char* path, ws2812_encoding encoding, bool verbose){
+    auto sim = std::make_unique<SimClock>();
+    SimClock* clock = sim.get();
+    clock->HoldAt(0);   //nothing renders before the commands at 0 are queued
+
+    std::unique_ptr<LEDOutput> out;
+    if(path){
+        auto file = std::make_unique<CaptureFileOutput>(path, encoding);
+        file->SetEnd(end_ns);
+        out = std::move(file);
+    }
+    else out = std::make_unique<NullOutput>();
+    if(!out->Ready()) return false;
+
+    LEDController ctrl(std::move(out), encoding, std::move(sim));
+    auto held = [&](int64_t at){
+        clock->HoldAt(at);
+        if(clock->WaitHeld(std::chrono::seconds(10))) return true;
+        printf("%s: render thread didn't reach %.3f s\n", label, at / 1e9);
+        return false;
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    for(auto& c : script){
+        if(c.at_ns > end_ns) break;
+        if(!held(c.at_ns)) return false;
+        if(!issue(ctrl, c)) printf("%s: command queue full at %.3f s\n", label, c.at_ns / 1e9);
+    }
+    if(!held(end_ns)) return false;
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    //every frame up to end_ns has been rendered, the render thread is parked in pace()
+    auto stats = ctrl.GetStats();
+    auto mean_us = [&](FrameStage s){ return stats.stages[static_cast<int>(s)].mean_ns / 1e3; };
+    uint64_t frames = stats.stages[static_cast<int>(FrameStage::COMPOSE)].count;
+    printf("%-12s %8.2f %8llu %8.1f %10.0f %10.1f %10.1f %10.1f %10.1f\n", label, end_ns / 1e9, (unsigned long long)frames,
+           wall * 1e3, frames / wall, mean_us(FrameStage::UPDATE), mean_us(FrameStage::DRAW), mean_us(FrameStage::COMPOSE),
+           mean_us(FrameStage::ENCODE));
+    if(verbose) write_stage_stats(stdout, stats.stages);
+    return true;
+}
+
+//compose includes waiting for room in the output queue, encode runs on the output thread
+static void print_columns(){
+    printf("%-12s %8s %8s %8s %10s %10s %10s %10s %10s\n", "run", "sim s", "frames", "wall ms", "frames/s",
+           "update us", "draw us", "compose us", "encode us");
+}
+
+static void usage(){
+    puts("usage: ledrender [-s STATE|all] [-f SCRIPT] [-t SECONDS] [-o FILE.ledcap] [-e 8|4|3] [-v]\n"
+         "  -s  state to render from time 0 (default dormant), all renders each state in turn\n"
+         "  -f  script of timed commands, see ledrender.cc\n"
+         "  -t  simulated seconds to render (default 10)\n"
+         "  -o  write every frame to a capture file\n"
+         "  -e  ws2812 encoding, bits per symbol (default 8)\n"
+         "  -v  per stage percentiles after each run\n"
+         "states: dormant active respond prompt connecting boot placeholder");
+}
+
+int main(int argc, char** argv){
+    const char* state = "dormant";
+    const char* script_path = nullptr;
+    const char* out_path = nullptr;
+    double seconds = 10.0;
+    ws2812_encoding encoding = WS2812_ENCODING_8BIT;
+    bool verbose = false;
+    for(int i = 1; i < argc; ++i){
+        bool has_value = i + 1 < argc;
+        if(strcmp(argv[i], "-s") == 0 && has_value) state = argv[++i];
+        else if(strcmp(argv[i], "-f") == 0 && has_value) script_path = argv[++i];
+        else if(strcmp(argv[i], "-o") == 0 && has_value) out_path = argv[++i];
+        else if(strcmp(argv[i], "-t") == 0 && has_value) seconds = atof(argv[++i]);
+        else if(strcmp(argv[i], "-e") == 0 && has_value){
+            int bits = atoi(argv[++i]);
+            encoding = bits == 4 ? WS2812_ENCODING_4BIT : bits == 3 ? WS2812_ENCODING_3BIT : WS2812_ENCODING_8BIT;
+        }
+        else if(strcmp(argv[i], "-v") == 0) verbose = true;
+        else { usage(); return 2; }
+    }
+    if(seconds <= 0.0){ usage(); return 2; }
+    const int64_t end_ns = static_cast<int64_t>(seconds * 1e9);
+    bool all = strcmp(state, "all") == 0;
+    if(all && (script_path || out_path)){
+        puts("-s all renders states one by one, it takes neither a script nor a capture file");
+        return 2;
+    }
+
+    if(all){
+        print_columns();
+        for(auto& n : state_names)
+            if(!render(n.name, {command_t{command_t::SET, 0, n.state, {}, false, {}}}, end_ns, nullptr, encoding, verbose))
+                return 1;
+        return 0;
+    }
+
+    std::vector<command_t> script;
+    if(script_path){
+        if(!load_script(script_path, script)) return 2;
+    }
+    else {
+        LEDState s;
+        if(!parse_state(state, s)){ usage(); return 2; }
+        script.push_back(command_t{command_t::SET, 0, s, {}, false, {}});
+    }
+    print_columns();
+    if(!render(script_path ? script_path : state, script, end_ns, out_path, encoding, verbose)) return 1;
+    CaptureReader written;
+    if(out_path && written.Open(out_path))
+        printf("wrote %s, %llu frames\n", out_path, (unsigned long long)written.Frames());
+    return 0;
+}
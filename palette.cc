@@ -0,0 +1,44 @@
+#include "palette.h"
+#include <algorithm>
+
+void hsv2rgb_batch(const HSV* in, size_t count, led_color_t* out){
+    for(size_t i = 0; i < count; ++i) out[i] = hsv2rgb_fast(in[i]);
+}
+
+HSV hsv_lerp(const HSV& a, const HSV& b, float t){
+    // Handle hue specially to find shortest path around the circle
+    float h_diff = b.h - a.h;
+    if (h_diff > 180.0f) h_diff -= 360.0f;
+    else if (h_diff < -180.0f) h_diff += 360.0f;
+
+    float h = a.h + (h_diff * t);
+    // Normalize h to [0, 360)
+    while (h >= 360.0f) h -= 360.0f;
+    while (h < 0.0f) h += 360.0f;
+
+    return HSV{ h, a.s + (b.s - a.s) * t, a.v + (b.v - a.v) * t };
+}
+
+Gradient::Gradient(std::initializer_list<hsv_stop_t> stops, size_t size) : colors(size < 2 ? 2 : size) {
+    Assign(stops);
+}
+
+void Gradient::Assign(std::initializer_list<hsv_stop_t> stops){
+    if(stops.size() == 0){
+        std::fill(colors.begin(), colors.end(), led_color_t{0, 0, 0});
+        return;
+    }
+    const hsv_stop_t* first = stops.begin();
+    const hsv_stop_t* last = stops.end() - 1;
+    const hsv_stop_t* seg = first;
+    for(size_t i = 0; i < colors.size(); ++i){
+        float t = static_cast<float>(i) / (colors.size() - 1);
+        if(t <= first->pos) { colors[i] = hsv2rgb(first->hsv); continue; }
+        if(t >= last->pos) { colors[i] = hsv2rgb(last->hsv); continue; }
+        while(seg + 1 < last && t > (seg + 1)->pos) ++seg;
+        float span = (seg + 1)->pos - seg->pos;
+        float local = span > 0.f ? (t - seg->pos) / span : 1.f;
+        // built once, so the exact float conversion
+        colors[i] = hsv2rgb(hsv_lerp(seg->hsv, (seg + 1)->hsv, local));
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+#include "color.h"
+
+/*
+palettes: colors looked up by index instead of converted per pixel.
+
+hsv2rgb_int() is an integer HSV path (hue in 1/HUE_STEPS turns, s and v in
+0..255) with no fmod, branches per channel or rounding calls, within one
+step of hsv2rgb(). hsv2rgb_batch() runs it over arrays.
+
+Gradient precomputes a ramp through HSV stops (256 or 1024 entries) once,
+hue going the short way round between stops like TransitionSpiral always
+did. effects then fetch colors with Sample(t) or operator[].
+*/
+
+constexpr int HUE_STEPS = 1536;  // 6 sectors of 256
+
+inline led_color_t hsv2rgb_int(uint16_t hue, uint8_t sat, uint8_t val){
+    hue %= HUE_STEPS;
+    const uint32_t sector = hue >> 8, frac = hue & 255;
+    // chroma, min and the rising / falling component, all scaled by 255
+    const uint32_t c = static_cast<uint32_t>(val) * sat;
+    const uint32_t m = static_cast<uint32_t>(val) * 255 - c;
+    const uint32_t x = (sector & 1) ? (c * (256 - frac)) >> 8 : (c * frac) >> 8;
+    uint32_t r, g, b;
+    switch(sector){
+        case 0:  r = c; g = x; b = 0; break;
+        case 1:  r = x; g = c; b = 0; break;
+        case 2:  r = 0; g = c; b = x; break;
+        case 3:  r = 0; g = x; b = c; break;
+        case 4:  r = x; g = 0; b = c; break;
+        default: r = c; g = 0; b = x; break;
+    }
+    // (v + m) / 255, rounded
+    auto div255 = [](uint32_t v){ return static_cast<uint8_t>((v * 257 + 32896) >> 16); };
+    return { div255(r + m), div255(g + m), div255(b + m) };
+}
+
+//float HSV through the integer path
+inline led_color_t hsv2rgb_fast(const HSV& hsv){
+    float h = hsv.h - 360.f * std::floor(hsv.h * (1.f / 360.f));
+    float s = std::min(std::max(hsv.s, 0.f), 1.f);
+    float v = std::min(std::max(hsv.v, 0.f), 1.f);
+    return hsv2rgb_int(static_cast<uint16_t>(h * (HUE_STEPS / 360.f) + 0.5f),
+                       static_cast<uint8_t>(s * 255.f + 0.5f), static_cast<uint8_t>(v * 255.f + 0.5f));
+}
+
+void hsv2rgb_batch(const HSV* in, size_t count, led_color_t* out);
+
+//HSV blend with the hue taking the shorter way round
+HSV hsv_lerp(const HSV& a, const HSV& b, float t);
+
+struct hsv_stop_t {
+    float pos;  // [0,1]
+    HSV hsv;
+};
+
+class Gradient {
+public:
+    //stops sorted by pos; before the first / after the last stop the ramp is flat,
+    //no stops at all gives a black ramp
+    Gradient(std::initializer_list<hsv_stop_t> stops, size_t size = 256);
+    Gradient(const HSV& from, const HSV& to, size_t size = 256)
+    : Gradient({{0.f, from}, {1.f, to}}, size) {}
+
+    //rebuilds the ramp in place, same size, no allocation
+    void Assign(std::initializer_list<hsv_stop_t> stops);
+    void Assign(const HSV& from, const HSV& to){ Assign({{0.f, from}, {1.f, to}}); }
+
+    size_t Size() const { return colors.size(); }
+    const led_color_t& operator[](size_t i) const { return colors[i]; }
+
+    //nearest entry for t in [0,1], clamped
+    const led_color_t& Sample(float t) const {
+        float pos = std::min(std::max(t, 0.f), 1.f) * (colors.size() - 1) + 0.5f;
+        return colors[static_cast<size_t>(pos)];
+    }
+    void Sample(const float* t, size_t count, led_color_t* out) const {
+        for(size_t i = 0; i < count; ++i) out[i] = Sample(t[i]);
+    }
+
+private:
+    std::vector<led_color_t> colors;
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/*
+float accumulation buffer for layered renders.
+
+states that stack several orbs or blend over a background draw into a
+RenderBuffer instead of the 8-bit LED array: every operation works on the
+whole buffer in planar float, nothing clamps in between, and Resolve() does
+the one saturation and 8-bit rounding just before the frame goes out.
+
+color arguments are anything with .r .g .b (led_color_t), given in 0..255.
+
+Blend() composites one layer (planar color plus a 0..1 coverage per LED,
+see compositor.h) over the buffer with one of the BlendMode operators.
+*/
+
+enum class BlendMode : uint8_t {
+    ADD,        //acc += c * a
+    ALPHA,      //acc moves towards c by a
+    MAX,        //acc = max(acc, c * a)
+    MULTIPLY    //acc *= mix(1, c / 255, a)
+};
+
+template <size_t N>
+class RenderBuffer {
+public:
+    static constexpr size_t size() { return N; }
+
+    void Clear(){ Fill(0.f, 0.f, 0.f); }
+    template <typename C>
+    void Fill(const C& c){ Fill(c.r, c.g, c.b); }
+    void Fill(float cr, float cg, float cb){
+        std::fill(r, r + N, cr);
+        std::fill(g, g + N, cg);
+        std::fill(b, b + N, cb);
+    }
+
+    //acc += color * gain * w[i]
+    template <typename C>
+    void AddSplat(const float* w, const C& c, float gain){
+        const float cr = c.r * gain, cg = c.g * gain, cb = c.b * gain;
+        for(size_t i = 0; i < N; ++i){
+            r[i] += cr * w[i];
+            g[i] += cg * w[i];
+            b[i] += cb * w[i];
+        }
+    }
+
+    //moves each LED towards color * gain * w[i], by min(1, mix * w[i])
+    template <typename C>
+    void MixSplat(const float* w, const C& c, float gain, float mix){
+        const float cr = c.r * gain, cg = c.g * gain, cb = c.b * gain;
+        for(size_t i = 0; i < N; ++i){
+            const float t = std::min(1.f, mix * w[i]);
+            r[i] += t * (cr * w[i] - r[i]);
+            g[i] += t * (cg * w[i] - g[i]);
+            b[i] += t * (cb * w[i] - b[i]);
+        }
+    }
+
+    //a[i] * opacity is the layer's coverage of LED i
+    void Blend(const float* lr, const float* lg, const float* lb, const float* a, BlendMode mode, float opacity){
+        switch(mode){
+        case BlendMode::ADD:
+            for(size_t i = 0; i < N; ++i){
+                const float t = a[i] * opacity;
+                r[i] += lr[i] * t;
+                g[i] += lg[i] * t;
+                b[i] += lb[i] * t;
+            }
+            break;
+        case BlendMode::ALPHA:
+            for(size_t i = 0; i < N; ++i){
+                const float t = a[i] * opacity;
+                r[i] += t * (lr[i] - r[i]);
+                g[i] += t * (lg[i] - g[i]);
+                b[i] += t * (lb[i] - b[i]);
+            }
+            break;
+        case BlendMode::MAX:
+            for(size_t i = 0; i < N; ++i){
+                const float t = a[i] * opacity;
+                r[i] = std::max(r[i], lr[i] * t);
+                g[i] = std::max(g[i], lg[i] * t);
+                b[i] = std::max(b[i], lb[i] * t);
+            }
+            break;
+        case BlendMode::MULTIPLY:
+            for(size_t i = 0; i < N; ++i){
+                const float t = a[i] * opacity * (1.f / 255.f);
+                r[i] *= 1.f + t * (lr[i] - 255.f);
+                g[i] *= 1.f + t * (lg[i] - 255.f);
+                b[i] *= 1.f + t * (lb[i] - 255.f);
+            }
+            break;
+        }
+    }
+
+    void Scale(float s){
+        for(size_t i = 0; i < N; ++i){
+            r[i] *= s;
+            g[i] *= s;
+            b[i] *= s;
+        }
+    }
+
+    //saturates and rounds to 8 bits, out holds N colors
+    template <typename C>
+    void Resolve(C* out) const {
+        for(size_t i = 0; i < N; ++i){
+            out[i].r = quantize(r[i]);
+            out[i].g = quantize(g[i]);
+            out[i].b = quantize(b[i]);
+        }
+    }
+
+    float R(size_t i) const { return r[i]; }
+    float G(size_t i) const { return g[i]; }
+    float B(size_t i) const { return b[i]; }
+
+private:
+    static unsigned char quantize(float v){
+        return static_cast<unsigned char>(std::min(std::max(v, 0.f), 255.f) + 0.5f);
+    }
+
+    alignas(32) float r[N] = {};
+    alignas(32) float g[N] = {};
+    alignas(32) float b[N] = {};
+};
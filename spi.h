@@ -1,4 +1,5 @@
 #pragma once
+#include <cerrno>
 #include <cstdint>
 #include <stdlib.h>
 #include <cstring>
@@ -23,13 +24,20 @@ impl. is ripped from jetgpio
 
 */
 //note:
-//spi buffer has to be huge 
+//spidev caps the bytes of one SPI_IOC_MESSAGE at its bufsiz (4096 by default).
+//transfer() splits frames into SPI_CHUNK_SIZE transfers sent back to back and
+//packs as many as fit into each message, so any frame goes through. a frame
+//larger than bufsiz needs several messages though, and the syscall gap between
+//two of them can be long enough for a WS2812 strip to latch, so raise it:
 //sudo rmmod spidev && sudo modprobe spidev bufsize=20480
 // cat /sys/module/spidev/parameters/bufsiz
 //can create /etc/modprobe.d/spidev.conf
 //and add the line: 
 //options spidev bufsiz=20480
-#define SPI_BUFFER_SIZE 20480
+#define SPI_BUFFER_SIZE 20480   //assumed bufsiz when sysfs can't be read
+#define SPI_BUFSIZ_PATH "/sys/module/spidev/parameters/bufsiz"
+#define SPI_CHUNK_SIZE 4096     //bytes per spi_ioc_transfer
+#define SPI_MAX_TRANSFERS 64    //spi_ioc_transfers per SPI_IOC_MESSAGE
 
 
 #define SPI_MODE 0
@@ -37,7 +45,7 @@ impl. is ripped from jetgpio
 #define SPI_CS_CHANGE 1
 #define SPI_USE_LSB_FIRST 1 
 #define SPI_BITS_WORD 8
-#define SPI_DEV "/dev/spidev0.0"
+#define SPI_DEV "/dev/spidev0.0"  //default bus, spi_t takes any spidev node
 
 #define SPI_MAX_SPEED 50000000 //50mbit/s
 
@@ -52,11 +60,24 @@ enum spi_state : int {
 
 
 struct spi_t{
+    //hands one message of count transfers to the device, returns bytes sent or < 0
+    using submit_fn = int (*)(void* ctx, int fd, spi_ioc_transfer* tr, unsigned count);
+
     int32_t fd;
     uint32_t speed;
     spi_state state;
-    
-    spi_t(uint32_t speed) : fd(-1), speed(speed), state(SPI_CLOSED) {
+    uint32_t chunk_bytes = SPI_CHUNK_SIZE;      //0 counts as 1, like message_bytes
+    uint32_t message_bytes = SPI_BUFFER_SIZE;
+    submit_fn submit = ioctl_submit;
+    void* submit_ctx = nullptr;
+    uint64_t split_frames = 0;  //frames that needed more than one message
+
+    //a bus without a device, messages go to submit (tests). message_bytes 0 is
+    //taken as 1, like a bufsiz of 0 in sysfs
+    spi_t(uint32_t speed, submit_fn submit, void* ctx, uint32_t message_bytes)
+        : fd(-1), speed(speed), state(SPI_OPEN), message_bytes(message_bytes ? message_bytes : 1), submit(submit), submit_ctx(ctx) {
+    }
+    spi_t(uint32_t speed, const char* dev = SPI_DEV, bool lsb_first = SPI_USE_LSB_FIRST) : fd(-1), speed(speed), state(SPI_CLOSED) {
         auto spi_error = [this](const char* error_msg){
             printf("[SPI] Error: %s \n", error_msg);
             this->state = SPI_FAILED;
@@ -64,7 +85,7 @@ struct spi_t{
         if(speed > SPI_MAX_SPEED){
             spi_error("speed too high for the poor orin (max = 50mbits/s)"); return;
         }
-        fd = open(SPI_DEV, O_RDWR);
+        fd = open(dev, O_RDWR);
         if(fd < 0){
             spi_error("failed to open spi device "); return;
         }
@@ -72,7 +93,7 @@ struct spi_t{
         uint32_t cs_delay = SPI_CS_DELAY;
         uint32_t cs_change = SPI_CS_CHANGE;
         uint32_t bits_word = SPI_BITS_WORD;
-        uint32_t lsb_first = SPI_USE_LSB_FIRST;
+        uint32_t lsb = lsb_first;
         int err = 0;
         #define CHECK_IOCTL_ERROR(msg) if(err < 0) { spi_error(msg); return; } err = 0;
 
@@ -91,39 +112,75 @@ struct spi_t{
         err = ioctl(fd, SPI_IOC_RD_MAX_SPEED_HZ, &speed);
         CHECK_IOCTL_ERROR("READ SPEED");
 
-        err = ioctl(fd, SPI_IOC_WR_LSB_FIRST, &lsb_first);
+        err = ioctl(fd, SPI_IOC_WR_LSB_FIRST, &lsb);
         CHECK_IOCTL_ERROR("LSB FIRST");
-        err = ioctl(fd, SPI_IOC_RD_LSB_FIRST, &lsb_first);
+        err = ioctl(fd, SPI_IOC_RD_LSB_FIRST, &lsb);
         CHECK_IOCTL_ERROR("READ LSB FIRST");
 
+        message_bytes = read_bufsiz();
         state = SPI_OPEN;
-        printf("[SPI] Opened '%s' @ %.3f Mbits/s \n", SPI_DEV, (float)speed / (float)1000000.f);
+        printf("[SPI] Opened '%s' @ %.3f Mbits/s, %u bytes per message \n", dev, (float)speed / (float)1000000.f, message_bytes);
     }
-    bool transfer(char* tx_buffer, uint32_t len, char* rx_buffer = nullptr){
-        spi_ioc_transfer tr = {
-            .tx_buf = (uintptr_t)tx_buffer,
-            .rx_buf = (uintptr_t)rx_buffer,
-            .len = len,
-            .speed_hz = speed,
-            .delay_usecs = SPI_CS_DELAY,
-            .bits_per_word = (uint8_t)SPI_BITS_WORD,
-            .cs_change = (uint8_t)SPI_CS_CHANGE,
-            .tx_nbits = 1u,
-            .rx_nbits = 1u,
-            .word_delay_usecs = 0u,
-            .pad = 0u
-        };
-        int err = ioctl(fd, SPI_IOC_MESSAGE(1), &tr);
-        if(err < 1){
-            printf("[SPI] transfer error [%i] - strerr='%s' ", err, std::strerror(err));
-            return false;
+    //chunks run back to back with chip select held and no delay, only the last
+    //transfer of the frame gets SPI_CS_CHANGE
+    bool transfer(const char* tx_buffer, uint32_t len, char* rx_buffer = nullptr){
+        //both fields are public, a 0 in either would queue empty messages forever
+        const uint32_t limit = message_bytes ? message_bytes : 1;
+        const uint32_t chunk = chunk_bytes == 0 ? 1 : chunk_bytes < limit ? chunk_bytes : limit;
+        uint32_t done = 0;
+        int messages = 0;
+        while(done < len){
+            unsigned count = 0;
+            uint32_t bytes = 0;
+            while(done + bytes < len && count < SPI_MAX_TRANSFERS){
+                uint32_t n = len - done - bytes < chunk ? len - done - bytes : chunk;
+                if(bytes + n > limit) break;
+                bool last = done + bytes + n == len;
+                xfers[count++] = {
+                    .tx_buf = (uintptr_t)(tx_buffer + done + bytes),
+                    .rx_buf = rx_buffer ? (uintptr_t)(rx_buffer + done + bytes) : 0,
+                    .len = n,
+                    .speed_hz = speed,
+                    .delay_usecs = SPI_CS_DELAY,
+                    .bits_per_word = (uint8_t)SPI_BITS_WORD,
+                    .cs_change = (uint8_t)(last ? SPI_CS_CHANGE : 0),
+                    .tx_nbits = 1u,
+                    .rx_nbits = 1u,
+                    .word_delay_usecs = 0u,
+                    .pad = 0u
+                };
+                bytes += n;
+            }
+            int err = submit(submit_ctx, fd, xfers, count);
+            if(err < 0){
+                printf("[SPI] transfer error [%i] - strerr='%s'\n", err, std::strerror(errno));
+                return false;
+            }
+            done += bytes;
+            messages++;
         }
+        if(messages > 1) split_frames++;
         return true;
     }
+    static int ioctl_submit(void*, int fd, spi_ioc_transfer* tr, unsigned count){
+        //SPI_IOC_MESSAGE(count) spelled out, its char[] trick needs a constant count
+        return ioctl(fd, _IOC(_IOC_WRITE, SPI_IOC_MAGIC, 0, SPI_MSGSIZE(count)), tr);
+    }
+    static uint32_t read_bufsiz(){
+        uint32_t bufsiz = SPI_BUFFER_SIZE;
+        if(FILE* f = fopen(SPI_BUFSIZ_PATH, "r")){
+            if(fscanf(f, "%u", &bufsiz) != 1 || bufsiz == 0) bufsiz = SPI_BUFFER_SIZE;
+            fclose(f);
+        }
+        return bufsiz;
+    }
+
     ~spi_t(){
-        if(state != SPI_OPEN) return;
+        if(state != SPI_OPEN || fd < 0) return;
         close(fd);
         puts("[SPI] Closed SPI device");
         state = SPI_CLOSED; //lol no pt 
     }
+private:
+    spi_ioc_transfer xfers[SPI_MAX_TRANSFERS];
 };
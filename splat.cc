@@ -0,0 +1,63 @@
+#include "splat.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr float PI = 3.14159265358979323846f;
+static constexpr float TWO_PI = 2.f * PI;
+
+static float wrap_angle(float a){
+    a = std::fmod(a, TWO_PI);
+    return a < 0.f ? a + TWO_PI : a;
+}
+
+float SplatTable::Exact(float sigma, float led_theta, float led_r, float orb_theta, float orb_r){
+    float d = std::fabs(wrap_angle(led_theta) - wrap_angle(orb_theta));
+    float dθ = d > PI ? TWO_PI - d : d;
+    float r̄ = (led_r + orb_r) * 0.5f;
+    float Δr = led_r - orb_r;
+    float d2 = (dθ * r̄) * (dθ * r̄) + (Δr * Δr);
+    return std::exp(-d2 / (2 * sigma * sigma));
+}
+
+void SplatTable::build(const float* theta, const float* r, size_t count){
+    led_theta.resize(count);
+    led_ring.resize(count);
+    for(size_t i = 0; i < count; ++i){
+        led_theta[i] = wrap_angle(theta[i]);
+        led_ring[i] = static_cast<uint8_t>(lrintf(r[i]));
+        rings = std::max(rings, led_ring[i] + 1);
+    }
+    // largest argument is dθ * r̄ = π * outer ring
+    const int entries = static_cast<int>(std::ceil(PI * (rings - 1) * STEPS_PER_UNIT)) + 2;
+    table.resize(entries);
+    for(int n = 0; n < entries; ++n){
+        float x = static_cast<float>(n) / STEPS_PER_UNIT;
+        table[n] = std::exp(-(x * x) / (2 * sigma * sigma));
+    }
+}
+
+inline float SplatTable::falloff(float x) const {
+    float pos = x * STEPS_PER_UNIT;
+    int n = static_cast<int>(pos);
+    float t = pos - n;
+    return table[n] + (table[n + 1] - table[n]) * t;
+}
+
+void SplatTable::Weights(float theta, float r, float* out) const {
+    const float c = wrap_angle(theta);
+    r = std::min(std::fabs(r), static_cast<float>(rings - 1));
+
+    // per ring: the radial term and the mean radius that scales dθ
+    float radial[256], mean_r[256];
+    for(int k = 0; k < rings; ++k){
+        radial[k] = falloff(std::fabs(k - r));
+        mean_r[k] = (k + r) * 0.5f;
+    }
+
+    for(size_t i = 0; i < led_theta.size(); ++i){
+        float d = std::fabs(led_theta[i] - c);
+        float dθ = d > PI ? TWO_PI - d : d;
+        const int k = led_ring[i];
+        out[i] = radial[k] * falloff(dθ * mean_r[k]);
+    }
+}
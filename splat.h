@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+Gaussian orb splats from a precomputed falloff table.
+
+an orb at (theta, r) lights LED i with
+    F = exp(-d2 / (2 * sigma^2)),  d2 = (dθ * r̄)^2 + Δr^2
+where dθ is the shortest angle between the two, r̄ the mean radius and Δr the
+radius difference. that splits into
+    F = G(Δr) * G(dθ * r̄),  G(x) = exp(-x^2 / (2 * sigma^2))
+so one table of G per sigma covers every orb position. per orb, the Δr and r̄
+terms are looked up once per ring; per LED it is the angle difference, one
+interpolated table fetch and a multiply. the table is a few KB and stays in
+L1, unlike a full angle x radius x LED table.
+
+worst case error against Exact() stays under MAX_ERROR for sigma >= 0.5
+(see test_splat).
+*/
+
+class SplatTable {
+public:
+    static constexpr int STEPS_PER_UNIT = 64;   // G is sampled every 1/64 of a ring
+    static constexpr float MAX_ERROR = 1.f / 4096.f;
+
+    //leds: count points with .theta (radians) and .r (integer ring radius)
+    template <typename P>
+    SplatTable(float sigma, const P* leds, size_t count) : sigma(sigma) {
+        std::vector<float> theta(count), r(count);
+        for(size_t i = 0; i < count; ++i){
+            theta[i] = leds[i].theta;
+            r[i] = leds[i].r;
+        }
+        build(theta.data(), r.data(), count);
+    }
+
+    float Sigma() const { return sigma; }
+    size_t Count() const { return led_theta.size(); }
+
+    //falloff of an orb at (theta, r) for every LED, out holds Count() floats.
+    //r is clamped to [0, outer ring]
+    void Weights(float theta, float r, float* out) const;
+
+    //the direct exp() evaluation the table is built from
+    static float Exact(float sigma, float led_theta, float led_r, float orb_theta, float orb_r);
+
+private:
+    void build(const float* theta, const float* r, size_t count);
+    float falloff(float x) const;
+
+    float sigma;
+    int rings = 0;
+    std::vector<float> led_theta;   // in [0, 2π)
+    std::vector<uint8_t> led_ring;
+    std::vector<float> table;       // G at x = n / STEPS_PER_UNIT, one spare entry for the lerp
+};
@@ -0,0 +1,106 @@
+#include "ledcontrol.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+// once every state, transition and overlay has been through a frame, the
+// render and output threads run without touching the heap
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+// every operator new in the process, any thread
+static std::atomic<uint64_t> allocations{0};
+
+static void* counted_alloc(size_t size, size_t align = 0){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(size == 0) size = 1;
+    void* p = align > alignof(std::max_align_t) ? aligned_alloc(align, (size + align - 1) / align * align) : malloc(size);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size){ return counted_alloc(size); }
+void* operator new[](size_t size){ return counted_alloc(size); }
+void* operator new(size_t size, std::align_val_t align){ return counted_alloc(size, static_cast<size_t>(align)); }
+void* operator new[](size_t size, std::align_val_t align){ return counted_alloc(size, static_cast<size_t>(align)); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { free(p); }
+
+// the controller owns its output, this lets the counter outlive it
+struct Forward : LEDOutput {
+    LEDOutput& to;
+    Forward(LEDOutput& to) : to(to) {}
+    bool Ready() const override { return to.Ready(); }
+    bool Write(const char* buffer, uint32_t len) override { return to.Write(buffer, len); }
+    const char* Name() const override { return to.Name(); }
+};
+
+static void wait_state(LEDController& ctrl, LEDState s){
+    for(int i = 0; i < 4000 && ctrl.State() != s; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+static void hold(int ms){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+// every state, a transition that gets retargeted, one that gets cut and an overlay
+static void exercise(LEDController& ctrl){
+    static const std::array<HSV, 3> warm = {HSV{0.f, 1.f, 1.f}, HSV{30.f, 1.f, 1.f}, HSV{60.f, 1.f, 1.f}};
+    static const std::array<HSV, 3> cool = {HSV{180.f, 1.f, 1.f}, HSV{210.f, 1.f, 1.f}, HSV{240.f, 1.f, 1.f}};
+    static const LEDState states[] = {LEDState::DORMANT, LEDState::ACTIVE, LEDState::RESPOND_TO_USER, LEDState::PROMPT,
+                                      LEDState::CONNECTING, LEDState::BOOT, LEDState::PLACEHOLDER_TRANSITION};
+    for(LEDState s : states){
+        ctrl.SetState(s);
+        wait_state(ctrl, s);
+        hold(60);
+    }
+    ctrl.SetPlaceholderColor({200, 40, 10});
+    hold(60);
+    ctrl.RequestState(LEDState::PROMPT, warm);
+    hold(150);
+    ctrl.RequestState(LEDState::ACTIVE, cool);
+    wait_state(ctrl, LEDState::ACTIVE);
+    ctrl.SetOverlay(LEDState::CONNECTING, true);
+    hold(60);
+    ctrl.SetOverlay(LEDState::CONNECTING, false);
+    ctrl.RequestState(LEDState::PROMPT, warm);
+    hold(150);
+    ctrl.SetState(LEDState::DORMANT);
+    wait_state(ctrl, LEDState::DORMANT);
+    hold(60);
+}
+
+static void test_steady_state(){
+    NullOutput out;
+    LEDController ctrl(std::make_unique<Forward>(out));
+    exercise(ctrl);     //first use: splat tables, stdio buffers, thread locals
+
+    uint64_t frames = out.Frames();
+    uint64_t before = allocations.load();
+    exercise(ctrl);
+    uint64_t during = allocations.load() - before;
+    frames = out.Frames() - frames;
+
+    CHECK(frames > 50, "only %llu frames rendered", (unsigned long long)frames);
+    CHECK(during == 0, "%llu allocations over %llu frames", (unsigned long long)during, (unsigned long long)frames);
+    printf("%llu frames, %llu allocations\n", (unsigned long long)frames, (unsigned long long)during);
+}
+
+int main(){
+    test_steady_state();
+    if(failures){
+        printf("test_alloc: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_alloc: OK");
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include "ledcontrol.h"
+#include "capture.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+// .ledcap captures: the format round trips through the mmapped reader, bad
+// files are refused, and a controller on a held SimClock writes the same
+// file every run with each command landing on the first frame after its time
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+using SmallFixture = RingLayout<1, 6, 12>;
+
+static std::string temp_path(const char* name){
+    return std::string("/tmp/") + name + "_" + std::to_string(getpid()) + ".ledcap";
+}
+
+static void test_round_trip(){
+    std::string path = temp_path("test_capture");
+    const ledcap_header_t layout = ledcap_header<SmallFixture>();
+    CHECK(layout.led_count == 19 && layout.frame_bytes == 72, "frame record is %u bytes", layout.frame_bytes);
+    CHECK(layout.ring_offset[0] == 18 && layout.ring_offset[2] == 0, "ring offsets follow the chain");
+
+    uint8_t grb[19 * 3];
+    {
+        CaptureWriter w;
+        CHECK(w.Open(path, layout), "open for writing");
+        for(int f = 0; f < 100; ++f){
+            for(int i = 0; i < 19 * 3; ++i) grb[i] = static_cast<uint8_t>(f * 7 + i);
+            CHECK(w.Append(f * 10000000LL - 5, grb), "append frame %d", f);
+        }
+        CHECK(w.Close(), "close");
+    }
+
+    CaptureReader r;
+    CHECK(r.Open(path), "open for reading");
+    CHECK(r.Frames() == 100 && r.Header().frame_count == 100, "%llu frames", (unsigned long long)r.Frames());
+    CHECK(r.Header().ring_count == 3 && r.Header().ring_size[1] == 6, "layout in the header");
+    for(uint64_t f = 0; f < r.Frames(); ++f){
+        CHECK(r.Time(f) == static_cast<int64_t>(f) * 10000000LL - 5, "frame %llu time", (unsigned long long)f);
+        bool same = true;
+        for(int i = 0; i < 19 * 3; ++i) same &= r.GRB(f)[i] == static_cast<uint8_t>(f * 7 + i);
+        CHECK(same, "frame %llu LEDs", (unsigned long long)f);
+        CHECK(reinterpret_cast<uintptr_t>(r.GRB(f) - 8) % 8 == 0, "frame %llu timestamp unaligned", (unsigned long long)f);
+    }
+    r.Close();
+
+    // a writer that never closed leaves frame_count 0, the size gives it
+    FILE* f = fopen(path.c_str(), "r+b");
+    uint64_t zero = 0;
+    fseek(f, offsetof(ledcap_header_t, frame_count), SEEK_SET);
+    fwrite(&zero, sizeof(zero), 1, f);
+    fclose(f);
+    CHECK(r.Open(path) && r.Frames() == 100, "unclosed capture has %llu frames", (unsigned long long)r.Frames());
+    r.Close();
+
+    // more frames claimed than the file holds, or not a capture at all
+    CHECK(truncate(path.c_str(), sizeof(ledcap_header_t) + 50 * layout.frame_bytes + 3) == 0, "truncate");
+    CHECK(r.Open(path) && r.Frames() == 50, "cut short capture has %llu frames", (unsigned long long)r.Frames());
+    r.Close();
+    f = fopen(path.c_str(), "r+b");
+    uint64_t many = 51;
+    fseek(f, offsetof(ledcap_header_t, frame_count), SEEK_SET);
+    fwrite(&many, sizeof(many), 1, f);
+    fclose(f);
+    CHECK(!r.Open(path), "frame count past the end of the file accepted");
+    f = fopen(path.c_str(), "r+b");
+    fwrite("LEDCAQ", 6, 1, f);
+    fclose(f);
+    CHECK(!r.Open(path), "bad magic accepted");
+    unlink(path.c_str());
+}
+
+// what ledrender does: hold the clock at each command, queue it, move on
+static void render(const std::string& path, bool request){
+    auto sim = std::make_unique<SimClock>();
+    SimClock* clock = sim.get();
+    clock->HoldAt(0);
+    auto out = std::make_unique<CaptureFileOutput>(path);
+    out->SetEnd(1000000000LL);
+    LEDController ctrl(std::move(out), WS2812_ENCODING_8BIT, std::move(sim));
+    auto hold = [&](int64_t at){
+        clock->HoldAt(at);
+        CHECK(clock->WaitHeld(std::chrono::seconds(10)), "render thread never reached %lld ns", (long long)at);
+    };
+    hold(0);
+    ctrl.SetState(LEDState::ACTIVE);
+    if(request){
+        hold(500000000LL);
+        ctrl.RequestState(LEDState::PROMPT, {HSV{0.f, 1.f, 1.f}, HSV{30.f, 1.f, 1.f}, HSV{60.f, 1.f, 1.f}});
+    }
+    hold(1000000000LL);
+}
+
+static void test_controller(){
+    std::string a = temp_path("test_capture_a"), b = temp_path("test_capture_b"), c = temp_path("test_capture_c");
+    render(a, true);
+    render(b, true);
+    render(c, false);
+
+    CaptureReader ra, rb, rc;
+    CHECK(ra.Open(a) && rb.Open(b) && rc.Open(c), "controller captures");
+    CHECK(ra.Frames() > 100, "only %llu frames captured", (unsigned long long)ra.Frames());
+    CHECK(ra.Frames() == rb.Frames(), "runs captured %llu and %llu frames",
+          (unsigned long long)ra.Frames(), (unsigned long long)rb.Frames());
+
+    // the same commands at the same times give the same file
+    for(uint64_t f = 0; f < std::min(ra.Frames(), rb.Frames()); ++f)
+        if(ra.Time(f) != rb.Time(f) || memcmp(ra.GRB(f), rb.GRB(f), LED_COUNT * 3) != 0){
+            CHECK(false, "held runs differ at frame %llu", (unsigned long long)f);
+            break;
+        }
+
+    // power on frame at 0, frames in time order up to the end, then the
+    // shutdown off() at the time of the last frame rendered
+    CHECK(ra.Frames() > 2 && ra.Time(0) == 0, "first frame at %lld", ra.Frames() ? (long long)ra.Time(0) : -1LL);
+    uint64_t last = ra.Frames() - 1;
+    bool ordered = true;
+    for(uint64_t f = 1; f < last; ++f) ordered &= ra.Time(f) > ra.Time(f - 1);
+    CHECK(ordered, "timestamps out of order");
+    CHECK(ra.Time(last) == ra.Time(last - 1) && ra.Time(last) <= 1000000000LL, "shutdown frame at %lld after %lld",
+          (long long)ra.Time(last), (long long)ra.Time(last - 1));
+    bool dark = true;
+    for(int i = 0; i < LED_COUNT * 3; ++i) dark &= ra.GRB(last)[i] == 0;
+    CHECK(dark, "last frame isn't the shutdown off()");
+
+    // the request lands on the first frame after 0.5 s: up to there the run
+    // without it is identical, the next frame already differs
+    uint64_t f = 0;
+    while(f < ra.Frames() && f < rc.Frames() && ra.Time(f) <= 500000000LL){
+        CHECK(ra.Time(f) == rc.Time(f) && memcmp(ra.GRB(f), rc.GRB(f), LED_COUNT * 3) == 0,
+              "runs differ before the request, at %lld", (long long)ra.Time(f));
+        ++f;
+    }
+    CHECK(f < ra.Frames() && f < rc.Frames() && memcmp(ra.GRB(f), rc.GRB(f), LED_COUNT * 3) != 0,
+          "request didn't show on the first frame after it");
+    printf("%llu frames, request showed at %.3f s\n", (unsigned long long)ra.Frames(), ra.Time(f) / 1e9);
+
+    ra.Close(); rb.Close(); rc.Close();
+    unlink(a.c_str()); unlink(b.c_str()); unlink(c.c_str());
+}
+
+int main(){
+    test_round_trip();
+    test_controller();
+    if(failures){
+        printf("test_capture: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_capture: OK");
+    return 0;
+}
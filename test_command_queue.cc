@@ -0,0 +1,70 @@
+#include "command_queue.h"
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// MpscRing: full/empty edges, and no loss, duplication or reordering per
+// producer with several producers pushing at once
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+struct cmd_t { uint32_t producer; uint32_t seq; uint64_t check; };
+
+int main(){
+    {
+        MpscRing<int, 4> ring;
+        int v = 0;
+        uint64_t pos = 0;
+        CHECK(ring.empty() && !ring.pop(v), "new ring should be empty");
+        for(int i = 0; i < 4; ++i) CHECK(ring.push(i), "push %d into a ring with room failed", i);
+        CHECK(!ring.push(99), "push into a full ring succeeded");
+        CHECK(ring.size() == 4, "size %zu, expected 4", ring.size());
+        for(int i = 0; i < 4; ++i)
+            CHECK(ring.pop(v, &pos) && v == i && pos == (uint64_t)i, "pop %d returned %d at %llu", i, v, (unsigned long long)pos);
+        CHECK(!ring.pop(v), "pop from a drained ring succeeded");
+        //wraps around with positions still counting up
+        CHECK(ring.push(7, &pos) && pos == 4, "position after wrap %llu", (unsigned long long)pos);
+        CHECK(ring.pop(v, &pos) && v == 7 && pos == 4, "pop after wrap");
+    }
+
+    const int producers = 4;
+    const uint32_t per_producer = 500000;
+    MpscRing<cmd_t, 64> ring;
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p)
+        threads.emplace_back([&ring, p]{
+            for(uint32_t i = 0; i < per_producer; ){
+                if(ring.push({static_cast<uint32_t>(p), i, i * 2654435761ull + p})) ++i;
+                else std::this_thread::yield();
+            }
+        });
+
+    std::vector<uint32_t> next(producers, 0);
+    uint64_t total = 0, expected_pos = 0;
+    while(total < producers * static_cast<uint64_t>(per_producer)){
+        cmd_t c;
+        uint64_t pos;
+        if(!ring.pop(c, &pos)){ std::this_thread::yield(); continue; }
+        if(pos != expected_pos || c.producer >= (uint32_t)producers || c.seq != next[c.producer] ||
+           c.check != c.seq * 2654435761ull + c.producer){
+            CHECK(false, "got %u/%u at %llu, expected seq %u at %llu", c.producer, c.seq, (unsigned long long)pos,
+                  c.producer < (uint32_t)producers ? next[c.producer] : 0, (unsigned long long)expected_pos);
+            break;
+        }
+        next[c.producer]++;
+        expected_pos++;
+        total++;
+    }
+    for(auto& t : threads) t.join();
+    cmd_t c;
+    CHECK(!ring.pop(c), "ring not empty after every command was taken");
+
+    if(failures){
+        printf("test_command_queue: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_command_queue: OK");
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "compositor.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+// Compositor: the four blend modes, opacity, bottom-to-top order, and a
+// solid + splat stack matching the RenderBuffer ops it replaced
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+struct rgb_t { uint8_t r, g, b; };
+
+constexpr size_t N = 4;
+
+// one color at a per LED coverage
+struct TestLayer : Layer<N> {
+    TestLayer(rgb_t c, std::initializer_list<float> alpha) : c(c) {
+        size_t i = 0;
+        for(float v : alpha) a[i++] = v;
+    }
+    void Update(const frame_time_t&) override { updates++; }
+    void Render(LayerBuffer<N>& out) override {
+        for(size_t i = 0; i < N; ++i) out.Set(i, c, a[i]);
+    }
+    rgb_t c;
+    float a[N] = {};
+    int updates = 0;
+};
+
+static bool near(float got, float want){ return std::fabs(got - want) < 1e-3f; }
+
+static void check_r(const RenderBuffer<N>& acc, std::initializer_list<float> want, const char* what){
+    size_t i = 0;
+    for(float w : want){
+        CHECK(near(acc.R(i), w), "%s: r[%zu] %f, expected %f", what, i, acc.R(i), w);
+        i++;
+    }
+}
+
+int main(){
+    const rgb_t base = {100, 100, 100};
+    const rgb_t top = {200, 50, 0};
+    RenderBuffer<N> acc;
+    LayerBuffer<N> scratch;
+
+    auto blend = [&](BlendMode mode, float opacity){
+        Compositor<N> stack;
+        stack.Push(std::make_unique<TestLayer>(base, std::initializer_list<float>{1.f, 1.f, 1.f, 1.f}));
+        stack.Push(std::make_unique<TestLayer>(top, std::initializer_list<float>{0.f, 0.5f, 1.f, 1.f}), mode, opacity);
+        acc.Clear();
+        stack.Draw(acc, scratch);
+    };
+
+    blend(BlendMode::ADD, 1.f);
+    check_r(acc, {100.f, 200.f, 300.f, 300.f}, "add");      // past 255 until the resolve
+    blend(BlendMode::ALPHA, 1.f);
+    check_r(acc, {100.f, 150.f, 200.f, 200.f}, "alpha");
+    CHECK(near(acc.G(2), 50.f) && near(acc.B(2), 0.f), "alpha g/b %f %f", acc.G(2), acc.B(2));
+    blend(BlendMode::MAX, 1.f);
+    check_r(acc, {100.f, 100.f, 200.f, 200.f}, "max");
+    CHECK(near(acc.G(2), 100.f), "max g %f", acc.G(2));
+    blend(BlendMode::MULTIPLY, 1.f);
+    check_r(acc, {100.f, 100.f + 0.5f * (200.f / 255.f - 1.f) * 100.f, 100.f * 200.f / 255.f, 100.f * 200.f / 255.f}, "multiply");
+    CHECK(near(acc.B(2), 0.f), "multiply by black b %f", acc.B(2));
+
+    // opacity scales coverage, zero skips the layer
+    blend(BlendMode::ALPHA, 0.5f);
+    check_r(acc, {100.f, 125.f, 150.f, 150.f}, "alpha at half opacity");
+    blend(BlendMode::ADD, 0.f);
+    check_r(acc, {100.f, 100.f, 100.f, 100.f}, "zero opacity");
+
+    // bottom to top: the last opaque layer wins, every layer updates once
+    {
+        Compositor<N> stack;
+        TestLayer* a = stack.Push(std::make_unique<TestLayer>(top, std::initializer_list<float>{1.f, 1.f, 1.f, 1.f}));
+        TestLayer* b = stack.Push(std::make_unique<TestLayer>(base, std::initializer_list<float>{1.f, 1.f, 1.f, 1.f}));
+        CHECK(stack.Size() == 2, "stack size %zu", stack.Size());
+        stack.Update(frame_time_t{});
+        acc.Clear();
+        stack.Draw(acc, scratch);
+        check_r(acc, {100.f, 100.f, 100.f, 100.f}, "order");
+        CHECK(a->updates == 1 && b->updates == 1, "updates %d %d", a->updates, b->updates);
+    }
+
+    // a background fill with a MixSplat orb over it, as layers, is bit exact
+    // with the RenderBuffer calls
+    {
+        const float w[N] = {0.f, 0.2f, 0.6f, 1.f};
+        RenderBuffer<N> direct;
+        direct.Fill(128.f, 128.f, 128.f);
+        direct.MixSplat(w, rgb_t{40, 120, 255}, 1.2f, 2.f);
+
+        struct Splat : Layer<N> {
+            const float* w;
+            explicit Splat(const float* w) : w(w) {}
+            void Render(LayerBuffer<N>& out) override { out.MixSplat(w, rgb_t{40, 120, 255}, 1.2f, 2.f); }
+        };
+        Compositor<N> stack;
+        stack.Push(std::make_unique<TestLayer>(rgb_t{128, 128, 128}, std::initializer_list<float>{1.f, 1.f, 1.f, 1.f}));
+        stack.Push(std::make_unique<Splat>(w));
+        acc.Clear();
+        stack.Draw(acc, scratch);
+        rgb_t want[N], got[N];
+        direct.Resolve(want);
+        acc.Resolve(got);
+        for(size_t i = 0; i < N; ++i)
+            CHECK(want[i].r == got[i].r && want[i].g == got[i].g && want[i].b == got[i].b,
+                  "led %zu: %u,%u,%u vs %u,%u,%u", i, got[i].r, got[i].g, got[i].b, want[i].r, want[i].g, want[i].b);
+    }
+
+    if(failures){
+        printf("test_compositor: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_compositor: OK");
+    return 0;
+}
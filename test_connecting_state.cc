@@ -1,5 +1,3 @@
-#ifdef __aarch64__
-
 #include "ledcontrol.h"
 #include <iostream>
 #include <thread>
@@ -69,11 +67,3 @@ int main(){
     std::cout << "WiFi symbol test finished.\n";
     return 0;
 }
-
-#else
-#include <iostream>
-int main(){
-    std::cout << "LED control only supported on aarch64 platform.\n";
-    return 0;
-}
-#endif 
\ No newline at end of file
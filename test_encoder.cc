@@ -0,0 +1,188 @@
+#include "ws2812.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// checks the table driven frame encoder and every supported SIMD kernel
+// against the per-bit encode_color, the calibrated tables against
+// correcting the colors first, and every symbol encoding against the decoder
+
+static int failures = 0;
+
+static void check_frame(const std::vector<uint8_t>& rgb, const char* what){
+    size_t count = rgb.size() / 3;
+    std::vector<char> ref(count * WS2812B_BYTES_PER_LED);
+    std::vector<char> out(count * WS2812B_BYTES_PER_LED);
+    for(size_t i = 0; i < count; ++i)
+        encode_color(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], &ref[i * WS2812B_BYTES_PER_LED]);
+    for(int k = 0; k < WS2812_KERNEL_MAX; ++k){
+        auto kernel = static_cast<ws2812_kernel>(k);
+        if(!ws2812_kernel_supported(kernel)) continue;
+        std::fill(out.begin(), out.end(), 0);
+        ws2812_encode_with(kernel, rgb.data(), count, out.data());
+        for(size_t i = 0; i < ref.size(); ++i){
+            if(ref[i] != out[i]){
+                printf("FAIL %s [%s, %zu leds]: led %zu byte %zu expected 0x%02x got 0x%02x\n", what,
+                       ws2812_kernel_name(kernel), count, i / WS2812B_BYTES_PER_LED,
+                       i % WS2812B_BYTES_PER_LED, (uint8_t)ref[i], (uint8_t)out[i]);
+                failures++;
+                break;
+            }
+        }
+    }
+}
+
+int main(){
+    // every value in every channel slot
+    for(int ch = 0; ch < 3; ++ch){
+        std::vector<uint8_t> rgb(256 * 3, 0);
+        for(int v = 0; v < 256; ++v) rgb[v * 3 + ch] = static_cast<uint8_t>(v);
+        check_frame(rgb, "exhaustive channel");
+    }
+
+    // random frames of assorted lengths
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> dis(0, 255);
+    // odd sizes exercise the scalar tails behind each vector block
+    const size_t sizes[] = {1, 2, 5, 6, 7, 15, 16, 17, 33, 61, 64, 1000, 10000};
+    for(size_t n : sizes){
+        std::vector<uint8_t> rgb(n * 3);
+        for(auto& b : rgb) b = static_cast<uint8_t>(dis(gen));
+        check_frame(rgb, "random frame");
+    }
+
+    // calibration: identity matches the plain encoder, slot gains / gamma /
+    // brightness match encoding pre-corrected colors
+    {
+        const size_t n = 61;
+        std::vector<uint8_t> rgb(n * 3), corrected(n * 3);
+        for(auto& b : rgb) b = static_cast<uint8_t>(dis(gen));
+        std::vector<uint8_t> led_slot(n);
+        for(size_t i = 0; i < n; ++i) led_slot[i] = static_cast<uint8_t>(i % 3);
+        std::vector<char> ref(n * WS2812B_BYTES_PER_LED), out(n * WS2812B_BYTES_PER_LED);
+
+        const float unity[3] = {1.f, 1.f, 1.f};
+        ws2812_calibration ident = ws2812_build_calibration(1.f, 1.f, unity, 3, led_slot.data(), n);
+        ws2812_encode_frame(rgb.data(), n, ref.data());
+        ws2812_encode_calibrated(ident, rgb.data(), n, out.data());
+        if(!ident.identity || ref != out){ puts("FAIL identity calibration"); failures++; }
+
+        const float gains[3] = {1.f, 1.66f, 0.37f};
+        struct { float gamma, brightness; } cases[] = {{1.f, 1.f}, {2.2f, 1.f}, {1.f, 0.5f}, {2.2f, 0.25f}};
+        for(auto& c : cases){
+            ws2812_calibration cal = ws2812_build_calibration(c.gamma, c.brightness, gains, 3, led_slot.data(), n);
+            for(size_t i = 0; i < n * 3; ++i)
+                corrected[i] = ws2812_correct(rgb[i], c.gamma, gains[led_slot[i / 3]], c.brightness);
+            ws2812_encode_frame(corrected.data(), n, ref.data());
+            ws2812_encode_calibrated(cal, rgb.data(), n, out.data());
+            if(ref != out){
+                printf("FAIL calibration gamma %.1f brightness %.2f\n", c.gamma, c.brightness);
+                failures++;
+            }
+            for(int k = 0; k < WS2812_KERNEL_MAX; ++k){
+                auto kernel = static_cast<ws2812_kernel>(k);
+                if(!ws2812_kernel_supported(kernel)) continue;
+                std::fill(out.begin(), out.end(), 0);
+                ws2812_encode_calibrated_with(kernel, cal, rgb.data(), n, out.data());
+                if(ref != out){
+                    printf("FAIL calibration gamma %.1f brightness %.2f on %s\n", c.gamma, c.brightness, ws2812_kernel_name(kernel));
+                    failures++;
+                }
+            }
+        }
+        // runs longer than the SIMD remap chunk, and LEDs past the slot map
+        {
+            const size_t m = 300;
+            std::vector<uint8_t> long_rgb(m * 3), long_corrected(m * 3), long_slot(250);
+            for(auto& b : long_rgb) b = static_cast<uint8_t>(dis(gen));
+            for(size_t i = 0; i < long_slot.size(); ++i) long_slot[i] = static_cast<uint8_t>(i * 3 / long_slot.size());
+            ws2812_calibration cal = ws2812_build_calibration(2.2f, 0.8f, gains, 3, long_slot.data(), long_slot.size());
+            for(size_t i = 0; i < m * 3; ++i)
+                long_corrected[i] = ws2812_correct(long_rgb[i], 2.2f, gains[i / 3 < long_slot.size() ? long_slot[i / 3] : 0], 0.8f);
+            std::vector<char> long_ref(m * WS2812B_BYTES_PER_LED), long_out(m * WS2812B_BYTES_PER_LED);
+            ws2812_encode_frame(long_corrected.data(), m, long_ref.data());
+            for(int k = 0; k < WS2812_KERNEL_MAX; ++k){
+                auto kernel = static_cast<ws2812_kernel>(k);
+                if(!ws2812_kernel_supported(kernel)) continue;
+                std::fill(long_out.begin(), long_out.end(), 0);
+                ws2812_encode_calibrated_with(kernel, cal, long_rgb.data(), m, long_out.data());
+                if(long_ref != long_out){
+                    printf("FAIL long run calibration on %s\n", ws2812_kernel_name(kernel));
+                    failures++;
+                }
+            }
+        }
+        // gamma 1 and brightness 1 keep the old led_color_t * gain rounding
+        if(ws2812_correct(200, 1.f, 0.37f, 1.f) != static_cast<uint8_t>(200 * 0.37f) ||
+           ws2812_correct(200, 1.f, 1.66f, 1.f) != 255 || ws2812_correct(255, 2.2f, 1.f, 0.f) != 0){
+            puts("FAIL ws2812_correct");
+            failures++;
+        }
+    }
+
+    // symbol encodings: sizes, a known pattern, decode round trips, calibration
+    {
+        const size_t bytes[WS2812_ENCODING_MAX] = {24, 12, 9};
+        for(int e = 0; e < WS2812_ENCODING_MAX; ++e){
+            auto enc = static_cast<ws2812_encoding>(e);
+            const char* name = ws2812_encoding_params(enc).name;
+            if(ws2812_frame_bytes(enc, 61) != 61 * bytes[e]){ printf("FAIL %s frame size\n", name); failures++; }
+
+            for(size_t n : {1, 2, 7, 61, 1000}){
+                std::vector<uint8_t> rgb(n * 3), back(n * 3);
+                for(auto& b : rgb) b = static_cast<uint8_t>(dis(gen));
+                std::vector<char> out(ws2812_frame_bytes(enc, n) + 8, 0x55);
+                ws2812_encode_as(enc, rgb.data(), n, out.data());
+                bool ok = ws2812_decode(enc, out.data(), ws2812_frame_bytes(enc, n), back.data());
+                if(!ok || back != rgb){ printf("FAIL %s round trip [%zu leds]\n", name, n); failures++; }
+                if(out[ws2812_frame_bytes(enc, n)] != 0x55){ printf("FAIL %s wrote past the frame\n", name); failures++; }
+            }
+
+            // calibrated frames decode to the corrected colors
+            const size_t n = 61;
+            std::vector<uint8_t> rgb(n * 3), corrected(n * 3), back(n * 3);
+            for(auto& b : rgb) b = static_cast<uint8_t>(dis(gen));
+            std::vector<uint8_t> led_slot(n);
+            for(size_t i = 0; i < n; ++i) led_slot[i] = static_cast<uint8_t>(i % 3);
+            const float gains[3] = {1.f, 1.66f, 0.37f};
+            ws2812_calibration cal = ws2812_build_calibration(2.2f, 0.5f, gains, 3, led_slot.data(), n);
+            for(size_t i = 0; i < n * 3; ++i)
+                corrected[i] = ws2812_correct(rgb[i], 2.2f, gains[led_slot[i / 3]], 0.5f);
+            std::vector<char> out(ws2812_frame_bytes(enc, n));
+            ws2812_encode_calibrated(cal, enc, rgb.data(), n, out.data());
+            if(!ws2812_decode(enc, out.data(), out.size(), back.data()) || back != corrected){
+                printf("FAIL %s calibration\n", name);
+                failures++;
+            }
+        }
+
+        // G=0x80 R=0x00 B=0xff, MSB first: 4 bit 1110 1000..., 3 bit 110 100...
+        const uint8_t px[3] = {0x00, 0x80, 0xff};
+        char out4[12], out3[9];
+        ws2812_encode_as(WS2812_ENCODING_4BIT, px, 1, out4);
+        ws2812_encode_as(WS2812_ENCODING_3BIT, px, 1, out3);
+        const uint8_t want4[12] = {0xe8, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0xee, 0xee, 0xee, 0xee};
+        const uint8_t want3[9] = {0xd2, 0x49, 0x24, 0x92, 0x49, 0x24, 0xdb, 0x6d, 0xb6};
+        if(memcmp(out4, want4, 12) != 0){ puts("FAIL 4 bit symbols"); failures++; }
+        if(memcmp(out3, want3, 9) != 0){ puts("FAIL 3 bit symbols"); failures++; }
+
+        // a symbol that is neither 1 nor 0 is rejected
+        uint8_t rgb[3];
+        out4[5] = static_cast<char>(0xf8);
+        out3[4] = static_cast<char>(0xff);
+        if(ws2812_decode(WS2812_ENCODING_4BIT, out4, 12, rgb) || ws2812_decode(WS2812_ENCODING_3BIT, out3, 9, rgb)){
+            puts("FAIL decoder accepted a bad symbol");
+            failures++;
+        }
+    }
+
+    printf("active kernel: %s\n", ws2812_kernel_name(ws2812_active_kernel()));
+    if(failures){
+        printf("test_encoder: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_encoder: OK");
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "ledcontrol.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// RingLayout: the orb's generated geometry against the old hand written tables, and a
+// second fixture built into the same binary through the same templates
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+template <typename T, size_t N>
+constexpr bool same(const std::array<T, N>& a, const std::array<T, N>& b){
+    for(size_t i = 0; i < N; ++i)
+        if(a[i] != b[i]) return false;
+    return true;
+}
+
+static_assert(OrbFixture::RINGS == 5 && OrbFixture::LED_COUNT == 61);
+static_assert(OrbFixture::SPI_BYTES == 61 * WS2812B_BYTES_PER_LED);
+static_assert(same(OrbFixture::offsets, {60, 52, 40, 24, 0}));
+static_assert(same(OrbFixture::incs, {0.f, 45.f, 30.f, 22.5f, 15.f}));
+static_assert(OrbFixture::ANGLE_STEPS == 1536);
+// center first entries to the chain: center last, ring 1 from 52, ring 4 from 0
+static_assert(OrbFixture::led_frame[0] == 60 && OrbFixture::led_frame[1] == 52 && OrbFixture::led_frame[37] == 0 && OrbFixture::led_frame[60] == 23);
+
+// a 43 LED fixture: center, 6, 12, 24
+using SmallFixture = RingLayout<1, 6, 12, 24>;
+static_assert(SmallFixture::LED_COUNT == 43 && same(SmallFixture::offsets, {42, 36, 24, 0}));
+static_assert(SmallFixture::ANGLE_STEPS % 48 == 0 && SmallFixture::ANGLE_STEPS >= 1024);
+
+// more rings than the orb: 127 LEDs over 7 rings
+using WideFixture = RingLayout<1, 6, 12, 18, 24, 30, 36>;
+static_assert(WideFixture::RINGS == 7 && WideFixture::LED_COUNT == 127);
+
+// set_led(polar_t) rounds in float, skip points within rounding noise of a boundary
+template <class Layout>
+static bool near_boundary(polar_t p){
+    p.normalize(Layout::RINGS - 1);
+    if(std::fabs(p.r - std::floor(p.r) - 0.5f) < 1e-4f) return true;
+    int ring = std::min(Layout::RINGS - 1, static_cast<int>(std::round(p.r)));
+    float x = p.theta / (2.f * M_PI_F) * Layout::sizes[ring];
+    return std::fabs(x - std::floor(x) - 0.5f) < 1e-3f || p.theta > 2.f * M_PI_F - 1e-4f;
+}
+
+template <class Layout>
+static void check_layout(const char* name){
+    using Matrix = BasicLEDMatrix<Layout>;
+    const auto& index = polar_index_v<Layout>;
+    constexpr auto lut = make_led_lut<Layout>();
+
+    // the LUT is in frame order: every LED centre maps back to itself
+    for(int ring = 0; ring < Layout::RINGS; ++ring)
+        for(int led = 0; led < Layout::sizes[ring]; ++led){
+            int f = Layout::offsets[ring] + led;
+            polar_index_t at = index(lut[f]);
+            CHECK(at.ring == ring && at.led == led, "%s ring %d LED %d maps to %d/%d", name, ring, led, at.ring, at.led);
+            CHECK(index.Frame(lut[f]) == f, "%s frame index %d maps to %d", name, f, index.Frame(lut[f]));
+        }
+
+    // led_frame takes each center first entry to its own frame index
+    std::array<bool, Layout::LED_COUNT> seen{};
+    for(int k = 0; k < Layout::LED_COUNT; ++k){
+        int f = Layout::led_frame[k];
+        CHECK(!seen[f], "%s frame index %d listed twice", name, f);
+        seen[f] = true;
+        CHECK(lut[f] == (polar_t{ Layout::led_theta[k], static_cast<float>(Layout::led_ring[k]) }),
+              "%s entry %d isn't at frame index %d", name, k, f);
+    }
+    CHECK(Layout::led_frame[0] == Layout::LED_COUNT - 1, "%s center is frame index %d", name, Layout::led_frame[0]);
+
+    // the layout's own splat tables, weights in frame order
+    const SplatTable& splat = FixtureRender<Layout>::Splat(1.f);
+    std::array<float, Layout::LED_COUNT> F;
+    splat.Weights(0.f, Layout::RINGS - 1, F.data());
+    int peak = 0;
+    for(int i = 1; i < Layout::LED_COUNT; ++i) if(F[i] > F[peak]) peak = i;
+    CHECK(splat.Count() == Layout::LED_COUNT && &splat == &FixtureRender<Layout>::Splat(1.f), "%s splat table", name);
+    CHECK(peak == Layout::offsets[Layout::RINGS - 1], "%s orb on the outer ring's first LED peaks at %d", name, peak);
+
+    Matrix matrix;
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> angle(-6.f * M_PI_F, 6.f * M_PI_F);
+    std::uniform_real_distribution<float> radius(0.f, Layout::RINGS - 0.6f);
+    int compared = 0;
+    for(int n = 0; n < 200000 && failures < 10; ++n){
+        polar_t p{ angle(gen), radius(gen) };
+        if(near_boundary<Layout>(p)) continue;
+        polar_t q = p;
+        auto [ring, led] = matrix.polar_to_ring(q.normalize(Layout::RINGS - 1));
+        polar_index_t at = index(p);
+        CHECK(at.ring == ring && at.led == led, "%s (%f, %f) -> %d/%d, polar_to_ring says %d/%d",
+              name, p.theta, p.r, at.ring, at.led, ring, led);
+
+        Matrix a, b;
+        a.set_led(p, {9, 8, 7});
+        b.set_leds(&p, std::array<led_color_t, 1>{{{9, 8, 7}}}.data(), 1);
+        CHECK(a.Frame() == b.Frame(), "%s (%f, %f) set_leds differs from set_led", name, p.theta, p.r);
+        compared++;
+    }
+    printf("%s: %d LEDs, %d rings, %d angle steps, %d points compared\n",
+           name, Layout::LED_COUNT, Layout::RINGS, Layout::ANGLE_STEPS, compared);
+}
+
+int main(){
+    // the generated LUT holds the positions buildLUT() used to compute at
+    // construction, moved from center first to the chain order
+    constexpr auto lut = make_led_lut<OrbFixture>();
+    for(int ring = 0; ring < 5; ++ring)
+        for(int i = 0; i < ring_sizes[ring]; ++i){
+            int idx = ring_offset(ring) + i;
+            polar_t old{ ring == 0 ? 0.f : DEG2RAD((360.0f / ring_sizes[ring]) * i), static_cast<float>(ring) };
+            CHECK(lut[idx] == old, "LED %d at (%f, %f), was (%f, %f)", idx, lut[idx].theta, lut[idx].r, old.theta, old.r);
+        }
+
+    check_layout<OrbFixture>("orb");
+    check_layout<SmallFixture>("small");
+    check_layout<WideFixture>("wide");
+
+    // set_led reaches the outer rings of a fixture larger than the orb, and
+    // clamps or rejects by the fixture's own outer radius
+    BasicLEDMatrix<WideFixture> wide;
+    wide.set_led(polar_t{0.f, 6.f}, {1, 2, 3});
+    wide.set_led(polar_t{0.f, 9.f}, {1, 2, 3});     //clamped onto ring 6, blends with the first
+    CHECK(wide.Ring(6)[0].r == 2 && wide.Ring(4)[0].r == 0, "wide set_led on ring 6: %d, ring 4: %d",
+          wide.Ring(6)[0].r, wide.Ring(4)[0].r);
+    CHECK(wide.polar_to_ring(polar_t{0.f, 5.f}).first == 5, "wide polar_to_ring ring 5");
+    CHECK(wide.polar_to_ring(polar_t{0.f, 6.5f}).first == 0xffff, "wide polar_to_ring past the outer ring");
+
+    // the small fixture's matrix only has its own 43 LEDs
+    BasicLEDMatrix<SmallFixture> small;
+    small.set_all({1, 1, 1});
+    CHECK(small.Frame().size() == 43 && small.Ring(3).Count() == 24, "small matrix shape");
+    CHECK(polar_index_v<SmallFixture>.Frame(polar_t{0.f, 3.f}) == 0, "small fixture outer ring starts the chain");
+
+    if(failures) return 1;
+    printf("test_fixture: OK\n");
+    return 0;
+}
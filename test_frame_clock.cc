@@ -0,0 +1,129 @@
+#include "frame_clock.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// FrameClock on a fake timer: exact grid deadlines, and how SKIP / CATCH_UP
+// recover from a late frame
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+// time only moves when a test renders (Spend) or the clock sleeps
+struct FakeTimer : PacingTimer {
+    int64_t now = 0;
+    std::vector<int64_t> sleeps;    //every deadline slept to
+
+    int64_t Now() override { return now; }
+    void SleepUntil(int64_t deadline_ns) override {
+        sleeps.push_back(deadline_ns);
+        if(deadline_ns > now) now = deadline_ns;
+    }
+    void Spend(int64_t ns){ now += ns; }
+};
+
+static const int64_t period = 5000000; // 200 fps
+static const int64_t t0 = 1000;        //grid start
+
+// render time inside the period doesn't stretch it, every frame waits for its own slot
+static void test_grid(){
+    FakeTimer timer;
+    timer.now = t0;
+    FrameClock clock(200.f, FrameClock::Policy::SKIP, &timer);
+    clock.Wait();
+    CHECK(timer.sleeps.empty(), "first frame on a grid slept");
+    for(int i = 1; i <= 400; ++i){
+        timer.Spend(period * (i % 10) / 10);    //0 to 90% of a period
+        clock.Wait();
+        CHECK(timer.sleeps.size() == static_cast<size_t>(i) && timer.sleeps.back() == t0 + i * period,
+              "frame %d slept to %lld, expected %lld", i, (long long)timer.sleeps.back(), (long long)(t0 + i * period));
+    }
+    FrameClock::stats_t st = clock.Stats();
+    CHECK(st.frames == 401 && st.missed == 0 && st.skipped == 0 && st.max_late_ns == 0,
+          "frames %llu missed %llu skipped %llu", (unsigned long long)st.frames, (unsigned long long)st.missed,
+          (unsigned long long)st.skipped);
+    CHECK(st.actual_fps == 200.f, "actual fps %f", st.actual_fps);
+
+    // a frame that ends right on its deadline isn't late
+    timer.Spend(period);
+    clock.Wait();
+    CHECK(clock.Stats().missed == 0, "frame on its deadline counted as missed");
+
+    // a new rate restarts the grid: the next frame runs straight away
+    clock.SetTargetFPS(100.f);
+    size_t slept = timer.sleeps.size();
+    int64_t start = timer.now;
+    clock.Wait();
+    clock.Wait();
+    CHECK(timer.sleeps.size() == slept + 1 && timer.sleeps.back() == start + 10000000,
+          "regridded at 100 fps, slept to %lld", (long long)timer.sleeps.back());
+}
+
+// one frame overruns by 2.5 periods: SKIP drops the three slots it covered
+// and sleeps to the next one on the grid
+static void test_skip(){
+    FakeTimer timer;
+    timer.now = t0;
+    FrameClock clock(200.f, FrameClock::Policy::SKIP, &timer);
+    clock.Wait();
+    timer.Spend(period * 7 / 2);
+    clock.Wait();
+    FrameClock::stats_t st = clock.Stats();
+    CHECK(st.missed == 1 && st.skipped == 3, "SKIP missed %llu skipped %llu, expected 1 and 3",
+          (unsigned long long)st.missed, (unsigned long long)st.skipped);
+    CHECK(st.max_late_ns == period * 5 / 2, "late by %lld ns", (long long)st.max_late_ns);
+    CHECK(timer.sleeps.size() == 1 && timer.sleeps[0] == t0 + 4 * period, "SKIP resumed at %lld, expected slot 4",
+          timer.sleeps.empty() ? -1LL : (long long)(timer.sleeps[0] - t0) / period);
+    clock.Wait();
+    CHECK(timer.sleeps.back() == t0 + 5 * period, "SKIP left the grid");
+}
+
+// CATCH_UP runs the overdue frames back to back, then waits on the grid again
+static void test_catch_up(){
+    FakeTimer timer;
+    timer.now = t0;
+    FrameClock clock(200.f, FrameClock::Policy::CATCH_UP, &timer);
+    clock.Wait();
+    timer.Spend(period * 5 / 2);
+    clock.Wait();
+    clock.Wait();
+    FrameClock::stats_t st = clock.Stats();
+    CHECK(timer.sleeps.empty(), "CATCH_UP slept on an overdue frame");
+    CHECK(st.missed == 2 && st.skipped == 0, "CATCH_UP missed %llu skipped %llu, expected 2 and 0",
+          (unsigned long long)st.missed, (unsigned long long)st.skipped);
+    clock.Wait();
+    CHECK(timer.sleeps.size() == 1 && timer.sleeps[0] == t0 + 3 * period, "CATCH_UP didn't wait for slot 3 once back on the grid");
+
+    // too far behind, it gives up and resyncs like SKIP
+    timer.Spend(period * (FrameClock::MAX_CATCH_UP + 2));
+    clock.Wait();
+    st = clock.Stats();
+    int64_t behind = FrameClock::MAX_CATCH_UP + 2;
+    CHECK(st.skipped == static_cast<uint64_t>(behind), "CATCH_UP skipped %llu after %lld missed slots",
+          (unsigned long long)st.skipped, (long long)behind);
+    CHECK(timer.sleeps.back() == t0 + (4 + behind) * period, "CATCH_UP resynced to %lld",
+          (long long)(timer.sleeps.back() - t0) / period);
+}
+
+// the real timer never wakes before its deadline
+static void test_monotonic(){
+    MonotonicTimer timer;
+    FrameClock clock(1000.f, FrameClock::Policy::SKIP, &timer);
+    clock.Wait();
+    int64_t start = timer.Now();
+    for(int i = 0; i < 5; ++i) clock.Wait();
+    CHECK(timer.Now() - start >= 4 * 1000000, "5 frames at 1000 fps took %.2f ms", (timer.Now() - start) / 1e6);
+}
+
+int main(){
+    test_grid();
+    test_skip();
+    test_catch_up();
+    test_monotonic();
+    if(failures){
+        printf("test_frame_clock: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_frame_clock: OK");
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "frame_queue.h"
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+// SpscRing: full/empty edges and ordering under a concurrent producer/consumer.
+// LatestSlot: the newest value always wins, and is never torn or seen twice
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+struct frame_t { uint64_t seq; uint64_t check; };
+
+int main(){
+    {
+        SpscRing<int, 4> ring;
+        int v = 0;
+        CHECK(ring.empty() && !ring.pop(v), "new ring should be empty");
+        for(int i = 0; i < 4; ++i) CHECK(ring.push(i), "push %d into a ring with room failed", i);
+        CHECK(!ring.push(99), "push into a full ring succeeded");
+        CHECK(ring.size() == 4, "size %zu, expected 4", ring.size());
+        for(int i = 0; i < 4; ++i){
+            CHECK(ring.pop(v) && v == i, "pop %d returned %d", i, v);
+        }
+        CHECK(!ring.pop(v), "pop from a drained ring succeeded");
+    }
+
+    const uint64_t count = 2000000;
+    SpscRing<frame_t, 8> ring;
+    std::thread producer([&]{
+        for(uint64_t i = 0; i < count; ){
+            if(ring.push({i, i * 2654435761u})) ++i;
+            else std::this_thread::yield();
+        }
+    });
+    uint64_t expected = 0;
+    while(expected < count){
+        frame_t f;
+        if(!ring.pop(f)){ std::this_thread::yield(); continue; }
+        if(f.seq != expected || f.check != expected * 2654435761u){
+            CHECK(false, "got frame %llu, expected %llu", (unsigned long long)f.seq, (unsigned long long)expected);
+            break;
+        }
+        ++expected;
+    }
+    producer.join();
+
+    {
+        LatestSlot<int> slot;
+        int v = 0;
+        CHECK(!slot.fresh() && !slot.take(v), "new slot should be empty");
+        CHECK(!slot.publish(1), "first publish replaced something");
+        CHECK(slot.publish(2) && slot.publish(3), "publish over an untaken value not reported");
+        CHECK(slot.take(v) && v == 3, "took %d, expected the newest 3", v);
+        CHECK(!slot.take(v), "took the same value twice");
+        CHECK(!slot.publish(4) && slot.take(v) && v == 4, "publish after a take");
+    }
+
+    // the consumer only ever moves forwards, and ends on the last value
+    LatestSlot<frame_t> latest;
+    std::thread publisher([&]{
+        for(uint64_t i = 1; i <= count; ++i) latest.publish({i, i * 2654435761u});
+    });
+    uint64_t last = 0, taken = 0;
+    while(last < count){
+        frame_t f;
+        if(!latest.take(f)){ std::this_thread::yield(); continue; }
+        if(f.seq <= last || f.check != f.seq * 2654435761u){
+            CHECK(false, "took frame %llu after %llu", (unsigned long long)f.seq, (unsigned long long)last);
+            break;
+        }
+        last = f.seq;
+        ++taken;
+    }
+    publisher.join();
+    printf("LatestSlot: %llu of %llu values taken\n", (unsigned long long)taken, (unsigned long long)count);
+
+    if(failures){
+        printf("test_frame_queue: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_frame_queue: OK");
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "frame_stats.h"
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// LatencyHistogram bucketing and percentiles, concurrent recording, StageTimer laps
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+static bool within(int64_t got, int64_t want, double tol){
+    return got >= want * (1.0 - tol) && got <= want * (1.0 + tol);
+}
+
+int main(){
+    // every value lands in a bucket whose upper bound covers it and the
+    // previous bucket's doesn't, with at most 12.5% of slack
+    for(uint64_t ns : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 123456ull, 999999999ull, 1ull << 40}){
+        int b = LatencyHistogram::bucket(ns);
+        CHECK(b >= 0 && b < LatencyHistogram::BUCKETS, "%llu bucket %d out of range", (unsigned long long)ns, b);
+        CHECK(LatencyHistogram::bucket_upper(b) >= ns, "%llu above its bucket", (unsigned long long)ns);
+        CHECK(b == 0 || LatencyHistogram::bucket_upper(b - 1) < ns, "%llu fits the previous bucket", (unsigned long long)ns);
+        CHECK(LatencyHistogram::bucket_upper(b) <= ns + ns / 8, "%llu bucket too wide", (unsigned long long)ns);
+    }
+    for(int b = 1; b < LatencyHistogram::BUCKETS; ++b)
+        if(LatencyHistogram::bucket_upper(b) <= LatencyHistogram::bucket_upper(b - 1)){
+            CHECK(false, "bucket %d bounds not increasing", b);
+            break;
+        }
+
+    // 1..10000 us uniformly: p50 ~5 ms, p99 ~9.9 ms, max exact
+    {
+        LatencyHistogram h;
+        for(int us = 1; us <= 10000; ++us) h.Record(us * 1000LL);
+        auto s = h.Summary();
+        CHECK(s.count == 10000, "count %llu", (unsigned long long)s.count);
+        CHECK(within(s.p50_ns, 5000000, 0.125), "p50 %lld", (long long)s.p50_ns);
+        CHECK(within(s.p99_ns, 9900000, 0.125), "p99 %lld", (long long)s.p99_ns);
+        CHECK(s.max_ns == 10000000, "max %lld", (long long)s.max_ns);
+        CHECK(within(static_cast<int64_t>(s.mean_ns), 5000500, 0.001), "mean %.0f", s.mean_ns);
+        CHECK(h.Percentile(1.0) == s.max_ns, "p100 isn't the max");
+        h.Reset();
+        s = h.Summary();
+        CHECK(s.count == 0 && s.p99_ns == 0 && s.max_ns == 0, "reset kept samples");
+    }
+
+    // a long tail only shows in p99
+    {
+        LatencyHistogram h;
+        for(int i = 0; i < 990; ++i) h.Record(100000);
+        for(int i = 0; i < 10; ++i) h.Record(5000000);
+        auto s = h.Summary();
+        CHECK(within(s.p50_ns, 100000, 0.125), "p50 %lld", (long long)s.p50_ns);
+        CHECK(within(s.p99_ns, 100000, 0.125), "p99 %lld", (long long)s.p99_ns);
+        CHECK(s.max_ns == 5000000, "max %lld", (long long)s.max_ns);
+        h.Record(5000000);
+        CHECK(within(h.Percentile(0.995), 5000000, 0.125), "tail missing from p99.5");
+    }
+
+    // render and output threads record into the same stats without losing samples
+    {
+        StageStats stats;
+        const int per_thread = 100000;
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t)
+            threads.emplace_back([&stats, t]{
+                for(int i = 0; i < per_thread; ++i)
+                    stats.Record(t & 1 ? FrameStage::ENCODE : FrameStage::TRANSFER, 1000 + i % 7);
+            });
+        for(auto& t : threads) t.join();
+        auto snap = stats.Snapshot();
+        CHECK(snap[static_cast<int>(FrameStage::ENCODE)].count == 2 * per_thread, "encode count %llu",
+              (unsigned long long)snap[static_cast<int>(FrameStage::ENCODE)].count);
+        CHECK(snap[static_cast<int>(FrameStage::TRANSFER)].count == 2 * per_thread, "transfer count");
+        CHECK(snap[static_cast<int>(FrameStage::TRANSFER)].max_ns == 1006, "max lost under contention");
+        CHECK(snap[static_cast<int>(FrameStage::DRAW)].count == 0, "draw recorded from nowhere");
+    }
+
+    // laps of the same stage add up, each touched stage is recorded once per frame
+    {
+        StageStats stats;
+        StageTimer timer(stats);
+        timer.Lap(FrameStage::UPDATE);   // not started, ignored
+        for(int frame = 0; frame < 3; ++frame){
+            timer.Start();
+            timer.Lap(FrameStage::COMPOSE);
+            timer.Lap(FrameStage::UPDATE);
+            timer.Lap(FrameStage::COMPOSE);
+            timer.Finish(FrameStage::DRAW);
+        }
+        CHECK(!timer.Running(), "still running after Finish");
+        timer.Finish();                  // second Finish records nothing
+        auto snap = stats.Snapshot();
+        CHECK(snap[static_cast<int>(FrameStage::UPDATE)].count == 3, "update count %llu",
+              (unsigned long long)snap[static_cast<int>(FrameStage::UPDATE)].count);
+        CHECK(snap[static_cast<int>(FrameStage::COMPOSE)].count == 3, "compose recorded per lap");
+        CHECK(snap[static_cast<int>(FrameStage::DRAW)].count == 3, "draw count");
+        CHECK(snap[static_cast<int>(FrameStage::ENCODE)].count == 0, "encode touched");
+    }
+
+    if(failures){
+        printf("test_frame_stats: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_frame_stats: OK");
+    return 0;
+}
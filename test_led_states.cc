@@ -1,5 +1,3 @@
-#ifdef __aarch64__
-
 #include "ledcontrol.h"
 #include <iostream>
 #include <thread>
@@ -118,12 +116,3 @@ int main() {
     std::cout << "Test finished, exiting.\n";
     return 0;
 }
-
-#else
-#include <iostream>
-
-int main() {
-    std::cout << "LED control is only supported on aarch64 platform.\n";
-    return 0;
-}
-#endif 
\ No newline at end of file
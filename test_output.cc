@@ -0,0 +1,557 @@
+#include "ledcontrol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <sys/stat.h>
+
+// runs the controller against the in-memory, file, FIFO and segmented backends
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+static const size_t frame_bytes = LED_COUNT * WS2812B_BYTES_PER_LED;
+
+static bool all_off(const char* frame){
+    for(size_t i = 0; i < frame_bytes; ++i)
+        if((uint8_t)frame[i] != WS2812B_LOW) return false;
+    return true;
+}
+
+// the controller owns its output, this lets the capture outlive it
+struct Forward : LEDOutput {
+    LEDOutput& to;
+    Forward(LEDOutput& to) : to(to) {}
+    bool Ready() const override { return to.Ready(); }
+    bool Write(const char* buffer, uint32_t len) override { return to.Write(buffer, len); }
+    bool WriteFrame(const char* buffer, uint32_t len, int64_t time_ns) override { return to.WriteFrame(buffer, len, time_ns); }
+    const char* Name() const override { return to.Name(); }
+};
+
+static void test_capture(){
+    CaptureOutput capture;
+    CaptureOutput* cap = &capture;
+    {
+        LEDController ctrl(std::make_unique<Forward>(capture));
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+    auto frames = cap->Captured();
+    CHECK(frames.size() >= 3, "expected several frames, got %zu", frames.size());
+    if(frames.size() < 3) return;
+
+    bool lit = false;
+    for(auto& f : frames){
+        CHECK(f.size() == frame_bytes, "frame is %zu bytes, expected %zu", f.size(), frame_bytes);
+        if(f.size() == frame_bytes && !all_off(f.data())) lit = true;
+    }
+    CHECK(all_off(frames.front().data()), "first frame should be the power-on off()");
+    CHECK(all_off(frames.back().data()), "last frame should be the shutdown off()");
+    CHECK(lit, "dormant state never lit an LED");
+    CHECK(cap->Frames() == frames.size(), "frame counter %llu != %zu captured",
+          (unsigned long long)cap->Frames(), frames.size());
+}
+
+static void test_file(){
+    const char* path = "/tmp/test_output_frames.bin";
+    uint64_t frames = 0;
+    {
+        LEDController ctrl(std::make_unique<FileOutput>(path));
+        CHECK(ctrl.Output()->Ready(), "file backend failed to open %s", path);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        frames = ctrl.Output()->Frames();
+    }
+    struct stat st;
+    CHECK(stat(path, &st) == 0, "missing %s", path);
+    CHECK(st.st_size % frame_bytes == 0, "file size %lld is not a whole number of frames", (long long)st.st_size);
+    CHECK((uint64_t)st.st_size >= frames * frame_bytes, "file holds fewer frames than were written");
+    unlink(path);
+}
+
+static void test_fifo(){
+    const char* path = "/tmp/test_output_frames.fifo";
+    unlink(path);
+    CHECK(mkfifo(path, 0600) == 0, "mkfifo %s failed", path);
+    int rd = open(path, O_RDONLY | O_NONBLOCK);
+    {
+        FileOutput out(path);
+        CHECK(out.Ready() && std::string(out.Name()) == "fifo", "fifo backend failed to open");
+        std::vector<char> frame(frame_bytes, (char)WS2812B_LOW);
+        for(int i = 0; i < 4; ++i) out.Write(frame.data(), frame.size());
+        CHECK(out.Frames() == 4, "fifo accepted %llu of 4 frames", (unsigned long long)out.Frames());
+    }
+    std::vector<char> back(frame_bytes * 4);
+    ssize_t n = read(rd, back.data(), back.size());
+    CHECK(n == (ssize_t)back.size(), "read %zd bytes back from the fifo", n);
+    close(rd);
+    unlink(path);
+}
+
+// CONNECTING holds each wifi element for 800ms at 20 fps, most frames repeat
+static void test_skip_unchanged(){
+    CaptureOutput capture;
+    {
+        LEDController ctrl(std::make_unique<Forward>(capture));
+        ctrl.SetState(LEDState::CONNECTING);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        auto counters = ctrl.FrameCounters();
+        CHECK(counters.skipped > 5, "expected unchanged frames to be skipped, skipped %llu",
+              (unsigned long long)counters.skipped);
+        //the output thread may be between Write() and bumping its counter
+        CHECK(capture.Frames() - counters.sent <= 1, "output saw %llu frames, controller sent %llu",
+              (unsigned long long)capture.Frames(), (unsigned long long)counters.sent);
+        auto frames = capture.Captured();
+        for(size_t i = 1; i < frames.size(); ++i)
+            CHECK(frames[i] != frames[i - 1], "frame %zu repeats the previous one without keep-alive", i);
+
+        //with a keep-alive the static frames get refreshed again
+        ctrl.SetKeepAlive(std::chrono::milliseconds(100));
+        auto before = ctrl.FrameCounters();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        auto after = ctrl.FrameCounters();
+        CHECK(after.sent - before.sent >= 8, "keep-alive sent only %llu frames in 1s",
+              (unsigned long long)(after.sent - before.sent));
+    }
+}
+
+// brightness goes through the encoder tables, a static frame is re-sent with them
+static void test_calibration(){
+    CaptureOutput capture;
+    {
+        LEDController ctrl(std::make_unique<Forward>(capture));
+        ctrl.SetState(LEDState::CONNECTING);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        size_t before = capture.Captured().size();
+        ctrl.SetBrightness(0.f);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto frames = capture.Captured();
+        CHECK(frames.size() > before, "brightness change didn't resend the static frame");
+        CHECK(!frames.empty() && all_off(frames.back().data()), "brightness 0 should encode an all off frame");
+        CHECK(ctrl.Brightness() == 0.f, "brightness reads back %f", ctrl.Brightness());
+
+        ctrl.SetBrightness(1.f);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        frames = capture.Captured();
+        CHECK(!frames.empty() && !all_off(frames.back().data()), "brightness 1 should light the frame again");
+
+        bool threw = false;
+        try { ctrl.SetRingGain(5, 1.f); } catch(const std::out_of_range&) { threw = true; }
+        CHECK(threw, "SetRingGain(5) should throw");
+    }
+}
+
+// stands in for a 61 LED frame at 2.5MHz on the bus
+struct SlowOutput : NullOutput {
+    bool Write(const char* buffer, uint32_t len) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(4700));
+        return NullOutput::Write(buffer, len);
+    }
+};
+
+static void test_output_thread(){
+    //ACTIVE paced well past the bus rate, QUEUE must apply backpressure
+    {
+        LEDController ctrl(std::make_unique<SlowOutput>());
+        ctrl.SetStateFPS(LEDState::ACTIVE, 1000.f);
+        ctrl.SetState(LEDState::ACTIVE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        auto c = ctrl.FrameCounters();
+        CHECK(c.dropped == 0, "QUEUE policy dropped %llu frames", (unsigned long long)c.dropped);
+        CHECK(c.max_queue_depth <= 4, "queue depth %zu beyond ring size", c.max_queue_depth);
+        CHECK(c.sent > 20, "only %llu frames made it through a 4.7ms bus in 500ms", (unsigned long long)c.sent);
+    }
+    //LATEST_WINS never stalls the renderer, overtaken frames are dropped
+    {
+        LEDController ctrl(std::make_unique<SlowOutput>());
+        ctrl.SetOutputPolicy(LEDController::OutputPolicy::LATEST_WINS);
+        ctrl.SetStateFPS(LEDState::ACTIVE, 1000.f);
+        ctrl.SetState(LEDState::ACTIVE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        auto c = ctrl.FrameCounters();
+        CHECK(c.dropped > 0, "LATEST_WINS dropped nothing while outrunning the bus");
+        CHECK(c.sent > 20, "only %llu frames sent", (unsigned long long)c.sent);
+    }
+}
+
+// every frame with the animation time it shows, each write taking delay
+struct TimedCapture : LEDOutput {
+    struct frame_t { int64_t time_ns; std::vector<char> data; };
+    std::chrono::microseconds delay;
+    std::mutex mtx;
+    std::vector<frame_t> frames;
+
+    TimedCapture(std::chrono::microseconds delay = std::chrono::microseconds(0)) : delay(delay) {}
+    bool Ready() const override { return true; }
+    bool Write(const char* buffer, uint32_t len) override { return WriteFrame(buffer, len, -1); }
+    bool WriteFrame(const char* buffer, uint32_t len, int64_t time_ns) override {
+        std::this_thread::sleep_for(delay);
+        std::lock_guard<std::mutex> lock(mtx);
+        frames.push_back({time_ns, std::vector<char>(buffer, buffer + len)});
+        count(len);
+        return true;
+    }
+    const char* Name() const override { return "timed capture"; }
+};
+
+// 300 ms of ACTIVE on a held SimClock, rendered identically whatever the output
+static void render_held(LEDOutput& out, LEDController::OutputPolicy policy){
+    auto sim = std::make_unique<SimClock>();
+    SimClock* clock = sim.get();
+    clock->HoldAt(0);
+    LEDController ctrl(std::make_unique<Forward>(out), WS2812_ENCODING_8BIT, std::move(sim));
+    ctrl.SetOutputPolicy(policy);
+    CHECK(clock->WaitHeld(std::chrono::seconds(10)), "render thread never started");
+    ctrl.SetState(LEDState::ACTIVE);
+    clock->HoldAt(300000000LL);
+    CHECK(clock->WaitHeld(std::chrono::seconds(10)), "render thread never reached 300 ms");
+}
+
+// LATEST_WINS on a bus far slower than the renderer: frames in between are
+// dropped, never sent out of order, and the last frame rendered is the last sent
+static void test_latest_wins(){
+    TimedCapture every, slow(std::chrono::milliseconds(20));
+    render_held(every, LEDController::OutputPolicy::QUEUE);
+    render_held(slow, LEDController::OutputPolicy::LATEST_WINS);
+
+    size_t n = slow.frames.size(), m = every.frames.size();
+    CHECK(n >= 3 && m > n, "LATEST_WINS sent %zu frames, QUEUE %zu", n, m);
+    if(n < 3 || m < 3) return;
+    for(size_t i = 1; i + 1 < n; ++i)
+        CHECK(slow.frames[i].time_ns > slow.frames[i - 1].time_ns, "frame %zu sent after a newer one", i);
+    // the one before the shutdown off()
+    const auto& last = slow.frames[n - 2];
+    const auto& rendered = every.frames[m - 2];
+    CHECK(last.time_ns == rendered.time_ns && last.data == rendered.data,
+          "last sent frame is from %.1f ms, last rendered from %.1f ms", last.time_ns / 1e6, rendered.time_ns / 1e6);
+}
+
+// the 3 bit encoding sends 9 bytes per LED, every frame decodes back
+static void test_dense_encoding(){
+    CaptureOutput capture;
+    {
+        LEDController ctrl(std::make_unique<Forward>(capture), WS2812_ENCODING_3BIT);
+        CHECK(ctrl.Encoding() == WS2812_ENCODING_3BIT, "encoding not kept");
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    auto frames = capture.Captured();
+    CHECK(frames.size() >= 3, "expected several frames, got %zu", frames.size());
+    bool lit = false;
+    for(auto& f : frames){
+        CHECK(f.size() == LED_COUNT * 9u, "3 bit frame is %zu bytes", f.size());
+        std::vector<uint8_t> rgb(LED_COUNT * 3);
+        CHECK(ws2812_decode(WS2812_ENCODING_3BIT, f.data(), f.size(), rgb.data()), "3 bit frame doesn't decode");
+        for(auto c : rgb) lit |= c != 0;
+    }
+    CHECK(lit, "dormant state never lit an LED");
+}
+
+static std::vector<char> read_file(const char* path){
+    std::vector<char> data;
+    FILE* f = fopen(path, "rb");
+    if(!f) return data;
+    char chunk[4096];
+    size_t n;
+    while((n = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(f);
+    return data;
+}
+
+// three buses: the outer ring, ring 3 on a FIFO, the inner rings
+static void test_segmented(){
+    const char* paths[3] = { "/tmp/test_output_seg0.bin", "/tmp/test_output_seg1.fifo", "/tmp/test_output_seg2.bin" };
+    const size_t first[3] = { 0, 24, 40 }, count[3] = { 24, 16, 21 };
+    const size_t longest = 24 * WS2812B_BYTES_PER_LED;
+    unlink(paths[1]);
+    CHECK(mkfifo(paths[1], 0600) == 0, "mkfifo %s failed", paths[1]);
+    int rd = open(paths[1], O_RDONLY | O_NONBLOCK);
+
+    std::vector<char> frame(frame_bytes);
+    for(size_t i = 0; i < frame_bytes; ++i) frame[i] = static_cast<char>(i * 7 + 1);
+    for(bool sync : { true, false }){
+        {
+            std::vector<led_segment_t> segs;
+            for(int i = 0; i < 3; ++i) segs.push_back({ std::make_unique<FileOutput>(paths[i]), first[i], count[i] });
+            SegmentedOutput out(std::move(segs), sync);
+            CHECK(out.Ready() && out.Segments() == 3, "segmented output not ready");
+            CHECK(out.Write(frame.data(), frame.size()) && out.Write(frame.data(), frame.size()), "segmented write failed");
+            CHECK(!out.Write(frame.data(), frame_bytes - 1), "short frame should be refused");
+            CHECK(out.Frames() == 2 && out.Segment(1).Frames() == 2, "frames counted %llu", (unsigned long long)out.Frames());
+        }
+        std::vector<char> fifo(2 * longest);
+        ssize_t got = read(rd, fifo.data(), fifo.size());
+        fifo.resize(got > 0 ? got : 0);
+        for(int i = 0; i < 3; ++i){
+            std::vector<char> data = i == 1 ? fifo : read_file(paths[i]);
+            size_t bytes = count[i] * WS2812B_BYTES_PER_LED, len = sync ? longest : bytes;
+            CHECK(data.size() == 2 * len, "segment %d holds %zu bytes, expected %zu", i, data.size(), 2 * len);
+            if(data.size() != 2 * len) continue;
+            // front padding holds the line low, the LEDs' bytes end every transfer
+            CHECK(std::all_of(data.begin(), data.begin() + (len - bytes), [](char c){ return c == 0; }), "segment %d padding", i);
+            CHECK(memcmp(data.data() + len - bytes, frame.data() + first[i] * WS2812B_BYTES_PER_LED, bytes) == 0, "segment %d bytes", i);
+        }
+    }
+    close(rd);
+
+    // the controller drives all three buses through one output
+    uint64_t frames = 0;
+    {
+        std::vector<led_segment_t> segs;
+        for(int i = 0; i < 3; i += 2) segs.push_back({ std::make_unique<FileOutput>(paths[i]), first[i], count[i] });
+        segs.push_back({ std::make_unique<CaptureOutput>(), first[1], count[1] });
+        SegmentedOutput out(std::move(segs));
+        {
+            LEDController ctrl(std::make_unique<Forward>(out));
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        frames = out.Frames();
+        CHECK(frames >= 3, "segmented controller sent %llu frames", (unsigned long long)frames);
+        for(size_t i = 0; i < out.Segments(); ++i)
+            CHECK(out.Segment(i).Frames() == frames, "bus %zu saw %llu of %llu frames", i,
+                  (unsigned long long)out.Segment(i).Frames(), (unsigned long long)frames);
+    }
+    for(int i = 0; i < 3; i += 2)
+        CHECK(read_file(paths[i]).size() == frames * longest, "bus file %d size", i);
+    for(auto* p : paths) unlink(p);
+}
+
+// every stage of an ACTIVE frame shows up in GetStats and the metrics file
+static void test_stage_stats(){
+    const char* path = "/tmp/test_output_metrics.txt";
+    unlink(path);
+    CaptureOutput capture;
+    {
+        LEDController ctrl(std::make_unique<Forward>(capture));
+        ctrl.SetMetricsFile(path, std::chrono::milliseconds(20));
+        ctrl.SetState(LEDState::ACTIVE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        auto stats = ctrl.GetStats();
+        for(int i = 0; i < StageStats::STAGES; ++i){
+            const auto& s = stats.stages[i];
+            const char* name = frame_stage_name(static_cast<FrameStage>(i));
+            CHECK(s.count > 0, "no %s samples", name);
+            CHECK(s.p50_ns <= s.p99_ns && s.p99_ns <= s.max_ns, "%s percentiles out of order", name);
+        }
+        CHECK(stats.stages[static_cast<int>(FrameStage::TRANSFER)].count <= stats.frames.sent,
+              "more transfers timed than frames sent");
+        uint64_t encoded = stats.stages[static_cast<int>(FrameStage::ENCODE)].count;
+        ctrl.ResetStats();
+        CHECK(ctrl.GetStats().stages[static_cast<int>(FrameStage::ENCODE)].count < encoded, "reset left samples behind");
+    }
+    std::vector<char> text = read_file(path);
+    std::string metrics(text.begin(), text.end());
+    CHECK(metrics.find("pacing ") != std::string::npos, "metrics file has no pacing line");
+    CHECK(metrics.find("\ntransfer ") != std::string::npos, "metrics file has no transfer line");
+    unlink(path);
+}
+
+// callers on several threads never block, every command is applied at a
+// frame boundary and a burst inside one frame coalesces to its last state
+static void test_commands(){
+    NullOutput out;
+    LEDController ctrl(std::make_unique<Forward>(out));
+    ctrl.SetStateFPS(LEDState::DORMANT, 20.f);
+    std::vector<std::thread> callers;
+    std::atomic<uint64_t> accepted{0};
+    for(int t = 0; t < 4; ++t)
+        callers.emplace_back([&]{
+            for(int i = 0; i < 200; ++i){
+                accepted += ctrl.SetState(i & 1 ? LEDState::DORMANT : LEDState::PROMPT);
+                accepted += ctrl.SetPlaceholderColor({uint8_t(i), 0, 0});
+            }
+        });
+    for(auto& t : callers) t.join();
+    //a full queue only rejects, the caller decides to retry
+    uint64_t attempts = 1;
+    while(!ctrl.SetState(LEDState::BOOT)){
+        attempts++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for(int i = 0; i < 100 && ctrl.State() != LEDState::BOOT; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(ctrl.State() == LEDState::BOOT, "last SetState never applied");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));  //counters land just after the state
+
+    auto c = ctrl.CommandStats();
+    CHECK(c.queued == accepted + 1, "queued %llu, accepted %llu", (unsigned long long)c.queued, (unsigned long long)accepted + 1);
+    CHECK(c.applied == c.queued, "applied %llu of %llu", (unsigned long long)c.applied, (unsigned long long)c.queued);
+    CHECK(c.queued + c.rejected == 1600 + attempts, "%llu commands unaccounted for",
+          (unsigned long long)(1600 + attempts - c.queued - c.rejected));
+    CHECK(c.coalesced > 0, "a burst of %llu commands didn't coalesce", (unsigned long long)c.queued);
+    CHECK(c.latency.count == c.applied && c.latency.max_ns > 0, "latency not measured");
+}
+
+static bool wait_state(LEDController& ctrl, LEDState s, int ms){
+    for(int i = 0; i < ms && ctrl.State() != s; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return ctrl.State() == s;
+}
+
+// requests landing mid-transition retarget it or cut it short within a frame
+static void test_transitions(){
+    const std::array<HSV, 3> warm = {HSV{0.f, 1.f, 1.f}, HSV{30.f, 1.f, 1.f}, HSV{60.f, 1.f, 1.f}};
+    const std::array<HSV, 3> cool = {HSV{180.f, 1.f, 1.f}, HSV{210.f, 1.f, 1.f}, HSV{240.f, 1.f, 1.f}};
+    NullOutput out;
+    LEDController ctrl(std::make_unique<Forward>(out));
+    ctrl.RequestState(LEDState::PROMPT, warm);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    CHECK(ctrl.State() == LEDState::DORMANT, "state switched before the transition ended");
+    ctrl.RequestState(LEDState::ACTIVE, cool);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto c = ctrl.CommandStats();
+    CHECK(c.retargeted == 1, "second request didn't retarget the transition (%llu)", (unsigned long long)c.retargeted);
+
+    //the retargeted transition still lands, on the newest state
+    CHECK(wait_state(ctrl, LEDState::ACTIVE, 4000), "retargeted transition never finished");
+
+    ctrl.RequestState(LEDState::PROMPT, warm);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ctrl.SetState(LEDState::BOOT);
+    CHECK(wait_state(ctrl, LEDState::BOOT, 200), "SetState waited on the transition");
+    c = ctrl.CommandStats();
+    CHECK(c.cut == 1, "transition not cut short (%llu)", (unsigned long long)c.cut);
+    CHECK(c.state_latency.count == 4, "%llu state changes measured", (unsigned long long)c.state_latency.count);
+    CHECK(c.state_latency.max_ns < 100000000, "worst state change took %.1f ms", c.state_latency.max_ns / 1e6);
+    //nothing left pending, BOOT stays
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    CHECK(ctrl.State() == LEDState::BOOT, "cut transition came back");
+}
+
+static led_color_t last_center(CaptureOutput& capture){
+    auto frames = capture.Captured();
+    uint8_t rgb[LED_COUNT * 3] = {};
+    if(frames.empty() || !ws2812_decode(WS2812_ENCODING_8BIT, frames.back().data(), frames.back().size(), rgb))
+        return {0, 0, 0};
+    const uint8_t* c = rgb + (LED_COUNT - 1) * 3;   //the center is the last LED on the chain
+    return {c[0], c[1], c[2]};
+}
+
+// an overlay is another state's layer stack drawn over the current one
+static void test_overlay(){
+    CaptureOutput capture;
+    LEDController ctrl(std::make_unique<Forward>(capture));
+    auto is_wifi = [](led_color_t c){ return c.r == 40 && c.g == 120 && c.b == 255; };
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(!is_wifi(last_center(capture)), "dormant center already WiFi blue");
+    ctrl.SetOverlay(LEDState::CONNECTING, true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    led_color_t c = last_center(capture);
+    CHECK(is_wifi(c), "overlay center is %u,%u,%u", c.r, c.g, c.b);
+    CHECK(ctrl.State() == LEDState::DORMANT, "overlay changed the state");
+    ctrl.SetOverlay(LEDState::CONNECTING, false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(!is_wifi(last_center(capture)), "overlay still drawn after it was removed");
+}
+
+// 200 ms of ACTIVE on a held SimClock, the last frame before shutdown decoded
+static std::vector<led_color_t> held_active_frame(bool connecting){
+    CaptureOutput capture;
+    {
+        auto sim = std::make_unique<SimClock>();
+        SimClock* clock = sim.get();
+        clock->HoldAt(0);
+        LEDController ctrl(std::make_unique<Forward>(capture), WS2812_ENCODING_8BIT, std::move(sim));
+        for(int ring = 0; ring < OrbFixture::RINGS; ++ring) ctrl.SetRingGain(ring, 1.f);
+        CHECK(clock->WaitHeld(std::chrono::seconds(10)), "render thread never started");
+        ctrl.SetState(LEDState::ACTIVE);
+        if(connecting) ctrl.SetOverlay(LEDState::CONNECTING, true);
+        clock->HoldAt(200000000LL);
+        CHECK(clock->WaitHeld(std::chrono::seconds(10)), "render thread never reached 200 ms");
+    }
+    auto frames = capture.Captured();
+    std::vector<led_color_t> leds(LED_COUNT);
+    if(frames.size() < 2 || !ws2812_decode(WS2812_ENCODING_8BIT, frames[frames.size() - 2].data(),
+                                           frames[frames.size() - 2].size(), reinterpret_cast<uint8_t*>(leds.data())))
+        CHECK(false, "no ACTIVE frame captured");
+    return leds;
+}
+
+// the orbs (splat tables) and the WiFi symbol (LEDMatrix) share one canvas,
+// so both have to put a ring on the same frame indices
+static void test_overlay_layout(){
+    std::vector<led_color_t> plain = held_active_frame(false), wifi = held_active_frame(true);
+    auto level = [](led_color_t c){ return c.r + c.g + c.b; };
+    auto ring_max = [&](const std::vector<led_color_t>& f, int ring){
+        int m = 0;
+        for(int i = 0; i < ring_sizes[ring]; ++i) m = std::max(m, level(f[ring_offset(ring) + i]));
+        return m;
+    };
+    // the orbs circle on ring 3: it holds the brightest LED, rings 0 and 1 are
+    // two rings away from every orb and stay dim
+    int brightest = 0;
+    for(int i = 1; i < LED_COUNT; ++i) if(level(plain[i]) > level(plain[brightest])) brightest = i;
+    CHECK(brightest >= ring_offset(3) && brightest < ring_offset(3) + ring_sizes[3],
+          "brightest ACTIVE LED is %d, ring 3 is %d..%d", brightest, ring_offset(3), ring_offset(3) + ring_sizes[3] - 1);
+    CHECK(3 * std::max(ring_max(plain, 0), ring_max(plain, 1)) < ring_max(plain, 3),
+          "inner rings at %d/%d against ring 3 at %d", ring_max(plain, 0), ring_max(plain, 1), ring_max(plain, 3));
+
+    // with CONNECTING over it the symbol's center dot is on ring 0's index and
+    // every LED the symbol doesn't cover is the ACTIVE frame unchanged
+    auto is_wifi = [](led_color_t c){ return c.r == 40 && c.g == 120 && c.b == 255; };
+    CHECK(is_wifi(wifi[ring_offset(0)]), "overlay center dot isn't at frame index %d", ring_offset(0));
+    int covered = 0;
+    for(int i = 0; i < LED_COUNT; ++i){
+        if(is_wifi(wifi[i])){ covered++; continue; }
+        CHECK(wifi[i] == plain[i], "LED %d differs under the overlay", i);
+    }
+    CHECK(covered > 0 && covered < LED_COUNT / 2, "symbol covers %d LEDs", covered);
+}
+
+// on a SimClock the controller renders ahead of real time, and two runs
+// from the same start produce the same frames
+static void test_sim_clock(){
+    std::vector<std::vector<char>> runs[2];
+    int64_t sim_ns = 0;
+    for(auto& frames : runs){
+        CaptureOutput capture;
+        {
+            LEDController ctrl(std::make_unique<Forward>(capture), WS2812_ENCODING_8BIT, std::make_unique<SimClock>());
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            sim_ns = ctrl.Clock()->Now();
+        }
+        frames = capture.Captured();
+    }
+    CHECK(sim_ns > 1000000000LL, "200 ms of real time only rendered %.0f ms of animation", sim_ns / 1e6);
+    size_t n = std::min(runs[0].size(), runs[1].size()) - 1;    //the last is the shutdown off()
+    CHECK(n >= 50, "only %zu frames to compare", n);
+    for(size_t i = 0; i < n; ++i)
+        if(runs[0][i] != runs[1][i]){
+            CHECK(false, "simulated runs differ at frame %zu", i);
+            break;
+        }
+
+    // motion depends on time, not on how often Update() runs
+    Glow a(4), b(4);
+    frame_time_t fa, fb;
+    for(int i = 0; i < 50; ++i){
+        fa.now_ns += 10000000; fa.dt = 0.01f;
+        a.Update(fa);
+    }
+    for(int i = 0; i < 100; ++i){
+        fb.now_ns += 5000000; fb.dt = 0.005f;
+        b.Update(fb);
+    }
+    CHECK(std::fabs(a.current_size - b.current_size) < 1e-3f, "glow at 100 vs 200 fps: %f vs %f", a.current_size, b.current_size);
+}
+
+int main(){
+    test_capture();
+    test_skip_unchanged();
+    test_calibration();
+    test_output_thread();
+    test_latest_wins();
+    test_file();
+    test_fifo();
+    test_segmented();
+    test_dense_encoding();
+    test_stage_stats();
+    test_commands();
+    test_transitions();
+    test_overlay();
+    test_overlay_layout();
+    test_sim_clock();
+    if(failures){
+        printf("test_output: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_output: OK");
+    return 0;
+}
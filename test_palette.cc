@@ -0,0 +1,75 @@
+#include "palette.h"
+#include <cstdio>
+#include <cstdlib>
+
+// palette: integer HSV path against hsv2rgb(), gradient ramps and their endpoints
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+static int channel_diff(const led_color_t& a, const led_color_t& b){
+    return std::max({std::abs(a.r - b.r), std::abs(a.g - b.g), std::abs(a.b - b.b)});
+}
+
+int main(){
+    // every hue step at a spread of saturations and values
+    int worst = 0;
+    for(int h = 0; h < HUE_STEPS; ++h){
+        for(int s = 0; s <= 255; s += 15){
+            for(int v = 0; v <= 255; v += 15){
+                HSV hsv = { h * (360.f / HUE_STEPS), s / 255.f, v / 255.f };
+                worst = std::max(worst, channel_diff(hsv2rgb_int(h, s, v), hsv2rgb(hsv)));
+            }
+        }
+    }
+    CHECK(worst <= 1, "integer path off by %d from hsv2rgb", worst);
+
+    HSV in[5] = {{0.f, 1.f, 1.f}, {359.9f, 0.5f, 0.5f}, {-60.f, 1.f, 1.f}, {720.f + 120.f, 1.f, 1.f}, {200.f, 2.f, -1.f}};
+    led_color_t out[5];
+    hsv2rgb_batch(in, 5, out);
+    CHECK(out[0] == led_color_t({255, 0, 0}), "red: %u %u %u", out[0].r, out[0].g, out[0].b);
+    CHECK(out[2] == led_color_t({255, 0, 255}), "-60 should wrap to magenta: %u %u %u", out[2].r, out[2].g, out[2].b);
+    CHECK(out[3] == led_color_t({0, 255, 0}), "840 should wrap to green: %u %u %u", out[3].r, out[3].g, out[3].b);
+    CHECK(out[4] == led_color_t({0, 0, 0}), "v clamps to 0: %u %u %u", out[4].r, out[4].g, out[4].b);
+    for(int i = 0; i < 5; ++i)
+        CHECK(out[i] == hsv2rgb_fast(in[i]), "batch entry %d differs from hsv2rgb_fast", i);
+
+    // a two stop ramp hits both ends and follows hsv_lerp in between
+    HSV from = {340.f, 0.9f, 1.f}, to = {20.f, 0.5f, 0.6f};
+    for(size_t size : {256, 1024}){
+        Gradient ramp(from, to, size);
+        CHECK(ramp.Size() == size, "ramp size %zu", ramp.Size());
+        CHECK(ramp.Sample(0.f) == hsv2rgb(from) && ramp.Sample(1.f) == hsv2rgb(to), "ramp endpoints differ from the stops");
+        CHECK(ramp.Sample(-3.f) == ramp[0] && ramp.Sample(7.f) == ramp[size - 1], "Sample should clamp t");
+        int ramp_worst = 0;
+        for(int i = 0; i <= 100; ++i){
+            float t = i / 100.f;
+            ramp_worst = std::max(ramp_worst, channel_diff(ramp.Sample(t), hsv2rgb(hsv_lerp(from, to, t))));
+        }
+        CHECK(ramp_worst <= (size == 256 ? 2 : 1), "%zu entry ramp off by %d", size, ramp_worst);
+    }
+    // crossing 0 degrees takes the short way: the midpoint is red, not cyan
+    HSV mid = hsv_lerp(from, to, 0.5f);
+    CHECK(mid.h < 1.f || mid.h > 359.f, "hue midpoint %f", mid.h);
+
+    // multi stop ramp: flat outside the stops, through each stop (to the nearest entry)
+    Gradient multi({{0.25f, {0.f, 1.f, 1.f}}, {0.5f, {120.f, 1.f, 1.f}}, {0.75f, {240.f, 1.f, 1.f}}}, 1024);
+    CHECK(multi.Sample(0.f) == led_color_t({255, 0, 0}) && multi.Sample(0.25f) == led_color_t({255, 0, 0}), "first stop");
+    CHECK(channel_diff(multi.Sample(0.5f), {0, 255, 0}) <= 1, "middle stop");
+    CHECK(multi.Sample(0.9f) == led_color_t({0, 0, 255}), "last stop");
+
+    // no stops: black, and a ramp reassigned with none goes black too
+    Gradient empty({}, 16);
+    bool dark = empty.Size() == 16;
+    for(size_t i = 0; i < empty.Size(); ++i) dark &= empty[i] == led_color_t({0, 0, 0});
+    CHECK(dark, "empty stop list isn't black");
+    multi.Assign({});
+    CHECK(multi.Sample(0.5f) == led_color_t({0, 0, 0}) && multi.Sample(1.f) == led_color_t({0, 0, 0}), "reassigned to no stops");
+
+    if(failures){
+        printf("test_palette: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_palette: OK");
+    return 0;
+}
@@ -1,5 +1,3 @@
-#ifdef __aarch64__
-
 #include "ledcontrol.h"
 #include <iostream>
 #include <thread>
@@ -47,11 +45,3 @@ int main(){
     std::cout << "Test finished, exiting.\n";
     return 0;
 }
-
-#else
-#include <iostream>
-int main(){
-    std::cout << "LED control only available on aarch64 platform.\n";
-    return 0;
-}
-#endif 
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "ledcontrol.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// PolarIndex: the quantised lookup against LEDMatrix::polar_to_ring, the ring views'
+// frame layout, and the batch set_leds() writes against the per point set_led(polar_t) path
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+// set_led(polar_t) normalises in float, skip points within rounding noise of a boundary
+static bool near_boundary(polar_t p){
+    p.normalize();
+    if(std::fabs(p.r - 0.5f) < 1e-4f || std::fabs(p.r - std::floor(p.r) - 0.5f) < 1e-4f) return true;
+    int ring = std::min(4, static_cast<int>(std::round(p.r)));
+    float x = p.theta / (2.f * M_PI_F) * ring_sizes[ring];
+    return std::fabs(x - std::floor(x) - 0.5f) < 1e-3f || p.theta > 2.f * M_PI_F - 1e-4f;
+}
+
+static std::vector<led_color_t> snapshot(LEDMatrix& matrix){
+    LEDArray leds;
+    matrix.Update(leds);
+    return std::vector<led_color_t>(leds.begin(), leds.end());
+}
+
+int main(){
+    const PolarIndex& index = polar_index();
+    CHECK(&index == &polar_index(), "index built twice");
+
+    LEDMatrix matrix;
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> angle(-6.f * M_PI_F, 6.f * M_PI_F);
+    std::uniform_real_distribution<float> radius(-5.f, 5.f);
+
+    // every LED centre maps to itself
+    for(int ring = 0; ring < 5; ++ring)
+        for(int i = 0; i < ring_sizes[ring]; ++i){
+            polar_t p{ ring == 0 ? 0.f : DEG2RAD((360.0f / ring_sizes[ring]) * i), static_cast<float>(ring) };
+            polar_index_t at = index(p);
+            CHECK(at.ring == ring && at.led == i, "centre of ring %d led %d maps to %d/%d", ring, i, at.ring, at.led);
+        }
+
+    // ring views sit at their physical offsets: outer ring first, center last
+    CHECK(ring_offset(4) == 0 && ring_offset(3) == 24 && ring_offset(0) == LED_COUNT - 1, "ring offsets");
+    for(int ring = 0; ring < 5; ++ring){
+        LEDMatrix m;
+        m.set_led(polar_t{ ring == 0 ? 0.f : DEG2RAD(360.0f / ring_sizes[ring]), static_cast<float>(ring) }, {1, 2, 3});
+        int lit = ring_offset(ring) + (ring == 0 ? 0 : 1);
+        for(int i = 0; i < LED_COUNT; ++i)
+            CHECK((m.Frame()[i] == led_color_t{1, 2, 3}) == (i == lit), "ring %d: frame LED %d", ring, i);
+        CHECK(m.Ring(ring).Data() == m.Frame().data() + ring_offset(ring), "ring %d view offset", ring);
+    }
+
+    int compared = 0;
+    for(int n = 0; n < 500000; ++n){
+        polar_t p{ angle(gen), radius(gen) };
+        if(near_boundary(p)) continue;
+        polar_t q = p;
+        auto [ring, led] = matrix.polar_to_ring(q.normalize());
+        polar_index_t at = index(p);
+        CHECK(at.ring == ring && at.led == led, "(%f, %f) -> %d/%d, polar_to_ring says %d/%d",
+              p.theta, p.r, at.ring, at.led, ring, led);
+        CHECK(index.Frame(p) == ring_offset(ring) + led, "(%f, %f) frame index %d", p.theta, p.r, index.Frame(p));
+        if(failures > 10) return 1;
+        compared++;
+    }
+
+    // a sprite drawn through set_leds() lands exactly where set_led() puts it
+    std::uniform_int_distribution<int> channel(0, 90);
+    std::vector<animLED> sprite;
+    for(int i = 0; i < 40; ++i){
+        led_color_t c = i % 9 == 0 ? led_color_t{0, 0, 0}
+                                   : led_color_t{ static_cast<uint8_t>(channel(gen)), static_cast<uint8_t>(channel(gen)), static_cast<uint8_t>(channel(gen)) };
+        sprite.push_back({ { angle(gen) * 0.1f, radius(gen) * 0.4f }, c });
+    }
+    int drawn = 0;
+    for(int frame = 0; frame < 2000; ++frame){
+        polar_t origin{ angle(gen), std::fabs(radius(gen)) * 0.8f };
+        bool skip = false;
+        for(auto& led : sprite) skip |= near_boundary(origin + led.origin);
+        if(skip) continue;
+
+        LEDMatrix reference, batch;
+        reference.set_all({5, 5, 5});
+        batch.set_all({5, 5, 5});
+        for(auto& led : sprite) reference.set_led(origin + led.origin, led.color);
+        batch.set_leds(origin, sprite.data(), sprite.size());
+        CHECK(snapshot(reference) == snapshot(batch), "sprite at (%f, %f) differs", origin.theta, origin.r);
+
+        std::vector<polar_t> points;
+        std::vector<led_color_t> colors;
+        for(auto& led : sprite){ points.push_back(origin + led.origin); colors.push_back(led.color); }
+        LEDMatrix flat;
+        flat.set_all({5, 5, 5});
+        flat.set_leds(points.data(), colors.data(), points.size());
+        CHECK(snapshot(reference) == snapshot(flat), "point list at (%f, %f) differs", origin.theta, origin.r);
+        if(failures > 10) return 1;
+        drawn++;
+    }
+
+    printf("test_polar_index: %d points, %d sprites compared\n", compared, drawn);
+    if(failures) return 1;
+    printf("test_polar_index: OK\n");
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "ledcontrol.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// the clipped polar rasterizer: every shape against a brute force walk over
+// all LEDs, each covered LED written exactly once, aa coverage adding up to
+// the shape's size, and anything off the fixture drawing nothing
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+using SmallFixture = RingLayout<1, 6, 12, 24>;
+
+static_assert(noexcept(std::declval<LEDMatrix&>().draw_arc(1, 0.f, 90.f, led_color_t{}, true)));
+static_assert(noexcept(std::declval<LEDMatrix&>().draw_wedge(0.f, 90.f, 0, 4, led_color_t{})));
+static_assert(noexcept(std::declval<LEDMatrix&>().draw_line(0.f, 0, 4, led_color_t{})));
+
+// degrees from start to angle going counter-clockwise, in [0, 360)
+static float ccw(float start, float angle){
+    float d = std::fmod(angle - start, 360.f);
+    return d < 0.f ? d + 360.f : d;
+}
+
+// does the arc take LED i of ring? skips LEDs within rounding noise of an end
+template <class Layout>
+static int in_arc(int ring, int i, float start, float span){
+    if(Layout::sizes[ring] == 1) return 1;
+    float d = ccw(start, i * Layout::incs[ring]);
+    if(std::fabs(d - span) < 0.01f || d > 359.99f || d < 0.01f) return -1;
+    return d <= span ? 1 : 0;
+}
+
+template <class Layout>
+static void check_arcs(const char* name){
+    using Matrix = BasicLEDMatrix<Layout>;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> angle(-720.f, 720.f);
+    std::uniform_real_distribution<float> span(0.f, 359.f);
+    int compared = 0;
+    for(int n = 0; n < 20000 && failures < 10; ++n){
+        float start = angle(gen), sp = span(gen);
+        int ring = static_cast<int>(gen() % Layout::RINGS);
+        bool reverse = gen() & 1;     //the same arc drawn from its other end
+        Matrix m;
+        int written = reverse ? m.draw_arc(ring, start + sp, -sp, {1, 0, 0})
+                              : m.draw_arc(ring, start, sp, {1, 0, 0});
+        int expected = 0;
+        bool ambiguous = false;
+        for(int i = 0; i < Layout::sizes[ring]; ++i){
+            int in = in_arc<Layout>(ring, i, start, sp);
+            ambiguous |= in < 0;
+            if(in < 0) continue;
+            expected += in;
+            uint8_t v = m.Ring(ring)[i].r;
+            CHECK(v == in, "%s ring %d LED %d: arc %f + %f wrote it %d times", name, ring, i, start, sp, v);
+        }
+        if(!ambiguous) CHECK(written == expected, "%s arc %f + %f wrote %d, expected %d", name, start, sp, written, expected);
+        int lit = 0;
+        for(auto& c : m.Frame()) lit += c.r;
+        CHECK(lit == written, "%s arc %f + %f lit %d LEDs, reported %d", name, start, sp, lit, written);
+        compared++;
+    }
+
+    // with aa the coverage adds up to the span, whichever LEDs it straddles
+    for(int n = 0; n < 5000 && failures < 10; ++n){
+        float start = angle(gen), sp = span(gen);
+        int ring = 1 + static_cast<int>(gen() % (Layout::RINGS - 1));
+        Matrix m;
+        int written = m.draw_arc(ring, start, sp, {200, 0, 0}, true);
+        int sum = 0, lit = 0;
+        for(int i = 0; i < Layout::sizes[ring]; ++i){
+            sum += m.Ring(ring)[i].r;
+            lit += m.Ring(ring)[i].r > 0;
+        }
+        float expected = 200.f * sp / Layout::incs[ring];
+        //each LED truncates, and one straddled on both ends may clamp at 200
+        CHECK(sum <= expected + 0.5f && sum >= expected - written - 1, "%s aa arc %f + %f sums to %d, expected %.1f",
+              name, start, sp, sum, expected);
+        CHECK(lit == written, "%s aa arc lit %d, reported %d", name, lit, written);
+    }
+    printf("%s: %d arcs compared\n", name, compared);
+}
+
+static void test_shapes(){
+    LEDMatrix m;
+    // full rings and spans of 360 or more take every LED once
+    CHECK(m.draw_ring(4, {1, 0, 0}) == 24, "ring 4 is 24 LEDs");
+    CHECK(m.draw_arc(3, 10.f, 400.f, {1, 0, 0}) == 16, "an arc past 360 degrees is the ring");
+    for(int i = 0; i < 24; ++i) CHECK(m.Ring(4)[i].r == 1, "ring 4 LED %d written %d times", i, m.Ring(4)[i].r);
+
+    // the WiFi arcs: 90 degrees around 270 on ring 2 is LEDs 8..10, centered on 9
+    LEDMatrix wifi;
+    CHECK(wifi.draw_arc(2, 225.f, 90.f, {1, 1, 1}) == 3, "ring 2 arc");
+    for(int i = 0; i < 12; ++i)
+        CHECK(wifi.Ring(2)[i].r == (i >= 8 && i <= 10), "ring 2 LED %d", i);
+    CHECK(wifi.draw_arc(4, 195.f, 150.f, {1, 1, 1}) == 11, "ring 4 arc is 11 LEDs");
+
+    // a wedge is its arcs plus the center when it starts there
+    LEDMatrix wedge;
+    CHECK(wedge.draw_wedge(0.f, 90.f, 0, 4, {1, 0, 0}) == 1 + 3 + 4 + 5 + 7, "wedge LED count");
+    CHECK(wedge.Ring(0)[0].r == 1, "wedge from ring 0 takes the center");
+    LEDMatrix ring_wedge;
+    CHECK(ring_wedge.draw_wedge(0.f, 90.f, 2, 3, {1, 0, 0}) == 4 + 5 && !ring_wedge.Ring(0)[0], "wedge over rings 2..3");
+
+    // a line is one LED per ring, where set_led(polar_t) puts each of them
+    LEDMatrix line, ref;
+    CHECK(line.draw_line(100.f, 0, 4, {5, 6, 7}) == 5, "line is one LED per ring");
+    for(int ring = 0; ring < 5; ++ring) ref.set_led(polar_t::Degrees(100.f, ring), {5, 6, 7});
+    CHECK(line.Frame() == ref.Frame(), "line differs from set_led per ring");
+    LEDMatrix aa_line;
+    CHECK(aa_line.draw_line(100.f, 1, 4, {200, 200, 200}, true) == 8, "aa line straddles two LEDs per ring");
+
+    // an aa point is split by distance, nothing for the far LED when it's on a center
+    LEDMatrix pt;
+    CHECK(pt.draw_point(45.f * 0.25f, 1, {200, 0, 0}, true) == 2, "aa point between two LEDs");
+    CHECK(pt.Ring(1)[0].r == 150 && pt.Ring(1)[1].r == 50, "aa point split %d/%d", pt.Ring(1)[0].r, pt.Ring(1)[1].r);
+    LEDMatrix on;
+    CHECK(on.draw_point(90.f, 1, {200, 0, 0}, true) == 1 && on.Ring(1)[2].r == 200, "aa point on a center");
+
+    // black clears whole LEDs, with or without aa
+    LEDMatrix clear;
+    clear.draw_ring(2, {50, 50, 50});
+    CHECK(clear.draw_arc(2, 0.f, 60.f, {0, 0, 0}, true) == 3, "black arc");
+    CHECK(!clear.Ring(2)[0] && !clear.Ring(2)[2] && clear.Ring(2)[3].r == 50, "black arc clears LEDs 0..2");
+
+    // off the fixture: nothing drawn, nothing thrown
+    LEDMatrix off;
+    CHECK(off.draw_arc(5, 0.f, 90.f, {1, 1, 1}) == 0 && off.draw_arc(-1, 0.f, 90.f, {1, 1, 1}) == 0, "arc off the rings");
+    CHECK(off.draw_point(NAN, 2, {1, 1, 1}) == 0 && off.draw_arc(2, 0.f, INFINITY, {1, 1, 1}) == 0, "non finite angles");
+    CHECK(off.draw_point(polar_t{0.f, 4.6f}, {1, 1, 1}) == 0 && off.draw_ring(7, {1, 1, 1}) == 0, "point past the outer ring");
+    CHECK(off.draw_line(0.f, 3, 9, {1, 1, 1}) == 2 && off.draw_wedge(0.f, 90.f, -3, 0, {1, 1, 1}) == 1, "clipped ring ranges");
+    int lit = 0;
+    for(auto& c : off.Frame()) lit += c.r;
+    CHECK(lit == 3, "clipped shapes lit %d LEDs", lit);
+}
+
+int main(){
+    check_arcs<OrbFixture>("orb");
+    check_arcs<SmallFixture>("small");
+    test_shapes();
+    if(failures){
+        printf("test_raster: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_raster: OK");
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "render_buffer.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+// RenderBuffer: bulk blend ops stay in float, Resolve() clamps and rounds once
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+struct rgb_t { uint8_t r, g, b; };
+
+int main(){
+    const size_t N = 7;
+    RenderBuffer<N> buf;
+    float w[N] = {0.f, 0.1f, 0.25f, 0.5f, 0.75f, 1.f, 2.f};
+    rgb_t out[N];
+
+    // three orbs stacking past 255 keep their full sum until the end
+    buf.Clear();
+    for(int o = 0; o < 3; ++o) buf.AddSplat(w, rgb_t{200, 100, 10}, 0.7f);
+    for(size_t i = 0; i < N; ++i){
+        float expect = 3 * 200 * 0.7f * w[i];
+        CHECK(std::fabs(buf.R(i) - expect) < 1e-3f, "acc r[%zu] %f, expected %f", i, buf.R(i), expect);
+    }
+    buf.Resolve(out);
+    CHECK(out[0].r == 0 && out[6].r == 255, "resolve clamp: %u %u", out[0].r, out[6].r);
+    CHECK(out[1].r == 42 && out[1].g == 21 && out[1].b == 2, "resolve rounding: %u %u %u", out[1].r, out[1].g, out[1].b);
+
+    // scaling an over-range value back into range recovers it
+    buf.Scale(0.25f);
+    buf.Resolve(out);
+    CHECK(out[5].r == 105, "scaled r %u, expected 105", out[5].r);
+
+    // MixSplat: background lerps towards the splat color by min(1, mix * w)
+    buf.Fill(rgb_t{128, 128, 128});
+    buf.MixSplat(w, rgb_t{0, 255, 40}, 1.2f, 2.f);
+    for(size_t i = 0; i < N; ++i){
+        float t = std::fmin(1.f, 2.f * w[i]);
+        float expect_g = 128 + t * (255 * 1.2f * w[i] - 128);
+        CHECK(std::fabs(buf.G(i) - expect_g) < 1e-3f, "mix g[%zu] %f, expected %f", i, buf.G(i), expect_g);
+    }
+    buf.Resolve(out);
+    CHECK(out[0].r == 128 && out[0].g == 128, "w=0 should keep the background");
+    CHECK(out[5].r == 0 && out[5].g == 255 && out[5].b == 48, "w=1 should be the orb: %u %u %u", out[5].r, out[5].g, out[5].b);
+
+    if(failures){
+        printf("test_render_buffer: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_render_buffer: OK");
+    return 0;
+}
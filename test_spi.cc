@@ -0,0 +1,106 @@
+#include "spi.h"
+#include "ws2812.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+// spi_t::transfer() against a mock device: chunk and message boundaries for frames
+// below, at and far above the spidev message limit
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+struct mock_device {
+    std::vector<std::vector<spi_ioc_transfer>> messages;
+    int fail_at = -1;  //message index that returns an error
+};
+
+static int mock_submit(void* ctx, int, spi_ioc_transfer* tr, unsigned count){
+    auto* dev = static_cast<mock_device*>(ctx);
+    if(static_cast<int>(dev->messages.size()) == dev->fail_at) return -1;
+    dev->messages.emplace_back(tr, tr + count);
+    int bytes = 0;
+    for(unsigned i = 0; i < count; ++i) bytes += tr[i].len;
+    return bytes;
+}
+
+// every byte of the frame goes out once, in order, in chunks of at most chunk_bytes,
+// each message within message_bytes, and only the frame's last transfer changes CS
+static void check_frame(const char* name, size_t leds, uint32_t message_bytes, size_t expect_messages){
+    mock_device dev;
+    spi_t spi(WS2812B_SPI_SPEED, mock_submit, &dev, message_bytes);
+    std::vector<char> frame(leds * WS2812B_BYTES_PER_LED, (char)WS2812B_LOW);
+    CHECK(spi.transfer(frame.data(), frame.size()), "%s: transfer failed", name);
+    CHECK(dev.messages.size() == expect_messages, "%s: %zu messages, expected %zu", name, dev.messages.size(), expect_messages);
+    CHECK(spi.split_frames == (expect_messages > 1 ? 1u : 0u), "%s: split_frames %llu", name, (unsigned long long)spi.split_frames);
+
+    uintptr_t next = (uintptr_t)frame.data();
+    size_t transfers = 0;
+    for(size_t m = 0; m < dev.messages.size(); ++m){
+        const auto& msg = dev.messages[m];
+        CHECK(!msg.empty() && msg.size() <= SPI_MAX_TRANSFERS, "%s: message %zu has %zu transfers", name, m, msg.size());
+        uint32_t bytes = 0;
+        for(size_t t = 0; t < msg.size(); ++t, ++transfers){
+            const spi_ioc_transfer& tr = msg[t];
+            bool last = m + 1 == dev.messages.size() && t + 1 == msg.size();
+            CHECK(tr.tx_buf == next, "%s: message %zu transfer %zu starts at +%zu, expected +%zu", name, m, t,
+                  (size_t)(tr.tx_buf - (uintptr_t)frame.data()), (size_t)(next - (uintptr_t)frame.data()));
+            CHECK(tr.len > 0 && tr.len <= SPI_CHUNK_SIZE, "%s: transfer of %u bytes", name, tr.len);
+            CHECK(last || tr.len == std::min<uint32_t>(SPI_CHUNK_SIZE, message_bytes), "%s: short transfer before the end", name);
+            CHECK(tr.delay_usecs == 0 && tr.word_delay_usecs == 0, "%s: delay between transfers", name);
+            CHECK(tr.cs_change == (last ? SPI_CS_CHANGE : 0), "%s: cs_change %u on transfer %zu", name, tr.cs_change, transfers);
+            CHECK(tr.speed_hz == WS2812B_SPI_SPEED && tr.rx_buf == 0, "%s: transfer settings", name);
+            next += tr.len;
+            bytes += tr.len;
+        }
+        CHECK(bytes <= message_bytes, "%s: message %zu carries %u bytes over the %u limit", name, m, bytes, message_bytes);
+    }
+    CHECK(next == (uintptr_t)(frame.data() + frame.size()), "%s: frame not covered", name);
+    printf("%-28s %6zu LEDs %8zu bytes: %zu messages, %zu transfers\n", name, leds, frame.size(), dev.messages.size(), transfers);
+}
+
+int main(){
+    check_frame("orb, one chunk", 61, SPI_BUFFER_SIZE, 1);
+    check_frame("just under one chunk", 170, SPI_BUFFER_SIZE, 1);
+    check_frame("chunk splits an LED", 171, SPI_BUFFER_SIZE, 1);
+    check_frame("bufsiz 20480, 850 LEDs", 850, 20480, 1);
+    check_frame("bufsiz 20480, 1000 LEDs", 1000, 20480, 2);
+    check_frame("default bufsiz 4096", 1000, 4096, 6);
+    check_frame("bufsiz 1M, 10000 LEDs", 10000, 1 << 20, 1);
+    check_frame("transfer cap, 20000 LEDs", 20000, 1 << 20, 2);
+    check_frame("bufsiz smaller than a chunk", 200, 1000, 5);
+
+    // a failing message stops the frame there
+    mock_device dev;
+    dev.fail_at = 1;
+    spi_t spi(WS2812B_SPI_SPEED, mock_submit, &dev, 4096);
+    std::vector<char> frame(1000 * WS2812B_BYTES_PER_LED);
+    CHECK(!spi.transfer(frame.data(), frame.size()), "transfer should report the failed message");
+    CHECK(dev.messages.size() == 1, "kept submitting after a failure");
+
+    // a zero chunk or message size still moves at least a byte per transfer
+    // and message; the mock fails past 10000 messages instead of spinning
+    {
+        mock_device zero;
+        zero.fail_at = 10000;
+        spi_t bus(WS2812B_SPI_SPEED, mock_submit, &zero, 0);
+        std::vector<char> two(2 * WS2812B_BYTES_PER_LED);
+        CHECK(bus.message_bytes == 1, "message_bytes 0 kept as %u", bus.message_bytes);
+        CHECK(bus.transfer(two.data(), two.size()) && zero.messages.size() == two.size(),
+              "message_bytes 0: %zu messages for %zu bytes", zero.messages.size(), two.size());
+
+        mock_device chunkless;
+        chunkless.fail_at = 10000;
+        spi_t spi0(WS2812B_SPI_SPEED, mock_submit, &chunkless, 4096);
+        spi0.chunk_bytes = 0;
+        CHECK(spi0.transfer(two.data(), two.size()) && chunkless.messages.size() == 1 &&
+              chunkless.messages[0].size() == two.size(), "chunk_bytes 0: %zu messages", chunkless.messages.size());
+        spi0.message_bytes = 0;
+        CHECK(spi0.transfer(two.data(), two.size()) && chunkless.messages.size() == 1 + two.size(),
+              "message_bytes set to 0: %zu messages", chunkless.messages.size());
+    }
+
+    if(failures) return 1;
+    printf("test_spi: OK\n");
+    return 0;
+}
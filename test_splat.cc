@@ -0,0 +1,58 @@
+#include "ledcontrol.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// SplatTable: table weights against the exact exp() falloff for the fixture layout
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+int main(){
+    // weights come in frame order, outer ring first
+    std::array<polar_t, LED_COUNT> lut;
+    for(int ring = 0; ring < 5; ++ring)
+        for(int i = 0; i < ring_sizes[ring]; ++i)
+            lut[ring_offset(ring) + i] = polar_t{ ring == 0 ? 0.f : DEG2RAD((360.0f / ring_sizes[ring]) * i), static_cast<float>(ring) };
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> angle(-4.f * M_PI_F, 4.f * M_PI_F);
+    std::uniform_real_distribution<float> radius(0.f, 4.f);
+    std::array<float, LED_COUNT> F;
+
+    for(float sigma : {0.6f, 1.0f, 3.5f}){
+        const SplatTable& table = orb_splat(sigma);
+        CHECK(&table == &orb_splat(sigma), "sigma %.1f table built twice", sigma);
+        CHECK(table.Count() == LED_COUNT, "table covers %zu LEDs", table.Count());
+
+        float worst = 0.f;
+        auto compare = [&](float theta, float r){
+            table.Weights(theta, r, F.data());
+            for(int i = 0; i < LED_COUNT; ++i){
+                float exact = SplatTable::Exact(sigma, lut[i].theta, lut[i].r, theta, r);
+                worst = std::max(worst, std::fabs(F[i] - exact));
+            }
+        };
+        // a sweep across quanta and radius rows, then random positions off the grid
+        for(float r = 0.f; r <= 4.f; r += 0.0625f)
+            for(int a = 0; a < 720; ++a) compare(DEG2RAD(a * 0.5f), r);
+        for(int n = 0; n < 200000; ++n) compare(angle(gen), radius(gen));
+
+        CHECK(worst <= SplatTable::MAX_ERROR, "sigma %.1f max error %g above bound %g", sigma, worst, SplatTable::MAX_ERROR);
+        printf("sigma %.1f: max error %.6f (%.3f/255)\n", sigma, worst, worst * 255.f);
+    }
+
+    // an orb sitting on an LED lights it fully, radius beyond the rim clamps
+    orb_splat(1.0f).Weights(0.f, 4.f, F.data());
+    CHECK(F[ring_offset(4)] > 0.999f, "LED under the orb got %f", F[ring_offset(4)]);
+    std::array<float, LED_COUNT> clamped;
+    orb_splat(1.0f).Weights(0.f, 9.f, clamped.data());
+    CHECK(clamped == F, "radius 9 should clamp to the outer ring");
+
+    if(failures){
+        printf("test_splat: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_splat: OK");
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "timeline.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Timeline: the easing tables against the curves they sample, keyframe
+// interpolation, holds, jumps, loops, rewinds, and a batch of tracks
+// against each track evaluated on its own
+
+static int failures = 0;
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL: " __VA_ARGS__); puts(""); failures++; } } while(0)
+
+static bool near(float got, float want, float eps = 1e-4f){ return std::fabs(got - want) < eps; }
+
+static void test_ease_tables(){
+    const char* names[] = {"linear", "in_out", "in", "out", "smooth"};
+    for(int e = 0; e < static_cast<int>(Ease::HOLD); ++e){
+        float worst = 0.f;
+        for(int i = 0; i <= 10000; ++i){
+            float t = i / 10000.f;
+            worst = std::max(worst, std::fabs(ease(static_cast<Ease>(e), t) - timeline_detail::ease_exact(static_cast<Ease>(e), t)));
+        }
+        CHECK(worst < 2e-5f, "%s table off by %g", names[e], worst);
+        CHECK(ease(static_cast<Ease>(e), 0.f) == 0.f && ease(static_cast<Ease>(e), 1.f) == 1.f, "%s ends", names[e]);
+        CHECK(ease(static_cast<Ease>(e), -1.f) == 0.f && ease(static_cast<Ease>(e), 2.f) == 1.f, "%s clamps t", names[e]);
+        printf("%-7s max error %.2g\n", names[e], worst);
+    }
+    CHECK(ease(Ease::HOLD, 0.99f) == 0.f, "hold moves before the next key");
+    CHECK(near(ease(Ease::IN_OUT, 0.3f), 0.5f * (1.f - std::cos(static_cast<float>(M_PI) * 0.3f))), "in_out is easeInOut");
+}
+
+static void test_keys(){
+    Timeline<4, 32> tl;
+    int a = tl.Track({{1.f, 10.f}, {3.f, 30.f, Ease::HOLD}, {4.f, 0.f}, {4.f, 100.f, Ease::IN}, {5.f, 200.f}});
+    CHECK(a == 0 && tl.Keys() == 5 && tl.Duration() == 5.f, "track layout");
+
+    struct { float t, want; } cases[] = {
+        {0.f, 10.f},    //before the first key
+        {1.f, 10.f},
+        {2.f, 20.f},    //linear halfway
+        {3.f, 30.f},
+        {3.9f, 30.f},   //held
+        {4.f, 100.f},   //two keys at one time jump to the later
+        {4.5f, 125.f},  //quadratic in, a quarter of the way
+        {5.f, 200.f},
+        {9.f, 200.f},   //after the last key
+    };
+    for(auto& c : cases){
+        tl.Evaluate(c.t);
+        CHECK(near(tl[a], c.want, 1e-3f), "t %.1f: %f, expected %f", c.t, tl[a], c.want);
+    }
+    CHECK(tl.Done(5.f) && !tl.Done(4.9f), "done after the last key");
+
+    // rewinding gives the same values as playing forwards
+    tl.Evaluate(2.f);
+    CHECK(near(tl[a], 20.f), "rewound to 2s: %f", tl[a]);
+
+    // a looped timeline wraps t by its duration, both ways
+    Timeline<1, 4> loop;
+    loop.Track({{0.f, 0.f}, {2.f, 1.f}});
+    loop.SetLoop(true);
+    loop.Evaluate(5.f);
+    CHECK(near(loop[0], 0.5f), "looped 5s: %f", loop[0]);
+    loop.Evaluate(-0.5f);
+    CHECK(near(loop[0], 0.75f), "looped -0.5s: %f", loop[0]);
+    CHECK(!loop.Done(100.f), "a loop is never done");
+
+    // tracks that are empty, out of order or past capacity are refused
+    Timeline<2, 4> small;
+    CHECK(small.Track({}) == -1, "empty track accepted");
+    CHECK(small.Track({{1.f, 0.f}, {0.f, 1.f}}) == -1, "out of order track accepted");
+    CHECK(small.Track({{0.f, 0.f}, {1.f, 1.f}, {2.f, 0.f}}) == 0, "track refused");
+    CHECK(small.Track({{0.f, 0.f}, {1.f, 1.f}}) == -1, "track past the key capacity accepted");
+    CHECK(small.Track({{0.f, 5.f}}) == 1 && small.Track({{0.f, 5.f}}) == -1, "track capacity");
+    small.Evaluate(3.f);
+    CHECK(small[1] == 5.f, "one key track");
+}
+
+// one timeline of many tracks, evaluated at random times forwards and back,
+// matches a timeline per track
+static void test_batch(){
+    constexpr int TRACKS = 16;
+    Timeline<TRACKS, TRACKS * 8> batch;
+    Timeline<1, 8> single[TRACKS];
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> step(0.f, 1.f), val(-10.f, 10.f);
+    for(int k = 0; k < TRACKS; ++k){
+        keyframe_t keys[8];
+        float t = step(gen);
+        for(auto& key : keys){
+            key = {t, val(gen), static_cast<Ease>(gen() % static_cast<int>(Ease::COUNT))};
+            t += step(gen);
+        }
+        CHECK(batch.Track(keys, 8) == k && single[k].Track(keys, 8) == 0, "track %d refused", k);
+    }
+    std::uniform_real_distribution<float> when(-1.f, batch.Duration() + 1.f);
+    for(int n = 0; n < 2000 && failures < 10; ++n){
+        float t = n < 1000 ? n * (batch.Duration() + 1.f) / 1000.f : when(gen);
+        batch.Evaluate(t);
+        for(int k = 0; k < TRACKS; ++k){
+            single[k].Evaluate(t);
+            CHECK(batch[k] == single[k][0], "t %f track %d: %f vs %f", t, k, batch[k], single[k][0]);
+        }
+    }
+}
+
+int main(){
+    test_ease_tables();
+    test_keys();
+    test_batch();
+    if(failures){
+        printf("test_timeline: %d failures\n", failures);
+        return 1;
+    }
+    puts("test_timeline: OK");
+    return 0;
+}
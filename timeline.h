@@ -0,0 +1,151 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+/*
+keyframed animation as data.
+
+a Timeline holds tracks of keyframes, each track one float parameter (an
+angle, a radius, a palette position, an intensity; a position is two tracks).
+a keyframe's ease shapes the way from it to the next key. Evaluate(t) runs
+every track at once over flat key arrays and leaves the values in Values().
+
+easing curves are sampled from precomputed tables (EASE_STEPS segments,
+linearly interpolated), so no cosf or pow per frame. each track keeps a
+cursor on its current segment: playing forwards moves it at most a key or
+two per frame, so the cost per track stays constant however long the track
+is. going back (a loop, or a restart) drops it back to the first key.
+*/
+
+enum class Ease : uint8_t {
+    LINEAR,
+    IN_OUT,     //cosine, 0.5 * (1 - cos(pi t)), same as easeInOut()
+    IN,         //quadratic, t^2
+    OUT,        //quadratic, 1 - (1 - t)^2
+    SMOOTH,     //smoothstep, 3t^2 - 2t^3
+    HOLD,       //stays on the key until the next one
+    COUNT
+};
+
+constexpr int EASE_STEPS = 256;
+
+namespace timeline_detail {
+
+using ease_table_t = std::array<std::array<float, EASE_STEPS + 1>, static_cast<size_t>(Ease::COUNT)>;
+
+inline float ease_exact(Ease ease, float t){
+    switch(ease){
+        case Ease::LINEAR: return t;
+        case Ease::IN_OUT: return 0.5f * (1.f - std::cos(static_cast<float>(M_PI) * t));
+        case Ease::IN:     return t * t;
+        case Ease::OUT:    return 1.f - (1.f - t) * (1.f - t);
+        case Ease::SMOOTH: return t * t * (3.f - 2.f * t);
+        default:           return 0.f;
+    }
+}
+
+inline ease_table_t build_ease_tables(){
+    ease_table_t tables{};
+    for(size_t e = 0; e < tables.size(); ++e)
+        for(int i = 0; i <= EASE_STEPS; ++i)
+            tables[e][i] = ease_exact(static_cast<Ease>(e), static_cast<float>(i) / EASE_STEPS);
+    return tables;
+}
+
+inline const ease_table_t ease_tables = build_ease_tables();
+
+} // namespace timeline_detail
+
+//eased t, t in [0, 1]
+inline float ease(Ease e, float t){
+    const auto& table = timeline_detail::ease_tables[static_cast<size_t>(e)];
+    float x = std::min(std::max(t, 0.f), 1.f) * EASE_STEPS;
+    int i = std::min(static_cast<int>(x), EASE_STEPS - 1);
+    return table[i] + (table[i + 1] - table[i]) * (x - static_cast<float>(i));
+}
+
+struct keyframe_t {
+    float time;             //seconds from the start of the timeline
+    float value;
+    Ease ease = Ease::LINEAR;   //towards the next key
+};
+
+template <size_t MAX_TRACKS, size_t MAX_KEYS>
+class Timeline {
+public:
+    //adds a track, keys in time order. -1 if it is empty, out of order or doesn't fit
+    int Track(const keyframe_t* keys, size_t count){
+        if(count == 0 || tracks == MAX_TRACKS || used + count > MAX_KEYS) return -1;
+        for(size_t i = 1; i < count; ++i)
+            if(keys[i].time < keys[i - 1].time) return -1;
+        const int track = static_cast<int>(tracks++);
+        first[track] = cursor[track] = static_cast<uint16_t>(used);
+        last[track] = static_cast<uint16_t>(used + count - 1);
+        for(size_t i = 0; i < count; ++i, ++used){
+            time[used] = keys[i].time;
+            value[used] = keys[i].value;
+            eases[used] = keys[i].ease;
+            float span = i + 1 < count ? keys[i + 1].time - keys[i].time : 0.f;
+            inv_span[used] = span > 0.f ? 1.f / span : 0.f;
+        }
+        duration = std::max(duration, keys[count - 1].time);
+        values[track] = keys[0].value;
+        return track;
+    }
+    int Track(std::initializer_list<keyframe_t> keys){ return Track(keys.begin(), keys.size()); }
+
+    void Clear(){
+        tracks = used = 0;
+        duration = 0.f;
+    }
+    //looping timelines wrap t by Duration()
+    void SetLoop(bool on){ loop = on; }
+
+    //every track at t seconds, before the first key a track holds its first value, after the last its last
+    void Evaluate(float t){
+        if(loop && duration > 0.f){
+            t = std::fmod(t, duration);
+            if(t < 0.f) t += duration;
+        }
+        for(size_t k = 0; k < tracks; ++k){
+            int c = cursor[k];
+            if(t < time[c]) c = first[k];
+            while(c < last[k] && t >= time[c + 1]) ++c;
+            cursor[k] = static_cast<uint16_t>(c);
+            if(c == last[k] || t <= time[c]){
+                values[k] = value[c];
+                continue;
+            }
+            float u = (t - time[c]) * inv_span[c];
+            values[k] = value[c] + (value[c + 1] - value[c]) * ease(eases[c], u);
+        }
+    }
+
+    float operator[](int track) const { return values[track]; }
+    const float* Values() const { return values.data(); }
+    size_t Tracks() const { return tracks; }
+    size_t Keys() const { return used; }
+    float Duration() const { return duration; }
+    bool Done(float t) const { return !loop && t >= duration; }
+
+private:
+    //all tracks' keys back to back, track k is first[k]..last[k]
+    std::array<float, MAX_KEYS> time{};
+    std::array<float, MAX_KEYS> value{};
+    std::array<float, MAX_KEYS> inv_span{};     //1 / time to the next key, 0 for a track's last key
+    std::array<Ease, MAX_KEYS> eases{};
+    std::array<uint16_t, MAX_TRACKS> first{};
+    std::array<uint16_t, MAX_TRACKS> last{};
+    std::array<uint16_t, MAX_TRACKS> cursor{};
+    std::array<float, MAX_TRACKS> values{};
+    size_t tracks = 0;
+    size_t used = 0;
+    float duration = 0.f;
+    bool loop = false;
+
+    static_assert(MAX_KEYS <= 65536, "key indices are uint16_t");
+};
@@ -1,5 +1,3 @@
-#ifdef __aarch64__
-
 #include "ledcontrol.h"
 #include <iostream>
 #include <thread>
@@ -23,10 +21,8 @@ private:
     std::array<led_color_t, LED_COUNT> leds;
     
     void update_leds() {
-        char tx[LED_COUNT * 24] = {0};
-        for (int j = 0; j < LED_COUNT; j++) {
-            encode_color(this->leds[j], &tx[j * 24]);
-        }
+        char tx[LED_COUNT * WS2812B_BYTES_PER_LED];
+        encode_frame(leds.data(), LED_COUNT, tx);
         if(!spi.transfer(tx, sizeof(tx))) {
             puts("SPI transfer failed");
         }
@@ -135,11 +131,3 @@ int main(){
     std::cout << "\nWiFi symbol demo finished.\n";
     return 0;
 }
-
-#else
-#include <iostream>
-int main(){
-    std::cout << "LED control only supported on aarch64 platform.\n";
-    return 0;
-}
-#endif 
\ No newline at end of file
@@ -0,0 +1,431 @@
+#include "ws2812.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WS2812_X86 1
+#endif
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/*
+SIMD kernels for the frame encoder.
+
+all kernels do the same thing: reorder r,g,b to g,r,b, broadcast each channel
+byte over 8 lanes, test one bit per lane (lane 0 = bit 7) and select
+WS2812B_HIGH / WS2812B_LOW. whatever does not fill a full vector block is
+finished by the scalar table kernel.
+*/
+
+typedef void (*ws2812_encode_fn)(const uint8_t* rgb, size_t count, char* out);
+
+/*
+shuffle controls for the byte-select kernels. output byte j of the GRB stream
+comes from LED j / 3, channel swap[j % 3] of the packed r,g,b input.
+grb_select<V, W>: V vectors of W lanes, 8 lanes per channel byte, indexing
+the packed input directly.
+*/
+static constexpr uint8_t grb_swap[3] = {1, 0, 2};
+
+template <int V, int W>
+static constexpr std::array<std::array<uint8_t, W>, V> make_grb_select() {
+    std::array<std::array<uint8_t, W>, V> sel{};
+    for (int v = 0; v < V; v++) {
+        for (int lane = 0; lane < W; lane++) {
+            int j = v * (W / 8) + lane / 8;
+            sel[v][lane] = static_cast<uint8_t>((j / 3) * 3 + grb_swap[j % 3]);
+        }
+    }
+    return sel;
+}
+template <int V, int W>
+static constexpr std::array<std::array<uint8_t, W>, V> grb_select = make_grb_select<V, W>();
+
+static void encode_scalar(const uint8_t* rgb, size_t count, char* out) {
+    ws2812_encode_frame(rgb, count, out);
+}
+
+#ifdef WS2812_X86
+// per lane bit under test, lane 0 is the MSB
+static inline __m128i sse2_expand(__m128i bytes, __m128i bits, __m128i high_mask, __m128i low) {
+    __m128i set = _mm_cmpeq_epi8(_mm_and_si128(bytes, bits), bits);
+    return _mm_or_si128(_mm_and_si128(set, high_mask), low);
+}
+
+// 16 LEDs per block, sse2 has no byte shuffle so the GRB swap goes through a small staging copy
+static void encode_sse2(const uint8_t* rgb, size_t count, char* out) {
+    const __m128i bits = _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+    const __m128i high_mask = _mm_set1_epi8(WS2812B_HIGH ^ WS2812B_LOW);
+    const __m128i low = _mm_set1_epi8((char)WS2812B_LOW);
+    alignas(16) uint8_t grb[48];
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16, rgb += 48, out += 16 * WS2812B_BYTES_PER_LED) {
+        for (int j = 0; j < 16; j++) {
+            grb[j * 3] = rgb[j * 3 + 1];
+            grb[j * 3 + 1] = rgb[j * 3];
+            grb[j * 3 + 2] = rgb[j * 3 + 2];
+        }
+        char* dst = out;
+        for (int v = 0; v < 3; v++) {
+            __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(grb + v * 16));
+            __m128i lo8 = _mm_unpacklo_epi8(x, x);
+            __m128i hi8 = _mm_unpackhi_epi8(x, x);
+            __m128i q[4] = {
+                _mm_unpacklo_epi16(lo8, lo8), _mm_unpackhi_epi16(lo8, lo8),
+                _mm_unpacklo_epi16(hi8, hi8), _mm_unpackhi_epi16(hi8, hi8)
+            };
+            for (int k = 0; k < 4; k++) {
+                __m128i a = _mm_unpacklo_epi32(q[k], q[k]);
+                __m128i b = _mm_unpackhi_epi32(q[k], q[k]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), sse2_expand(a, bits, high_mask, low));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), sse2_expand(b, bits, high_mask, low));
+                dst += 32;
+            }
+        }
+    }
+    ws2812_encode_frame(rgb, count - i, out);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_expand(__m256i bytes, __m256i bits, __m256i high_mask, __m256i low) {
+    __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(bytes, bits), bits);
+    return _mm256_or_si256(_mm256_and_si256(set, high_mask), low);
+}
+
+// 4 LEDs (12 bytes) per step: one 16 byte load broadcast to both lanes, each
+// output vector shuffles 4 channel bytes, in GRB order, over 8 lanes
+__attribute__((target("avx2")))
+static void encode_avx2(const uint8_t* rgb, size_t count, char* out) {
+    const __m256i ctrl0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(grb_select<3, 32>[0].data()));
+    const __m256i ctrl1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(grb_select<3, 32>[1].data()));
+    const __m256i ctrl2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(grb_select<3, 32>[2].data()));
+    const __m256i bits = _mm256_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1,
+                                          -128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+    const __m256i high_mask = _mm256_set1_epi8(WS2812B_HIGH ^ WS2812B_LOW);
+    const __m256i low = _mm256_set1_epi8((char)WS2812B_LOW);
+
+    size_t i = 0;
+    // the 16 byte load reads 4 bytes past the block, keep it inside the frame
+    for (; i + 6 <= count; i += 4, rgb += 12, out += 4 * WS2812B_BYTES_PER_LED) {
+        __m256i src = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb)));
+        __m256i x0 = avx2_expand(_mm256_shuffle_epi8(src, ctrl0), bits, high_mask, low);
+        __m256i x1 = avx2_expand(_mm256_shuffle_epi8(src, ctrl1), bits, high_mask, low);
+        __m256i x2 = avx2_expand(_mm256_shuffle_epi8(src, ctrl2), bits, high_mask, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), x0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), x1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 64), x2);
+    }
+    ws2812_encode_frame(rgb, count - i, out);
+}
+#endif
+
+#ifdef __aarch64__
+// same as grb_select but indexing the vld3 table: r at 0..15, g at 16..31, b at 32..47
+static constexpr std::array<std::array<uint8_t, 16>, 24> make_neon_select() {
+    std::array<std::array<uint8_t, 16>, 24> sel{};
+    for (int v = 0; v < 24; v++) {
+        for (int lane = 0; lane < 16; lane++) {
+            int j = v * 2 + lane / 8;
+            sel[v][lane] = static_cast<uint8_t>(grb_swap[j % 3] * 16 + j / 3);
+        }
+    }
+    return sel;
+}
+static constexpr std::array<std::array<uint8_t, 16>, 24> neon_select = make_neon_select();
+
+// 16 LEDs per block: vld3 deinterleaves r,g,b into a 48 byte table, each of the
+// 24 output vectors picks 2 channel bytes (in GRB order) over 8 lanes each
+static void encode_neon(const uint8_t* rgb, size_t count, char* out) {
+    uint8x16_t idx[24];
+    for (int v = 0; v < 24; v++) idx[v] = vld1q_u8(neon_select[v].data());
+
+    static const uint8_t bit_bytes[16] = {128, 64, 32, 16, 8, 4, 2, 1, 128, 64, 32, 16, 8, 4, 2, 1};
+    const uint8x16_t bits = vld1q_u8(bit_bytes);
+    const uint8x16_t high = vdupq_n_u8(WS2812B_HIGH);
+    const uint8x16_t low = vdupq_n_u8(WS2812B_LOW);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16, rgb += 48, out += 16 * WS2812B_BYTES_PER_LED) {
+        uint8x16x3_t px = vld3q_u8(rgb);
+        for (int v = 0; v < 24; v++) {
+            uint8x16_t x = vqtbl3q_u8(px, idx[v]);
+            uint8x16_t set = vtstq_u8(x, bits);
+            vst1q_u8(reinterpret_cast<uint8_t*>(out) + v * 16, vbslq_u8(set, high, low));
+        }
+    }
+    ws2812_encode_frame(rgb, count - i, out);
+}
+#endif
+
+static const char* kernel_names[WS2812_KERNEL_MAX] = {"scalar", "sse2", "avx2", "neon"};
+
+const char* ws2812_kernel_name(ws2812_kernel kernel) {
+    if (kernel < 0 || kernel >= WS2812_KERNEL_MAX) return "unknown";
+    return kernel_names[kernel];
+}
+
+bool ws2812_kernel_supported(ws2812_kernel kernel) {
+    switch (kernel) {
+        case WS2812_KERNEL_SCALAR: return true;
+#ifdef WS2812_X86
+        case WS2812_KERNEL_SSE2: return __builtin_cpu_supports("sse2");
+        case WS2812_KERNEL_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+#ifdef __aarch64__
+        case WS2812_KERNEL_NEON: return true;
+#endif
+        default: return false;
+    }
+}
+
+static ws2812_encode_fn kernel_fn(ws2812_kernel kernel) {
+    switch (kernel) {
+#ifdef WS2812_X86
+        case WS2812_KERNEL_SSE2: return encode_sse2;
+        case WS2812_KERNEL_AVX2: return encode_avx2;
+#endif
+#ifdef __aarch64__
+        case WS2812_KERNEL_NEON: return encode_neon;
+#endif
+        default: return encode_scalar;
+    }
+}
+
+// sse2 has to unpack its way to the broadcast and loses to the table kernel
+// (see bench_encoder), so it is only used when asked for by name
+static ws2812_kernel pick_kernel() {
+    const char* env = getenv("WS2812_KERNEL");
+    if (env) {
+        for (int k = 0; k < WS2812_KERNEL_MAX; k++) {
+            if (strcmp(env, kernel_names[k]) == 0 && ws2812_kernel_supported((ws2812_kernel)k))
+                return (ws2812_kernel)k;
+        }
+    }
+    if (ws2812_kernel_supported(WS2812_KERNEL_NEON)) return WS2812_KERNEL_NEON;
+    if (ws2812_kernel_supported(WS2812_KERNEL_AVX2)) return WS2812_KERNEL_AVX2;
+    return WS2812_KERNEL_SCALAR;
+}
+
+ws2812_kernel ws2812_active_kernel() {
+    static const ws2812_kernel active = pick_kernel();
+    return active;
+}
+
+void ws2812_encode_with(ws2812_kernel kernel, const uint8_t* rgb, size_t count, char* out) {
+    if (!ws2812_kernel_supported(kernel)) kernel = WS2812_KERNEL_SCALAR;
+    kernel_fn(kernel)(rgb, count, out);
+}
+
+void ws2812_encode(const uint8_t* rgb, size_t count, char* out) {
+    static const ws2812_encode_fn fn = kernel_fn(ws2812_active_kernel());
+    fn(rgb, count, out);
+}
+
+uint8_t ws2812_correct(uint8_t v, float gamma, float gain, float brightness) {
+    // gamma 1 stays exact integer scaling, pow() would round v down by one
+    float lin = gamma == 1.f ? v : 255.f * std::pow(v / 255.f, gamma);
+    return static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, lin * gain * brightness)));
+}
+
+ws2812_calibration ws2812_build_calibration(float gamma, float brightness,
+                                            const float* slot_gain, size_t slots,
+                                            const uint8_t* led_slot, size_t count) {
+    ws2812_calibration cal;
+    cal.identity = gamma == 1.f && brightness == 1.f;
+    for (size_t s = 0; s < slots; s++) cal.identity = cal.identity && slot_gain[s] == 1.f;
+    if (cal.identity) return cal;
+
+    cal.tables.resize(slots ? slots : 1);
+    cal.values.resize(cal.tables.size());
+    for (size_t s = 0; s < cal.tables.size(); s++) {
+        float gain = slots ? slot_gain[s] : 1.f;
+        for (int v = 0; v < 256; v++) {
+            cal.values[s][v] = ws2812_correct(static_cast<uint8_t>(v), gamma, gain, brightness);
+            cal.tables[s][v] = ws2812_lut[cal.values[s][v]];
+        }
+    }
+    cal.led_slot.assign(led_slot, led_slot + count);
+    for (auto& slot : cal.led_slot) {
+        if (slot >= cal.tables.size()) slot = 0;
+        if (!cal.runs.empty() && cal.runs.back().first == slot) cal.runs.back().second++;
+        else cal.runs.push_back({slot, 1});
+    }
+    return cal;
+}
+
+// same loop as ws2812_encode_frame, one table per run of LEDs in a slot
+static void encode_run(const uint64_t* t, const uint8_t* rgb, size_t count, char* out) {
+    for (size_t i = 0; i < count; i++, rgb += 3, out += WS2812B_BYTES_PER_LED) {
+        const uint64_t g = t[rgb[1]];
+        const uint64_t r = t[rgb[0]];
+        const uint64_t b = t[rgb[2]];
+        memcpy(out, &g, 8);
+        memcpy(out + 8, &r, 8);
+        memcpy(out + 16, &b, 8);
+    }
+}
+
+// SIMD kernels can't index a table per slot: remap a chunk of the run through
+// the slot's corrected values on the stack, then expand it with the kernel
+static void remap_run(ws2812_encode_fn fn, const uint8_t* values, const uint8_t* rgb, size_t count, char* out) {
+    uint8_t chunk[256 * 3];
+    while (count) {
+        size_t n = std::min(count, sizeof(chunk) / 3);
+        for (size_t i = 0; i < n * 3; i += 3) {
+            const uint8_t r = values[rgb[i]], g = values[rgb[i + 1]], b = values[rgb[i + 2]];
+            chunk[i] = r;
+            chunk[i + 1] = g;
+            chunk[i + 2] = b;
+        }
+        fn(chunk, n, out);
+        rgb += n * 3;
+        out += n * WS2812B_BYTES_PER_LED;
+        count -= n;
+    }
+}
+
+static void encode_calibrated(ws2812_encode_fn fn, const ws2812_calibration& cal, const uint8_t* rgb, size_t count, char* out) {
+    if (cal.identity) {
+        fn(rgb, count, out);
+        return;
+    }
+    auto run_fn = [&](uint8_t slot, const uint8_t* in, size_t n, char* dst) {
+        if (fn == encode_scalar) encode_run(cal.tables[slot].data(), in, n, dst);
+        else remap_run(fn, cal.values[slot].data(), in, n, dst);
+    };
+    size_t done = 0;
+    for (auto& run : cal.runs) {
+        size_t n = std::min(run.second, count - done);
+        run_fn(run.first, rgb + done * 3, n, out + done * WS2812B_BYTES_PER_LED);
+        done += n;
+        if (done == count) return;
+    }
+    run_fn(0, rgb + done * 3, count - done, out + done * WS2812B_BYTES_PER_LED);
+}
+
+void ws2812_encode_calibrated_with(ws2812_kernel kernel, const ws2812_calibration& cal,
+                                   const uint8_t* rgb, size_t count, char* out) {
+    if (!ws2812_kernel_supported(kernel)) kernel = WS2812_KERNEL_SCALAR;
+    encode_calibrated(kernel_fn(kernel), cal, rgb, count, out);
+}
+
+// the remap pass costs more than the SIMD expansion saves, the slot tables
+// beat remap + avx2 by ~2x on x86 (see bench_encoder), so a calibrated frame
+// takes the tables whatever kernel is active, like sse2 for plain frames
+void ws2812_encode_calibrated(const ws2812_calibration& cal, const uint8_t* rgb, size_t count, char* out) {
+    if (cal.identity) ws2812_encode(rgb, count, out);
+    else encode_calibrated(encode_scalar, cal, rgb, count, out);
+}
+
+/*
+dense encodings: each channel byte becomes 8 symbols of BITS bits = BITS bytes,
+looked up whole from a 256 entry table (bytes in memory order in the low
+BITS bytes of the word), so a LED is still 3 loads + 3 stores.
+*/
+static const ws2812_encoding_t encodings[WS2812_ENCODING_MAX] = {
+    {"8bit", WS2812B_SPI_SPEED, 8, WS2812B_HIGH, WS2812B_LOW, WS2812B_BYTES_PER_LED, true},
+    {"4bit", 3200000, 4, 0b1110, 0b1000, 12, false},
+    {"3bit", 2400000, 3, 0b110, 0b100, 9, false},
+};
+
+const ws2812_encoding_t& ws2812_encoding_params(ws2812_encoding encoding) {
+    return encodings[encoding < WS2812_ENCODING_MAX ? encoding : WS2812_ENCODING_8BIT];
+}
+
+template <int BITS>
+static constexpr std::array<uint32_t, 256> make_dense_lut(uint8_t one, uint8_t zero) {
+    std::array<uint32_t, 256> lut{};
+    for (int v = 0; v < 256; v++) {
+        uint32_t stream = 0;
+        for (int bit = 7; bit >= 0; bit--)
+            stream = (stream << BITS) | ((v >> bit) & 1 ? one : zero);
+        uint32_t word = 0;
+        for (int k = 0; k < BITS; k++)
+            word |= ((stream >> (8 * (BITS - 1 - k))) & 0xff) << (8 * k);
+        lut[v] = word;
+    }
+    return lut;
+}
+
+static constexpr std::array<uint32_t, 256> lut_4bit = make_dense_lut<4>(0b1110, 0b1000);
+static constexpr std::array<uint32_t, 256> lut_3bit = make_dense_lut<3>(0b110, 0b100);
+
+// values maps each channel byte first (calibration), nullptr encodes it as is
+template <int BITS>
+static void encode_dense(const std::array<uint32_t, 256>& lut, const uint8_t* values,
+                         const uint8_t* rgb, size_t count, char* out) {
+    for (size_t i = 0; i < count; i++, rgb += 3, out += 3 * BITS) {
+        uint8_t g = rgb[1], r = rgb[0], b = rgb[2];
+        if (values) { g = values[g]; r = values[r]; b = values[b]; }
+        const uint32_t wg = lut[g], wr = lut[r], wb = lut[b];
+        memcpy(out, &wg, BITS);
+        memcpy(out + BITS, &wr, BITS);
+        memcpy(out + 2 * BITS, &wb, BITS);
+    }
+}
+
+static void encode_dense_as(ws2812_encoding encoding, const uint8_t* values, const uint8_t* rgb, size_t count, char* out) {
+    if (encoding == WS2812_ENCODING_4BIT) encode_dense<4>(lut_4bit, values, rgb, count, out);
+    else encode_dense<3>(lut_3bit, values, rgb, count, out);
+}
+
+void ws2812_encode_as(ws2812_encoding encoding, const uint8_t* rgb, size_t count, char* out) {
+    if (encoding == WS2812_ENCODING_4BIT || encoding == WS2812_ENCODING_3BIT)
+        encode_dense_as(encoding, nullptr, rgb, count, out);
+    else
+        ws2812_encode(rgb, count, out);
+}
+
+void ws2812_encode_calibrated(const ws2812_calibration& cal, ws2812_encoding encoding,
+                              const uint8_t* rgb, size_t count, char* out) {
+    if (encoding != WS2812_ENCODING_4BIT && encoding != WS2812_ENCODING_3BIT) {
+        ws2812_encode_calibrated(cal, rgb, count, out);
+        return;
+    }
+    if (cal.identity) {
+        encode_dense_as(encoding, nullptr, rgb, count, out);
+        return;
+    }
+    const size_t stride = ws2812_encoding_params(encoding).bytes_per_led;
+    size_t done = 0;
+    for (auto& run : cal.runs) {
+        size_t n = std::min(run.second, count - done);
+        encode_dense_as(encoding, cal.values[run.first].data(), rgb + done * 3, n, out + done * stride);
+        done += n;
+        if (done == count) return;
+    }
+    encode_dense_as(encoding, cal.values[0].data(), rgb + done * 3, count - done, out + done * stride);
+}
+
+bool ws2812_decode(ws2812_encoding encoding, const char* in, size_t len, uint8_t* rgb) {
+    const ws2812_encoding_t& e = ws2812_encoding_params(encoding);
+    const size_t count = len / e.bytes_per_led;
+    const uint8_t mask = static_cast<uint8_t>((1u << e.bits) - 1);
+    size_t pos = 0;  // bit position in the stream, MSB of in[0] first
+    auto symbol = [&]() {
+        uint8_t sym = 0;
+        for (int k = 0; k < e.bits; k++, pos++)
+            sym = static_cast<uint8_t>((sym << 1) | ((static_cast<uint8_t>(in[pos / 8]) >> (7 - pos % 8)) & 1));
+        return static_cast<uint8_t>(sym & mask);
+    };
+    for (size_t i = 0; i < count; i++) {
+        uint8_t grb[3];
+        for (auto& channel : grb) {
+            channel = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                uint8_t sym = symbol();
+                if (sym != e.one && sym != e.zero) return false;
+                channel = static_cast<uint8_t>((channel << 1) | (sym == e.one));
+            }
+        }
+        rgb[i * 3] = grb[1];
+        rgb[i * 3 + 1] = grb[0];
+        rgb[i * 3 + 2] = grb[2];
+    }
+    return true;
+}
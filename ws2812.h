@@ -0,0 +1,168 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+/*
+WS2812B wire encoding over SPI.
+
+every WS2812 data bit is sent as one SPI byte (WS2812B_HIGH / WS2812B_LOW) at
+WS2812B_SPI_SPEED, so one LED is 24 bytes on the bus in G,R,B order, MSB first.
+
+the frame encoder expands each channel byte through a 256 entry table where
+every entry holds the 8 SPI bytes for that value packed in one 64-bit word,
+so a whole frame is 3 table loads + 3 stores per LED with no per-bit branches.
+
+ws2812_encode() runs the same expansion through a SIMD kernel (NEON on
+aarch64, SSE2/AVX2 on x86_64) picked once at runtime, see ws2812.cc.
+
+ws2812_encode_calibrated() folds gamma, brightness and per LED gains into
+the tables themselves, see ws2812_calibration below.
+
+the dense encodings (ws2812_encoding below) pack 4 or 3 SPI bits per WS2812
+bit instead of a whole byte, for 12 or 9 bytes per LED.
+*/
+
+#define WS2812B_SPI_SPEED 2500000
+#define WS2812B_HIGH 0b11100000  //  WS2812 "1"
+#define WS2812B_LOW  0b10000000  //  WS2812 "0"
+#define WS2812B_BYTES_PER_LED 24
+
+#if !defined(__BYTE_ORDER__) || (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "ws2812 lut is laid out for little endian hosts"
+#endif
+
+// reference encoder, one branch per bit
+inline void encode_color(uint8_t r, uint8_t g, uint8_t b, char* buffer) {
+    for (int i = 0; i < 8; i++) {
+        buffer[i] = (g & (1 << (7 - i))) ? WS2812B_HIGH : WS2812B_LOW;
+        buffer[8 + i] = (r & (1 << (7 - i))) ? WS2812B_HIGH : WS2812B_LOW;
+        buffer[16 + i] = (b & (1 << (7 - i))) ? WS2812B_HIGH : WS2812B_LOW;
+    }
+}
+
+// byte i of the word (in memory order) is the symbol for bit (7 - i)
+constexpr uint64_t ws2812_pattern(uint8_t value) {
+    uint64_t word = 0;
+    for (int i = 0; i < 8; i++) {
+        uint64_t sym = (value & (1 << (7 - i))) ? WS2812B_HIGH : WS2812B_LOW;
+        word |= sym << (8 * i);
+    }
+    return word;
+}
+
+constexpr std::array<uint64_t, 256> ws2812_build_lut() {
+    std::array<uint64_t, 256> lut{};
+    for (int v = 0; v < 256; v++)
+        lut[v] = ws2812_pattern(static_cast<uint8_t>(v));
+    return lut;
+}
+
+inline constexpr std::array<uint64_t, 256> ws2812_lut = ws2812_build_lut();
+
+// rgb points at `count` packed r,g,b triplets, out must hold count * 24 bytes
+inline void ws2812_encode_frame(const uint8_t* rgb, size_t count, char* out) {
+    for (size_t i = 0; i < count; i++, rgb += 3, out += WS2812B_BYTES_PER_LED) {
+        const uint64_t g = ws2812_lut[rgb[1]];
+        const uint64_t r = ws2812_lut[rgb[0]];
+        const uint64_t b = ws2812_lut[rgb[2]];
+        memcpy(out, &g, 8);
+        memcpy(out + 8, &r, 8);
+        memcpy(out + 16, &b, 8);
+    }
+}
+
+enum ws2812_kernel : int {
+    WS2812_KERNEL_SCALAR = 0,
+    WS2812_KERNEL_SSE2,
+    WS2812_KERNEL_AVX2,
+    WS2812_KERNEL_NEON,
+    WS2812_KERNEL_MAX
+};
+
+const char* ws2812_kernel_name(ws2812_kernel kernel);
+bool ws2812_kernel_supported(ws2812_kernel kernel);
+// kernel used by ws2812_encode(): neon or avx2 when available, else scalar.
+// WS2812_KERNEL=scalar|sse2|avx2|neon in the environment overrides it
+ws2812_kernel ws2812_active_kernel();
+
+// encodes with one specific kernel, falls back to scalar if it is unsupported
+void ws2812_encode_with(ws2812_kernel kernel, const uint8_t* rgb, size_t count, char* out);
+// encodes with the active kernel
+void ws2812_encode(const uint8_t* rgb, size_t count, char* out);
+
+/*
+symbol encodings. each WS2812 bit goes out as `bits` SPI bits, MSB first:
+  8 bit  2.5 MHz  1 = 11100000  0 = 10000000  24 bytes/LED  (the tables above)
+  4 bit  3.2 MHz  1 = 1110      0 = 1000      12 bytes/LED  312.5 ns per SPI bit
+  3 bit  2.4 MHz  1 = 110       0 = 100        9 bytes/LED  416.7 ns per SPI bit
+all three keep the 1.25 us bit period or longer, with T0H / T1H inside the
+WS2812B windows. the dense ones cross byte boundaries, so unlike the 8 bit
+symbols they need the bus to shift MSB first (lsb_first = false).
+*/
+enum ws2812_encoding : int {
+    WS2812_ENCODING_8BIT = 0,
+    WS2812_ENCODING_4BIT,
+    WS2812_ENCODING_3BIT,
+    WS2812_ENCODING_MAX
+};
+
+struct ws2812_encoding_t {
+    const char* name;
+    uint32_t spi_speed;     // SPI clock the symbol timings assume
+    uint8_t bits;           // SPI bits per WS2812 bit
+    uint8_t one, zero;      // the symbols, right aligned in `bits` bits
+    size_t bytes_per_led;
+    bool lsb_first;         // spidev bit order to configure
+};
+
+const ws2812_encoding_t& ws2812_encoding_params(ws2812_encoding encoding);
+inline size_t ws2812_frame_bytes(ws2812_encoding encoding, size_t count) {
+    return ws2812_encoding_params(encoding).bytes_per_led * count;
+}
+
+// out must hold ws2812_frame_bytes(encoding, count) bytes, 8 bit goes through ws2812_encode()
+void ws2812_encode_as(ws2812_encoding encoding, const uint8_t* rgb, size_t count, char* out);
+
+// software decoder for tests and captures: len / bytes_per_led LEDs go to rgb,
+// false if any symbol is neither a 1 nor a 0
+bool ws2812_decode(ws2812_encoding encoding, const char* in, size_t len, uint8_t* rgb);
+
+/*
+output calibration. every LED belongs to a slot (a ring, or a single LED) and
+each slot gets its own 256 entry symbol table with gamma, the global
+brightness and the slot gain already applied, so a calibrated frame is still
+3 table loads + 3 stores per LED with no extra pass over the pixels.
+only an identity calibration takes the SIMD kernel: the SIMD kernels can
+only encode a calibrated frame after a remap pass through the corrected
+values, which loses to the tables (bench_encoder, cal-* rows).
+*/
+struct ws2812_calibration {
+    std::vector<std::array<uint64_t, 256>> tables;  // [slot][value], shared by r, g and b
+    std::vector<std::array<uint8_t, 256>> values;   // [slot][value] corrected, for the dense encodings
+    std::vector<uint8_t> led_slot;                  // slot of each LED, missing LEDs use slot 0
+    std::vector<std::pair<uint8_t, size_t>> runs;   // led_slot as (slot, length) runs
+    bool identity = true;
+};
+
+// 255 * (v / 255)^gamma * gain * brightness, truncated and clamped like
+// led_color_t::operator*
+uint8_t ws2812_correct(uint8_t v, float gamma, float gain, float brightness);
+
+// slot_gain holds one gain per slot, led_slot one slot index per LED
+ws2812_calibration ws2812_build_calibration(float gamma, float brightness,
+                                            const float* slot_gain, size_t slots,
+                                            const uint8_t* led_slot, size_t count);
+
+// slot tables, or the active kernel for an identity calibration
+void ws2812_encode_calibrated(const ws2812_calibration& cal, const uint8_t* rgb, size_t count, char* out);
+// with one specific kernel: scalar uses the slot tables, the SIMD kernels
+// remap each slot's run in stack chunks and expand that
+void ws2812_encode_calibrated_with(ws2812_kernel kernel, const ws2812_calibration& cal,
+                                   const uint8_t* rgb, size_t count, char* out);
+// same through one of the dense encodings, the corrected value picks the symbols
+void ws2812_encode_calibrated(const ws2812_calibration& cal, ws2812_encoding encoding,
+                              const uint8_t* rgb, size_t count, char* out);